@@ -117,6 +117,9 @@ let package = Package(
             cxxSettings: [
                 .define("CXX_STANDARD", to: "17"),
                 .unsafeFlags(["-std=c++17"], .when(platforms: [.macOS, .iOS]))
+            ],
+            linkerSettings: [
+                .linkedLibrary("xml2")
             ]
         ),
         
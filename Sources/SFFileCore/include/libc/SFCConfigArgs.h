@@ -0,0 +1,82 @@
+//===-- libc/fs/SFCConfigArgs.h - config arguments ----------------*- C -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines `ConfigArgs`, the typed form of an archive's configuration file,
+/// and its conversion to and from the configuration document.
+///
+/// The conversion is implemented in `libcxx/ConfigBinding` with compile-time
+/// field descriptors (see `SFCxxJSONBinding.h`): it writes and reads the
+/// document directly, without creating any JSON variants.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCConfigArgs_h
+#define SFCConfigArgs_h
+
+#include <stddef.h>
+
+#include "SFCJSON.h"
+
+/// \brief Represents the configuration arguments for a file.
+///
+/// This struct contains various properties related to a file's configuration, such as its name, author, creation date, etc.
+/// It is used to store and retrieve information about a file's configuration.
+typedef struct {
+    char name[256];                 ///< The name of the file.
+    char author[256];               ///< The author of the file.
+    char created_at[256];           ///< The creation date of the file.
+    char last_changed_at[256];      ///< The last change date of the file.
+    char editor_version[256];       ///< The version of the editor used for the file.
+    char encoding[256];             ///< The encoding used for the file.
+    char line_endings[256];         ///< The line endings used in the file.
+    int psw_pr;                     ///< The password protection level of the file.
+    char encryption_method[256];    ///< The encryption method used for the file.
+    int is_Favorite;                ///< Indicates whether the file is marked as a favorite.
+} ConfigArgs;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// \brief Writes `configArgs` as a configuration document into `builder`.
+///
+/// \param configArgs The configuration to write.
+/// \param builder An initialized builder; see `json_builder_init`.
+/// \return The length of the document, or -1 if it could not be written. On success
+///         `builder->data` holds the null-terminated JSON text.
+long encodeConfigArgs(const ConfigArgs* configArgs, JSONBuilder* builder);
+
+/// \brief Reads a configuration document into `configArgs`.
+///
+/// Members missing from the document leave the corresponding fields unchanged;
+/// strings longer than a field are truncated.
+///
+/// \param data The document, as JSON text or CBOR. It does not need to be null-terminated.
+/// \param length The number of bytes in `data`.
+/// \param configArgs Receives the configuration.
+/// \return 0 on success, or -1 if the document is malformed or a member has the wrong type.
+int decodeConfigArgs(const char* data, size_t length, ConfigArgs* configArgs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SFCConfigArgs_h */
@@ -49,6 +49,7 @@
 
 #include "SFCXML.h"
 #include "SFCJSON.h"
+#include "SFCConfigArgs.h"
 
 #include "fssec.h"
 #include "keychh.h"
@@ -78,23 +79,6 @@
     return NULL;                                   \
 }
 
-/// \brief Represents the configuration arguments for a file.
-///
-/// This struct contains various properties related to a file's configuration, such as its name, author, creation date, etc.
-/// It is used to store and retrieve information about a file's configuration.
-typedef struct {
-    char name[256];                 ///< The name of the file.
-    char author[256];               ///< The author of the file.
-    char created_at[256];           ///< The creation date of the file.
-    char last_changed_at[256];      ///< The last change date of the file.
-    char editor_version[256];       ///< The version of the editor used for the file.
-    char encoding[256];             ///< The encoding used for the file.
-    char line_endings[256];         ///< The line endings used in the file.
-    int psw_pr;                     ///< The password protection level of the file.
-    char encryption_method[256];    ///< The encryption method used for the file.
-    int is_Favorite;                ///< Indicates whether the file is marked as a favorite.
-} ConfigArgs;
-
 static ConfigArgs g_configArgs;
 
 /// \brief Sets the configuration data for the current file.
@@ -127,68 +111,19 @@ const ConfigArgs* getConfigData(void) {
 
 /// \brief Writes a JSON boilerplate for ScribbleLab files.
 ///
-/// This function generates a JSON boilerplate with default values for ScribbleLab files.
+/// This function generates a JSON boilerplate with the current configuration data for ScribbleLab files.
 /// The boilerplate includes fields such as name, author, created_at, last_changed_at,
 /// editor_version, encoding, line_endings, psw_pr, encryption_method, and is_Favorite.
 ///
-/// \return A JSONVariant object representing the JSON boilerplate.
-///         The caller is responsible for managing the memory of the returned JSONVariant.
-JSONVariant writeJSONBoilerPlate(void) {
-    const ConfigArgs* configArgs = getConfigData();
-    
-    JSONVariant project = json_create_object();
-    CHECK_NULL(project);
-    json_set_string(project, "name", configArgs->name);
-    json_set_string(project, "author", configArgs->author);
-    json_set_string(project, "created_at", configArgs->created_at);
-    json_set_string(project, "last_changed_at", configArgs->last_changed_at);
-    json_set_string(project, "editor_version", configArgs->editor_version);
-
-    JSONVariant document_settings = json_create_object();
-    CHECK_NULL(document_settings);
-    json_set_string(document_settings, "encoding", configArgs->encoding);
-    json_set_string(document_settings, "line_endings", configArgs->line_endings);
-
-    JSONVariant security = json_create_object();
-    CHECK_NULL(security);
-    json_set_boolean(security, "password_protected", configArgs->psw_pr);
-    json_set_string(security, "encryption_method", configArgs->encryption_method);
-
-    JSONVariant flags = json_create_object();
-    CHECK_NULL(flags);
-    json_set_boolean(flags, "is_Favorite", configArgs->is_Favorite);
-
-    JSONVariant references = json_create_object();
-    CHECK_NULL(references);
-
-    JSONVariant images = json_create_array();
-    CHECK_NULL(images);
-
-    JSONVariant text_files = json_create_array();
-    CHECK_NULL(text_files);
-
-    JSONVariant temporary = json_create_array();
-    CHECK_NULL(temporary);
-
-    JSONVariant root = json_create_object();
-    CHECK_NULL(root);
-    json_set_object(root, "project", project);
-    json_set_object(root, "document_settings", document_settings);
-    json_set_object(root, "security", security);
-    json_set_object(root, "flags", flags);
-    json_set_object(root, "references", references);
-
-    // Free individual JSON variants if necessary
-    // free_json(project);
-    // free_json(document_settings);
-    // free_json(security);
-    // free_json(flags);
-    // free_json(references);
-    // free_json(images);
-    // free_json(text_files);
-    // free_json(temporary);
-
-    return root;
+/// The document is written straight into `builder` through the compile-time
+/// binding of `ConfigArgs`; no JSON variants are created. See `readConfigArgs`
+/// for the reverse direction.
+///
+/// \param builder An initialized builder; see `json_builder_init`.
+/// \return The length of the document, or -1 if it could not be written. On success
+///         `builder->data` holds the null-terminated JSON text.
+long writeJSONBoilerPlate(JSONBuilder* builder) {
+    return encodeConfigArgs(getConfigData(), builder);
 }
 
 #ifdef __cplusplus
@@ -282,6 +217,65 @@ int openScribbleArchive(const char* archivePath, int flags);
 ///         SFC_ERR_PERMISSION_DENIED (-4) if permission is denied, SFC_ERR_WRITE (-9) on write failure
 int writeConfigFile(const char* archivePath, const char* filePath, const char* jsonContent);
 
+/// Encodes a JSON variant straight into the specified configuration file within the .scribble archive.
+///
+/// Unlike encoding with `json_encode` and calling `writeConfigFile`, the JSON text is streamed
+/// to the file in fixed-size chunks and never held in memory as a whole.
+///
+/// \param archivePath The path to the .scribble archive.
+/// \param filePath The path to the configuration file within the archive.
+/// \param json The JSON variant to write.
+/// \return 0 on success, SFC_ERR_IO (-7) if the file cannot be opened, SFC_ERR_WRITE (-9) on write failure
+int writeConfigJSON(const char* archivePath, const char* filePath, JSONVariant json);
+
+/// Encodes a JSON variant as CBOR into the specified configuration file within the .scribble archive.
+///
+/// CBOR holds the same data as JSON text in a smaller file that is decoded without parsing
+/// text. `readConfigJSON` reads configuration files in either format.
+///
+/// \param archivePath The path to the .scribble archive.
+/// \param filePath The path to the configuration file within the archive.
+/// \param json The JSON variant to write.
+/// \return 0 on success, SFC_ERR_IO (-7) if the file cannot be opened, SFC_ERR_WRITE (-9) on write failure
+int writeConfigCBOR(const char* archivePath, const char* filePath, JSONVariant json);
+
+/// Reads and decodes the specified configuration file within the .scribble archive.
+///
+/// The file may hold JSON text or CBOR written by `writeConfigCBOR`; the format is detected
+/// from its first bytes.
+///
+/// \param archivePath The path to the .scribble archive.
+/// \param filePath The path to the configuration file within the archive.
+/// \return The decoded JSON variant, or NULL if the file cannot be read or is malformed.
+///         The caller is responsible for freeing it using `free_json`.
+JSONVariant readConfigJSON(const char* archivePath, const char* filePath);
+
+/// Reads the specified configuration file within the .scribble archive straight into a `ConfigArgs`.
+///
+/// The file may hold JSON text or CBOR. No JSON variants are created; see `decodeConfigArgs`.
+///
+/// \param archivePath The path to the .scribble archive.
+/// \param filePath The path to the configuration file within the archive.
+/// \param configArgs Receives the configuration. Fields missing from the file are left unchanged.
+/// \return 0 on success, SFC_ERR_IO (-7) if the file cannot be opened, SFC_ERR_READ (-8) if it
+///         cannot be read or is malformed
+int readConfigArgs(const char* archivePath, const char* filePath, ConfigArgs* configArgs);
+
+/// Applies a JSON Patch to the specified configuration file within the .scribble archive.
+///
+/// The archive is decrypted and encrypted once for the whole patch, so several edits, such as
+/// toggling `is_Favorite` and updating `last_changed_at`, are committed together by appending
+/// them to one patch. JSON files are edited in place without being decoded; see
+/// `json_patch_apply_buffer`. If any operation fails, the file is left unchanged.
+///
+/// \param archivePath The path to the .scribble archive.
+/// \param filePath The path to the configuration file within the archive.
+/// \param patch The edits to apply.
+/// \return 0 on success, SFC_ERR_IO (-7) if the file cannot be opened, SFC_ERR_READ (-8) or
+///         SFC_ERR_WRITE (-9) on I/O failure, SFC_ERR_INVALID_ARGS (-6) if the file is malformed
+///         or an operation fails
+int patchConfigFile(const char* archivePath, const char* filePath, JSONPatch patch);
+
 /// Reads the JSON content from the specified configuration file within the .scribble archive.
 ///
 /// \param archivePath The path to the .scribble archive.
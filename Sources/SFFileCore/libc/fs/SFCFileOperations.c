@@ -30,10 +30,24 @@
 
 #include "SFCFileOperations.h"
 
+/// Template for the temporary file an archive is decrypted into, completed by `mkstemp`.
+#define SFC_ARCHIVE_TEMP_TEMPLATE "/tmp/scribble_archive_XXXXXX"
+
 static ConfigArgs g_configArgs;
 
 #pragma mark - Helper functions start
 
+/// Decrypts the archive into a new temporary file and stores its path in `tempPath`.
+static int decryptArchiveToTemp(const char* archivePath, char tempPath[sizeof(SFC_ARCHIVE_TEMP_TEMPLATE)]) {
+    memcpy(tempPath, SFC_ARCHIVE_TEMP_TEMPLATE, sizeof(SFC_ARCHIVE_TEMP_TEMPLATE));
+    if (decryptScribbleArchive(archivePath, tempPath) != 0) {
+        perror("Failed to decrypt archive - SF_ERR_DECR");
+        return SF_ERR_DECR;
+    }
+
+    return SFC_SUCCESS;
+}
+
 int createDirectory(const char* path) {
     if (mkdir(path, 0777) != 0) {
         if (errno == EEXIST) {
@@ -55,20 +69,25 @@ int initConfigFile(const char* archivePath, const char* filePath) {
         return openResult;
     }
 
-    char* jsonContent = writeJSONBoilerPlate();
-    if (jsonContent == NULL) {
+    // The boilerplate is encoded straight into this buffer; it only moves to the heap
+    // if the config fields are unusually long.
+    char jsonStorage[2048];
+    JSONBuilder builder;
+    json_builder_init(&builder, jsonStorage, sizeof(jsonStorage), 1);
+
+    if (writeJSONBoilerPlate(&builder) < 0) {
         perror("An error occurred while generating JSON content - SFC_ERR_IO");
+        json_builder_free(&builder);
         return SFC_ERR_IO;
     }
 
-    int writeResult = writeConfigFile(archivePath, filePath, jsonContent);
+    int writeResult = writeConfigFile(archivePath, filePath, builder.data);
+    json_builder_free(&builder);
     if (writeResult != SFC_SUCCESS) {
         perror("An error occurred while writing to config file - SFC_ERR_WRITE");
         return writeResult;
     }
 
-    free(jsonContent);
-
     return SFC_SUCCESS;
 }
 
@@ -277,11 +296,10 @@ int openScribbleArchive(const char* archivePath, int flags) {
 }
 
 int writeConfigFile(const char* archivePath, const char* filePath, const char* jsonContent) {
-    char tempPath[] = "/tmp/scribble_archive_xxxx"; // TODO: Change path
-
-    if (decryptScribbleArchive(archivePath, tempPath) != 0) {
-        perror("Failed to decrypt archive - SF_ERR_DECR");
-        return SF_ERR_DECR;
+    char tempPath[sizeof(SFC_ARCHIVE_TEMP_TEMPLATE)];
+    int decryptResult = decryptArchiveToTemp(archivePath, tempPath);
+    if (decryptResult != SFC_SUCCESS) {
+        return decryptResult;
     }
 
     FILE* configFile = fopen(filePath, "w");
@@ -290,7 +308,8 @@ int writeConfigFile(const char* archivePath, const char* filePath, const char* j
         return SFC_ERR_IO;
     }
 
-    if (fwrite(jsonContent, sizeof(char), strlen(jsonContent), configFile) != strlen(jsonContent)) {
+    size_t contentLength = strlen(jsonContent);
+    if (fwrite(jsonContent, sizeof(char), contentLength, configFile) != contentLength) {
         perror("An error occurred while writing to the config file - SFC_ERR_WRITE");
         fclose(configFile);
         return SFC_ERR_WRITE;
@@ -305,6 +324,204 @@ int writeConfigFile(const char* archivePath, const char* filePath, const char* j
     return SFC_SUCCESS;
 }
 
+/// Encodes `json` into the config file with `encode`, which writes to a file descriptor.
+static int writeConfigWith(const char* archivePath, const char* filePath,
+                           int (*encode)(JSONVariant, int), JSONVariant json) {
+    char tempPath[sizeof(SFC_ARCHIVE_TEMP_TEMPLATE)];
+    int decryptResult = decryptArchiveToTemp(archivePath, tempPath);
+    if (decryptResult != SFC_SUCCESS) {
+        return decryptResult;
+    }
+
+    int fd = open(filePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        perror("An error occurred while opening the config file - SFC_ERR_IO");
+        return SFC_ERR_IO;
+    }
+
+    if (encode(json, fd) != 0) {
+        perror("An error occurred while writing to the config file - SFC_ERR_WRITE");
+        close(fd);
+        return SFC_ERR_WRITE;
+    }
+
+    close(fd);
+
+    if (encryptScribbleArchive(archivePath, tempPath) != 0) {
+        return SF_ERR_ENCR;
+    }
+
+    return SFC_SUCCESS;
+}
+
+int writeConfigJSON(const char* archivePath, const char* filePath, JSONVariant json) {
+    return writeConfigWith(archivePath, filePath, json_encode_to_fd, json);
+}
+
+int writeConfigCBOR(const char* archivePath, const char* filePath, JSONVariant json) {
+    return writeConfigWith(archivePath, filePath, json_encode_cbor_to_fd, json);
+}
+
+/// Reads the whole configuration file into a buffer that the caller frees.
+static char* readConfigContent(const char* archivePath, const char* filePath, size_t* length) {
+    if (archivePath == NULL || filePath == NULL) {
+        perror("Invalid archive path - SFC_ERR_FILE_NOT_FOUND");
+        return NULL;
+    }
+
+    char tempPath[sizeof(SFC_ARCHIVE_TEMP_TEMPLATE)];
+    if (decryptArchiveToTemp(archivePath, tempPath) != SFC_SUCCESS) {
+        return NULL;
+    }
+
+    int fd = open(filePath, O_RDONLY);
+    if (fd == -1) {
+        perror("Failed to open config file - SF_ERR_IO");
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        perror("Failed to read config file content - SF_ERR_READ");
+        close(fd);
+        return NULL;
+    }
+
+    size_t fileSize = (size_t)info.st_size;
+    char* content = (char*)malloc(fileSize > 0 ? fileSize : 1);
+    if (content == NULL) {
+        perror("Failed to allocate memory for config file content - SF_ERR_MEM");
+        close(fd);
+        return NULL;
+    }
+
+    size_t total = 0;
+    while (total < fileSize) {
+        ssize_t n = read(fd, content + total, fileSize - total);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            perror("Failed to read config file content - SF_ERR_READ");
+            free(content);
+            close(fd);
+            return NULL;
+        }
+        total += (size_t)n;
+    }
+    close(fd);
+
+    *length = fileSize;
+    return content;
+}
+
+JSONVariant readConfigJSON(const char* archivePath, const char* filePath) {
+    size_t length;
+    char* content = readConfigContent(archivePath, filePath, &length);
+    if (content == NULL) {
+        return NULL;
+    }
+
+    // The file may hold JSON text or CBOR; json_decode_buffer tells them apart.
+    JSONVariant json = json_decode_buffer(content, length);
+    free(content);
+    return json;
+}
+
+int readConfigArgs(const char* archivePath, const char* filePath, ConfigArgs* configArgs) {
+    size_t length;
+    char* content = readConfigContent(archivePath, filePath, &length);
+    if (content == NULL) {
+        return SFC_ERR_IO;
+    }
+
+    int result = decodeConfigArgs(content, length, configArgs);
+    free(content);
+    if (result != 0) {
+        fprintf(stderr, "Malformed config file '%s' - SFC_ERR_READ\n", filePath);
+        return SFC_ERR_READ;
+    }
+
+    return SFC_SUCCESS;
+}
+
+int patchConfigFile(const char* archivePath, const char* filePath, JSONPatch patch) {
+    char tempPath[sizeof(SFC_ARCHIVE_TEMP_TEMPLATE)];
+    int decryptResult = decryptArchiveToTemp(archivePath, tempPath);
+    if (decryptResult != SFC_SUCCESS) {
+        return decryptResult;
+    }
+
+    int fd = open(filePath, O_RDWR);
+    if (fd == -1) {
+        perror("An error occurred while opening the config file - SFC_ERR_IO");
+        return SFC_ERR_IO;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        perror("Failed to read config file content - SF_ERR_READ");
+        close(fd);
+        return SFC_ERR_READ;
+    }
+
+    size_t fileSize = (size_t)info.st_size;
+    char* content = (char*)malloc(fileSize > 0 ? fileSize : 1);
+    if (content == NULL) {
+        perror("Failed to allocate memory for config file content - SF_ERR_MEM");
+        close(fd);
+        return SFC_ERR_MEMORY;
+    }
+
+    size_t total = 0;
+    while (total < fileSize) {
+        ssize_t n = pread(fd, content + total, fileSize - total, (off_t)total);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            perror("Failed to read config file content - SF_ERR_READ");
+            free(content);
+            close(fd);
+            return SFC_ERR_READ;
+        }
+        total += (size_t)n;
+    }
+
+    // All operations of the patch are applied to the buffer before anything is written.
+    size_t patchedLength = 0;
+    char* patched = json_patch_apply_buffer(patch, content, fileSize, &patchedLength);
+    free(content);
+    if (patched == NULL) {
+        fprintf(stderr, "Failed to apply patch to config file - SFC_ERR_INVALID_ARGS\n");
+        close(fd);
+        return SFC_ERR_INVALID_ARGS;
+    }
+
+    size_t written = 0;
+    while (written < patchedLength) {
+        ssize_t n = pwrite(fd, patched + written, patchedLength - written, (off_t)written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            perror("An error occurred while writing to the config file - SFC_ERR_WRITE");
+            free(patched);
+            close(fd);
+            return SFC_ERR_WRITE;
+        }
+        written += (size_t)n;
+    }
+    free(patched);
+
+    if (ftruncate(fd, (off_t)patchedLength) != 0) {
+        perror("An error occurred while writing to the config file - SFC_ERR_WRITE");
+        close(fd);
+        return SFC_ERR_WRITE;
+    }
+    close(fd);
+
+    if (encryptScribbleArchive(archivePath, tempPath) != 0) {
+        return SF_ERR_ENCR;
+    }
+
+    return SFC_SUCCESS;
+}
+
 char* readConfigFile(const char* archivePath, const char* filePath) {
     char tempPath[] = "/tmp/scribble_archive_XXXXXX";
 
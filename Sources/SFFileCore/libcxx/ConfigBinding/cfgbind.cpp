@@ -0,0 +1,71 @@
+//===-- libcxx/ConfigBinding/cfgbind.cpp - config JSON binding --*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Binds `ConfigArgs` to the configuration document.
+///
+/// The descriptors below mirror the document layout: the flat struct is split
+/// into the `project`, `document_settings`, `security` and `flags` objects,
+/// and the reference lists are written empty.
+///
+//===----------------------------------------------------------------------===//
+
+#include "libc/SFCConfigArgs.h"
+#include "SFCxxJSONBinding.h"
+#include "SFCxxJSONBuilder.h"
+
+#include <exception>
+
+template <>
+struct sfcxx::JSONBinding<ConfigArgs> {
+    static constexpr auto fields = std::make_tuple(
+        jsonGroup("project",
+                  jsonField("name", &ConfigArgs::name),
+                  jsonField("author", &ConfigArgs::author),
+                  jsonField("created_at", &ConfigArgs::created_at),
+                  jsonField("last_changed_at", &ConfigArgs::last_changed_at),
+                  jsonField("editor_version", &ConfigArgs::editor_version)),
+        jsonGroup("document_settings",
+                  jsonField("encoding", &ConfigArgs::encoding),
+                  jsonField("line_endings", &ConfigArgs::line_endings)),
+        jsonGroup("security",
+                  jsonFlag("password_protected", &ConfigArgs::psw_pr),
+                  jsonField("encryption_method", &ConfigArgs::encryption_method)),
+        jsonGroup("flags",
+                  jsonFlag("is_Favorite", &ConfigArgs::is_Favorite)),
+        jsonLiteral("references", R"({"images":[],"text_files":[],"temporary":[]})"));
+};
+
+extern "C" {
+long encodeConfigArgs(const ConfigArgs* configArgs, JSONBuilder* builder) {
+    sfcxx::JSONBuilderSink sink = sfcxx::JSONBuilderSink::beginValue(builder);
+    sfcxx::JSONBind::encodeTo(*configArgs, sink);                           // Straight into the builder's buffer
+    return json_builder_finish(builder);
+}
+
+int decodeConfigArgs(const char* data, size_t length, ConfigArgs* configArgs) {
+    try {
+        sfcxx::JSONBind::decodeAny(data, length, *configArgs);
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+}
@@ -24,117 +24,762 @@
 //===----------------------------------------------------------------------===//
 
 #include "include/SFCxxBase64.h"
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define SFC_BASE64_X86 1
+    #include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SFC_BASE64_NEON 1
+    #include <arm_neon.h>
+#endif
 
 namespace sfcxx {
 
-static const std::string base64_chars =
+namespace {
+
+const char kStandardAlphabet[] =
              "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
              "abcdefghijklmnopqrstuvwxyz"
              "0123456789+/";
 
-static inline bool is_base64(unsigned char c) {
-    return (isalnum(c) || (c == '+') || (c == '/'));
+const char kURLAlphabet[] =
+             "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+             "abcdefghijklmnopqrstuvwxyz"
+             "0123456789-_";
+
+constexpr uint8_t kInvalid = 0xff;
+
+/// Maps every byte to its 6-bit value, or `kInvalid`.
+struct DecodeTable {
+    uint8_t values[256];
+
+    constexpr explicit DecodeTable(const char* alphabet) : values() {
+        for (unsigned i = 0; i < 256; ++i) values[i] = kInvalid;
+        for (unsigned i = 0; i < 64; ++i) values[static_cast<uint8_t>(alphabet[i])] = static_cast<uint8_t>(i);
+    }
+};
+
+constexpr DecodeTable kStandardDecode(kStandardAlphabet);
+constexpr DecodeTable kURLDecode(kURLAlphabet);
+
+template <bool URLSafe>
+constexpr const char* alphabet() { return URLSafe ? kURLAlphabet : kStandardAlphabet; }
+
+template <bool URLSafe>
+constexpr const DecodeTable& decodeTable() { return URLSafe ? kURLDecode : kStandardDecode; }
+
+inline bool isURLSafe(Base64Variant variant) {
+    return variant == Base64Variant::URL_SAFE || variant == Base64Variant::URL_SAFE_NO_PADDING;
+}
+
+inline bool isPadded(Base64Variant variant) {
+    return variant == Base64Variant::STANDARD || variant == Base64Variant::URL_SAFE;
 }
 
-std::string base64_encode(const unsigned char* bytes_to_encode, unsigned int len) {
-    std::string ret;
-    int i = 0;
-    int j = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
+/// Encodes whole 3-byte groups from the front of `in`.
+///
+/// \return The number of input bytes consumed; `out` received 4/3 as many characters.
+using EncodeFn = size_t (*)(const uint8_t* in, size_t length, char* out);
 
-    while (len--) {
-        char_array_3[i++] = *(bytes_to_encode++);
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
+/// Decodes whole 4-character groups from the front of `in`, stopping before
+/// the first block that contains a character outside the alphabet.
+///
+/// Vector kernels store whole registers, so they only run while `capacity`
+/// leaves room for one full store past the decoded bytes.
+///
+/// \return The number of characters consumed; `out` received 3/4 as many bytes.
+using DecodeFn = size_t (*)(const char* in, size_t length, uint8_t* out, size_t capacity);
 
-            for(i = 0; (i <4) ; i++)
-                ret += base64_chars[char_array_4[i]];
-            i = 0;
+#pragma mark - Scalar kernel
+
+template <bool URLSafe>
+size_t encodeScalar(const uint8_t* in, size_t length, char* out) {
+    const char* chars = alphabet<URLSafe>();
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        uint32_t n = static_cast<uint32_t>(in[i]) << 16 | static_cast<uint32_t>(in[i + 1]) << 8 | in[i + 2];
+        *out++ = chars[n >> 18];
+        *out++ = chars[n >> 12 & 0x3f];
+        *out++ = chars[n >> 6 & 0x3f];
+        *out++ = chars[n & 0x3f];
+    }
+    return i;
+}
+
+template <bool URLSafe>
+size_t decodeScalar(const char* in, size_t length, uint8_t* out, size_t) {
+    const uint8_t* values = decodeTable<URLSafe>().values;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(in);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        uint32_t a = values[bytes[i]];
+        uint32_t b = values[bytes[i + 1]];
+        uint32_t c = values[bytes[i + 2]];
+        uint32_t d = values[bytes[i + 3]];
+        if ((a | b | c | d) & 0x80) break;                                  // kInvalid has the top bit set
+        uint32_t n = a << 18 | b << 12 | c << 6 | d;
+        *out++ = static_cast<uint8_t>(n >> 16);
+        *out++ = static_cast<uint8_t>(n >> 8);
+        *out++ = static_cast<uint8_t>(n);
+    }
+    return i;
+}
+
+#if defined(SFC_BASE64_X86)
+
+#pragma mark - SSSE3 kernel
+
+/// Splits the 12 bytes in the low lanes of each group of four into 16 six-bit indices.
+__attribute__((target("ssse3")))
+inline __m128i unpackSSSE3(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+/// Maps six-bit indices to the alphabet: one offset per range, selected with `pshufb`.
+template <bool URLSafe>
+__attribute__((target("ssse3")))
+inline __m128i translateSSSE3(__m128i indices) {
+    const char plus = URLSafe ? '-' : '+';
+    const char slash = URLSafe ? '_' : '/';
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          static_cast<char>(plus - 62), static_cast<char>(slash - 63), 'A', 0, 0);
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));              // 1...12 for digits, '+' and '/'
+    __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+}
+
+template <bool URLSafe>
+__attribute__((target("ssse3")))
+size_t encodeSSSE3(const uint8_t* in, size_t length, char* out) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 12, out += 16) {                          // Loads 16 bytes, uses 12
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), translateSSSE3<URLSafe>(unpackSSSE3(v)));
+    }
+    return i;
+}
+
+/// Rewrites the URL-safe alphabet to the standard one so the standard lookup
+/// applies; '+' and '/' become NUL, which the lookup rejects.
+__attribute__((target("ssse3")))
+inline __m128i fromURLSafeSSSE3(__m128i v) {
+    __m128i standard = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('+')), _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+    v = _mm_andnot_si128(standard, v);
+    v = _mm_xor_si128(v, _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')), _mm_set1_epi8('-' ^ '+')));
+    return _mm_xor_si128(v, _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_set1_epi8('_' ^ '/')));
+}
+
+/// Translates 16 characters to six-bit values. Returns false if any is outside the alphabet.
+__attribute__((target("ssse3")))
+inline bool lookupSSSE3(__m128i& v) {
+    const __m128i lowerLUT = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i upperLUT = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i rollLUT = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2f);
+
+    __m128i upperNibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask2F);
+    __m128i lowerNibbles = _mm_and_si128(v, mask2F);
+    __m128i upper = _mm_shuffle_epi8(upperLUT, upperNibbles);
+    __m128i lower = _mm_shuffle_epi8(lowerLUT, lowerNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lower, upper), _mm_setzero_si128())) != 0xffff) {
+        return false;
+    }
+    __m128i slash = _mm_cmpeq_epi8(v, mask2F);
+    v = _mm_add_epi8(v, _mm_shuffle_epi8(rollLUT, _mm_add_epi8(slash, upperNibbles)));
+    return true;
+}
+
+/// Packs 16 six-bit values into 12 bytes in the low lanes of the result.
+__attribute__((target("ssse3")))
+inline __m128i packSSSE3(__m128i values) {
+    __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(words, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+template <bool URLSafe>
+__attribute__((target("ssse3")))
+size_t decodeSSSE3(const char* in, size_t length, uint8_t* out, size_t capacity) {
+    size_t i = 0;
+    for (; i + 16 <= length && i / 4 * 3 + 16 <= capacity; i += 16, out += 12) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        if (URLSafe) v = fromURLSafeSSSE3(v);
+        if (!lookupSSSE3(v)) break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packSSSE3(v));    // Stores 16 bytes, 12 are used
+    }
+    return i;
+}
+
+#pragma mark - AVX2 kernel
+
+template <bool URLSafe>
+__attribute__((target("avx2")))
+size_t encodeAVX2(const uint8_t* in, size_t length, char* out) {
+    const char plus = static_cast<char>((URLSafe ? '-' : '+') - 62);
+    const char slash = static_cast<char>((URLSafe ? '_' : '/') - 63);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, plus, slash, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, plus, slash, 'A', 0, 0);
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                             1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    size_t i = 0;
+    for (; i + 28 <= length; i += 24, out += 32) {                          // Loads 28 bytes, uses 24
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+        __m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        __m256i chars = _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), chars);
+    }
+    return i;
+}
+
+template <bool URLSafe>
+__attribute__((target("avx2")))
+size_t decodeAVX2(const char* in, size_t length, uint8_t* out, size_t capacity) {
+    const __m256i lowerLUT = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                              0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+                                              0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                              0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i upperLUT = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                              0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                              0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                              0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i rollLUT = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2f);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+    size_t i = 0;
+    for (; i + 32 <= length && i / 4 * 3 + 32 <= capacity; i += 32, out += 24) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        if (URLSafe) {                                                      // See fromURLSafeSSSE3
+            __m256i standard = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('+')),
+                                               _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')));
+            v = _mm256_andnot_si256(standard, v);
+            v = _mm256_xor_si256(v, _mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')),
+                                                     _mm256_set1_epi8('-' ^ '+')));
+            v = _mm256_xor_si256(v, _mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')),
+                                                     _mm256_set1_epi8('_' ^ '/')));
         }
+        __m256i upperNibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask2F);
+        __m256i lowerNibbles = _mm256_and_si256(v, mask2F);
+        __m256i upper = _mm256_shuffle_epi8(upperLUT, upperNibbles);
+        __m256i lower = _mm256_shuffle_epi8(lowerLUT, lowerNibbles);
+        if (!_mm256_testz_si256(lower, upper)) break;
+        __m256i slash = _mm256_cmpeq_epi8(v, mask2F);
+        v = _mm256_add_epi8(v, _mm256_shuffle_epi8(rollLUT, _mm256_add_epi8(slash, upperNibbles)));
+
+        __m256i pairs = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        __m256i words = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(words, pack), gather);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), bytes);         // Stores 32 bytes, 24 are used
     }
+    return i;
+}
 
-    if (i) {
-        for(j = i; j < 3; j++)
-            char_array_3[j] = '\0';
+#elif defined(SFC_BASE64_NEON)
 
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+#pragma mark - NEON kernel
 
-        for (j = 0; (j < i + 1); j++)
-            ret += base64_chars[char_array_4[j]];
+template <bool URLSafe>
+size_t encodeNEON(const uint8_t* in, size_t length, char* out) {
+    const uint8_t* chars = reinterpret_cast<const uint8_t*>(alphabet<URLSafe>());
+    uint8x16x4_t table = {{vld1q_u8(chars), vld1q_u8(chars + 16), vld1q_u8(chars + 32), vld1q_u8(chars + 48)}};
+    const uint8x16_t low6 = vdupq_n_u8(0x3f);
 
-        while((i++ < 3))
-            ret += '=';
+    size_t i = 0;
+    for (; i + 48 <= length; i += 48, out += 64) {
+        uint8x16x3_t v = vld3q_u8(in + i);                                  // De-interleaves the byte triples
+        uint8x16x4_t indices;
+        indices.val[0] = vshrq_n_u8(v.val[0], 2);
+        indices.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(v.val[0], 4), vshrq_n_u8(v.val[1], 4)), low6);
+        indices.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(v.val[1], 2), vshrq_n_u8(v.val[2], 6)), low6);
+        indices.val[3] = vandq_u8(v.val[2], low6);
+
+        uint8x16x4_t result;
+        for (int k = 0; k < 4; ++k) {
+            result.val[k] = vqtbl4q_u8(table, indices.val[k]);
+        }
+        vst4q_u8(reinterpret_cast<uint8_t*>(out), result);
     }
+    return i;
+}
 
-    return ret;
+/// Six-bit value plus one for ASCII 0...127; zero marks bytes outside the alphabet.
+struct NEONDecodeTable {
+    uint8_t values[128];
+
+    explicit NEONDecodeTable(const char* alphabet) : values() {
+        for (unsigned i = 0; i < 64; ++i) values[static_cast<uint8_t>(alphabet[i])] = static_cast<uint8_t>(i + 1);
+    }
+};
+
+template <bool URLSafe>
+size_t decodeNEON(const char* in, size_t length, uint8_t* out, size_t) {
+    static const NEONDecodeTable tables(alphabet<URLSafe>());
+    uint8x16x4_t lower = {{vld1q_u8(tables.values), vld1q_u8(tables.values + 16),
+                           vld1q_u8(tables.values + 32), vld1q_u8(tables.values + 48)}};
+    uint8x16x4_t upper = {{vld1q_u8(tables.values + 64), vld1q_u8(tables.values + 80),
+                           vld1q_u8(tables.values + 96), vld1q_u8(tables.values + 112)}};
+    const uint8x16_t one = vdupq_n_u8(1);
+    const uint8x16_t offset = vdupq_n_u8(64);
+
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64, out += 48) {
+        uint8x16x4_t v = vld4q_u8(reinterpret_cast<const uint8_t*>(in + i));
+        uint8x16_t valid = vdupq_n_u8(0xff);
+        for (int k = 0; k < 4; ++k) {                                       // Out-of-range indices look up zero
+            uint8x16_t value = vorrq_u8(vqtbl4q_u8(lower, v.val[k]), vqtbl4q_u8(upper, vsubq_u8(v.val[k], offset)));
+            valid = vminq_u8(valid, value);
+            v.val[k] = vsubq_u8(value, one);
+        }
+        if (vminvq_u8(valid) == 0) break;
+
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(v.val[0], 2), vshrq_n_u8(v.val[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(v.val[1], 4), vshrq_n_u8(v.val[2], 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(v.val[2], 6), v.val[3]);
+        vst3q_u8(out, bytes);
+    }
+    return i;
+}
+
+#endif
+
+#pragma mark - Runtime dispatch
+
+/// Kernels for one instruction set, indexed by whether the alphabet is URL-safe.
+struct Kernel {
+    const char* name;
+    EncodeFn encode[2];
+    DecodeFn decode[2];
+};
+
+/// The kernels this CPU can run, fastest first. The scalar kernel is always last.
+struct KernelList {
+    Kernel kernels[3];
+    size_t count = 0;
+
+    void add(const Kernel& kernel) { kernels[count++] = kernel; }
+};
+
+KernelList detectKernels() {
+    KernelList list;
+#if defined(SFC_BASE64_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        list.add({"avx2", {encodeAVX2<false>, encodeAVX2<true>}, {decodeAVX2<false>, decodeAVX2<true>}});
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        list.add({"ssse3", {encodeSSSE3<false>, encodeSSSE3<true>}, {decodeSSSE3<false>, decodeSSSE3<true>}});
+    }
+#elif defined(SFC_BASE64_NEON)
+    list.add({"neon", {encodeNEON<false>, encodeNEON<true>}, {decodeNEON<false>, decodeNEON<true>}});
+#endif
+    list.add({"scalar", {encodeScalar<false>, encodeScalar<true>}, {decodeScalar<false>, decodeScalar<true>}});
+    return list;
 }
 
-std::vector<unsigned char> base64_decode(const std::string& encoded_string) {
-    int in_len = encoded_string.size();
-    int i = 0;
-    int j = 0;
-    int in_ = 0;
-    unsigned char char_array_4[4], char_array_3[3];
-    std::vector<unsigned char> ret;
+const KernelList& supportedKernels() {
+    static const KernelList list = detectKernels();
+    return list;
+}
 
-    while (in_len-- && ( encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-        char_array_4[i++] = encoded_string[in_]; in_++;
-        if (i == 4) {
-            for (i = 0; i < 4; i++)
-                char_array_4[i] = base64_chars.find(char_array_4[i]);
+/// The kernel chosen with `base64_select_kernel`, or null for the fastest one.
+std::atomic<const Kernel*> selectedKernel{nullptr};
+
+const Kernel& activeKernelInstance() {
+    const Kernel* kernel = selectedKernel.load(std::memory_order_relaxed);
+    return kernel != nullptr ? *kernel : supportedKernels().kernels[0];
+}
 
-            char_array_3[0] = ( char_array_4[0] << 2       ) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) +   char_array_4[3];
+/// Encodes whole groups with the active kernel, then the scalar one. Returns the bytes consumed.
+size_t encodeGroups(const uint8_t* in, size_t length, char* out, bool urlSafe) {
+    size_t n = activeKernelInstance().encode[urlSafe](in, length, out);
+    EncodeFn scalar = urlSafe ? encodeScalar<true> : encodeScalar<false>;
+    return n + scalar(in + n, length - n, out + n / 3 * 4);
+}
+
+/// Decodes whole groups with the active kernel, then the scalar one. Returns the characters consumed.
+size_t decodeGroups(const char* in, size_t length, uint8_t* out, size_t capacity, bool urlSafe) {
+    size_t n = activeKernelInstance().decode[urlSafe](in, length, out, capacity);
+    DecodeFn scalar = urlSafe ? decodeScalar<true> : decodeScalar<false>;
+    return n + scalar(in + n, length - n, out + n / 4 * 3, 0);
+}
+
+/// Reads up to `length` bytes, retrying on `EINTR`. Returns 0 at end of file.
+size_t readSome(int fd, void* buffer, size_t length, const char* what) {
+    ssize_t n;
+    do {
+        n = ::read(fd, buffer, length);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+    return static_cast<size_t>(n);
+}
+
+void writeAll(int fd, const void* buffer, size_t length, const char* what) {
+    const char* bytes = static_cast<const char*>(buffer);
+    while (length > 0) {
+        ssize_t n = ::write(fd, bytes, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+}
 
-            for (i = 0; (i < 3); i++)
-                ret.push_back(char_array_3[i]);
-            i = 0;
+/// Closes a descriptor opened by the file functions.
+class FileDescriptor {
+public:
+    FileDescriptor(const std::string& filename, int flags) : fd(::open(filename.c_str(), flags | O_CLOEXEC, 0644)) {
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open file: " + filename);
         }
     }
+    ~FileDescriptor() { ::close(fd); }
 
-    if (i) {
-        for (j = i; j < 4; j++)
-            char_array_4[j] = 0;
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
 
-        for (j = 0; j < 4; j++)
-            char_array_4[j] = base64_chars.find(char_array_4[j]);
+    operator int() const { return fd; }
 
-        char_array_3[0] = ( char_array_4[0] << 2       ) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) +   char_array_4[3];
+private:
+    int fd;
+};
 
-        for (j = 0; (j < i - 1); j++) ret.push_back(char_array_3[j]);
+} // namespace
+
+Base64Encoder::Base64Encoder(Base64Variant variant)
+    : urlSafe(isURLSafe(variant)), padded(isPadded(variant)) {}
+
+size_t Base64Encoder::update(const unsigned char* data, size_t length, char* out) {
+    char* start = out;
+    size_t i = 0;
+    if (pendingLength) {
+        while (pendingLength < 3 && i < length) {
+            pending[pendingLength++] = data[i++];
+        }
+        if (pendingLength < 3) return 0;
+        out += encodeGroups(pending, 3, out, urlSafe) / 3 * 4;
+        pendingLength = 0;
+    }
+
+    size_t n = encodeGroups(data + i, length - i, out, urlSafe);
+    out += n / 3 * 4;
+    for (i += n; i < length; ++i) {
+        pending[pendingLength++] = data[i];
+    }
+    return static_cast<size_t>(out - start);
+}
+
+size_t Base64Encoder::finish(char* out) {
+    size_t rest = pendingLength;
+    pendingLength = 0;
+    if (rest == 0) return 0;
+
+    const char* chars = urlSafe ? kURLAlphabet : kStandardAlphabet;
+    uint32_t n = static_cast<uint32_t>(pending[0]) << 16;
+    if (rest == 2) n |= static_cast<uint32_t>(pending[1]) << 8;
+    out[0] = chars[n >> 18];
+    out[1] = chars[n >> 12 & 0x3f];
+    if (rest == 2) out[2] = chars[n >> 6 & 0x3f];
+    if (!padded) return rest + 1;
+    if (rest == 1) out[2] = '=';
+    out[3] = '=';
+    return 4;
+}
+
+Base64Decoder::Base64Decoder(Base64Variant variant) : urlSafe(isURLSafe(variant)) {}
+
+size_t Base64Decoder::update(const char* data, size_t length, unsigned char* out) {
+    return update(data, length, out, maxOutput(length));
+}
+
+size_t Base64Decoder::update(const char* data, size_t length, unsigned char* out, size_t capacity) {
+    if (done) return 0;
+    const uint8_t* values = (urlSafe ? kURLDecode : kStandardDecode).values;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    unsigned char* start = out;
+    size_t i = 0;
+    if (pendingLength) {
+        for (; pendingLength < 4 && i < length; ++i) {
+            uint8_t value = values[bytes[i]];
+            if (value == kInvalid) {
+                done = true;
+                return 0;
+            }
+            pending[pendingLength++] = value;
+        }
+        if (pendingLength < 4) return 0;
+        uint32_t n = static_cast<uint32_t>(pending[0]) << 18 | static_cast<uint32_t>(pending[1]) << 12 |
+                     static_cast<uint32_t>(pending[2]) << 6 | pending[3];
+        *out++ = static_cast<uint8_t>(n >> 16);
+        *out++ = static_cast<uint8_t>(n >> 8);
+        *out++ = static_cast<uint8_t>(n);
+        pendingLength = 0;
+    }
+
+    size_t n = decodeGroups(data + i, length - i, out, capacity - static_cast<size_t>(out - start), urlSafe);
+    out += n / 4 * 3;
+
+    // Fewer than four characters are left before the end, padding or the first byte outside the alphabet
+    for (i += n; i < length; ++i) {
+        uint8_t value = values[bytes[i]];
+        if (value == kInvalid) {
+            done = true;
+            break;
+        }
+        pending[pendingLength++] = value;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+size_t Base64Decoder::finish(unsigned char* out) {
+    size_t count = pendingLength;
+    pendingLength = 0;
+    done = false;
+    if (count < 2) return 0;
+
+    uint32_t n = static_cast<uint32_t>(pending[0]) << 18 | static_cast<uint32_t>(pending[1]) << 12;
+    if (count == 3) n |= static_cast<uint32_t>(pending[2]) << 6;
+    out[0] = static_cast<uint8_t>(n >> 16);
+    if (count == 3) out[1] = static_cast<uint8_t>(n >> 8);
+    return count - 1;
+}
+
+size_t base64_encoded_size(size_t length, Base64Variant variant) {
+    if (isPadded(variant)) {
+        return (length + 2) / 3 * 4;
     }
+    return length / 3 * 4 + (length % 3 ? length % 3 + 1 : 0);
+}
 
+size_t base64_decoded_size(const char* text, size_t length) {
+    for (int pad = 0; pad < 2 && length > 0 && text[length - 1] == '='; ++pad) {
+        --length;
+    }
+    return length / 4 * 3 + (length % 4 > 1 ? length % 4 - 1 : 0);
+}
+
+size_t base64_encode_into(const unsigned char* data, size_t length, char* out, Base64Variant variant) {
+    Base64Encoder encoder(variant);
+    size_t n = encoder.update(data, length, out);
+    return n + encoder.finish(out + n);
+}
+
+size_t base64_decode_into(const char* text, size_t length, unsigned char* out, size_t capacity,
+                          Base64Variant variant) {
+    if (capacity < base64_decoded_size(text, length)) {
+        throw std::length_error("base64_decode_into: output buffer too small");
+    }
+    // The decoder never writes more than base64_decoded_size; only vector stores need the extra capacity.
+    Base64Decoder decoder(variant);
+    size_t n = decoder.update(text, length, out, capacity);
+    return n + decoder.finish(out + n);
+}
+
+std::string base64_encode(const unsigned char* bytes_to_encode, size_t len, Base64Variant variant) {
+    std::string ret(base64_encoded_size(len, variant), '\0');
+    base64_encode_into(bytes_to_encode, len, &ret[0], variant);
+    return ret;
+}
+
+std::vector<unsigned char> base64_decode(std::string_view encoded_string, Base64Variant variant) {
+    std::vector<unsigned char> ret(base64_decoded_size(encoded_string.data(), encoded_string.size()));
+    ret.resize(base64_decode_into(encoded_string.data(), encoded_string.size(), ret.data(), ret.size(), variant));
     return ret;
 }
 
+void base64_encode_fd(int input, int output, Base64Variant variant) {
+    std::unique_ptr<unsigned char[]> in(new unsigned char[kBase64ChunkSize]);
+    std::unique_ptr<char[]> out(new char[Base64Encoder::maxOutput(kBase64ChunkSize) + 4]);
+    Base64Encoder encoder(variant);
+
+    while (size_t length = readSome(input, in.get(), kBase64ChunkSize, "base64_encode_fd: read failed")) {
+        size_t n = encoder.update(in.get(), length, out.get());
+        writeAll(output, out.get(), n, "base64_encode_fd: write failed");
+    }
+    size_t n = encoder.finish(out.get());
+    writeAll(output, out.get(), n, "base64_encode_fd: write failed");
+}
+
+void base64_decode_fd(int input, int output, Base64Variant variant) {
+    const size_t chunk = Base64Encoder::maxOutput(kBase64ChunkSize);
+    std::unique_ptr<char[]> in(new char[chunk]);
+    std::unique_ptr<unsigned char[]> out(new unsigned char[Base64Decoder::maxOutput(chunk) + 2]);
+    Base64Decoder decoder(variant);
+
+    while (!decoder.stopped()) {
+        size_t length = readSome(input, in.get(), chunk, "base64_decode_fd: read failed");
+        if (length == 0) break;
+        size_t n = decoder.update(in.get(), length, out.get());
+        writeAll(output, out.get(), n, "base64_decode_fd: write failed");
+    }
+    size_t n = decoder.finish(out.get());
+    writeAll(output, out.get(), n, "base64_decode_fd: write failed");
+}
+
+void base64_encode_file(const std::string& filename, int output, Base64Variant variant) {
+    FileDescriptor input(filename, O_RDONLY);
+    base64_encode_fd(input, output, variant);
+}
+
+void base64_decode_file(int input, const std::string& filename, Base64Variant variant) {
+    FileDescriptor output(filename, O_WRONLY | O_CREAT | O_TRUNC);
+    base64_decode_fd(input, output, variant);
+}
+
+const char* base64_active_kernel() {
+    return activeKernelInstance().name;
+}
+
+bool base64_select_kernel(const char* name) {
+    const KernelList& list = supportedKernels();
+    for (size_t i = 0; i < list.count; ++i) {
+        if (std::strcmp(list.kernels[i].name, name) == 0) {
+            selectedKernel.store(&list.kernels[i], std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+MappedFile::MappedFile(const std::string& filename) {
+    FileDescriptor fd(filename, O_RDONLY);
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        throw std::system_error(errno, std::generic_category(), "MappedFile: fstat failed");
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length == 0) return;                                                // mmap rejects empty mappings
+
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "MappedFile: mmap failed");
+    }
+    ::madvise(mapped, length, MADV_SEQUENTIAL);
+    bytes = static_cast<const unsigned char*>(mapped);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : bytes(other.bytes), length(other.length) {
+    other.bytes = nullptr;
+    other.length = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        bytes = other.bytes;
+        length = other.length;
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+void MappedFile::unmap() {
+    if (bytes) {
+        ::munmap(const_cast<unsigned char*>(bytes), length);
+    }
+}
+
+MappedFile map_image_file(const std::string& filename) {
+    return MappedFile(filename);
+}
+
 std::vector<unsigned char> read_image_file(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Unable to open file: " + filename);
+    FileDescriptor fd(filename, O_RDONLY);
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        throw std::system_error(errno, std::generic_category(), "read_image_file: fstat failed");
     }
-    std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<unsigned char> buffer(static_cast<size_t>(info.st_size));
+    size_t used = 0;
+    while (true) {
+        if (used == buffer.size()) {                                        // The file grew since fstat
+            buffer.resize(buffer.size() + kImageWriteChunkSize);
+        }
+        size_t n = readSome(fd, buffer.data() + used, buffer.size() - used, "read_image_file: read failed");
+        if (n == 0) break;
+        used += n;
+    }
+    buffer.resize(used);
     return buffer;
 }
 
-void write_image_file(const std::string& filename, const std::vector<unsigned char>& data) {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Unable to open file: " + filename);
+void write_image_file(const std::string& filename, const unsigned char* data, size_t length) {
+    FileDescriptor fd(filename, O_WRONLY | O_CREAT | O_TRUNC);
+
+    // Reserve the blocks up front so the file is laid out in one extent; this is only a hint.
+#if defined(__APPLE__)
+    fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, static_cast<off_t>(length), 0};
+    if (length && ::fcntl(fd, F_PREALLOCATE, &store) != 0) {
+        store.fst_flags = F_ALLOCATEALL;
+        ::fcntl(fd, F_PREALLOCATE, &store);
+    }
+#elif defined(__linux__)
+    if (length) {
+        ::posix_fallocate(fd, 0, static_cast<off_t>(length));
+    }
+#endif
+
+    size_t offset = 0;
+    while (offset < length) {
+        size_t chunk = std::min(length - offset, kImageWriteChunkSize);
+        ssize_t n = ::pwrite(fd, data + offset, chunk, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "write_image_file: write failed");
+        }
+        offset += static_cast<size_t>(n);
     }
-    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+void write_image_file(const std::string& filename, const std::vector<unsigned char>& data) {
+    write_image_file(filename, data.data(), data.size());
 }
 
 }
@@ -0,0 +1,578 @@
+//===-- _SFCxxUtils/SFCxxCBOR.cpp - Binary JSON Encoding --------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the CBOR encoding of `JSONVariant` documents.
+///
+/// Only the subset of CBOR that maps onto JSON is accepted when reading: byte
+/// strings, non-string map keys and simple values other than `false`, `true`,
+/// `null` and `undefined` are rejected. Tags are skipped.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxCBOR.h"
+#include "include/SFCJSON.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+
+namespace sfcxx {
+
+namespace {
+
+using JSONArray = std::vector<std::shared_ptr<JSONValue>>;
+
+enum : unsigned {
+    MAJOR_UNSIGNED = 0,
+    MAJOR_NEGATIVE = 1,
+    MAJOR_BYTES = 2,
+    MAJOR_TEXT = 3,
+    MAJOR_ARRAY = 4,
+    MAJOR_MAP = 5,
+    MAJOR_TAG = 6,
+    MAJOR_SIMPLE = 7
+};
+
+constexpr unsigned kIndefiniteInfo = 31;
+constexpr uint8_t kBreak = 0xff;
+constexpr uint64_t kUnbounded = UINT64_MAX;                                 // Frame::remaining of indefinite containers
+
+/// The self-describe tag 55799, which marks a buffer as CBOR (RFC 8949, 3.4.6).
+constexpr char kSelfDescribe[] = {'\xd9', '\xd9', '\xf7'};
+
+/// 2^64 as a double: the first magnitude that no CBOR integer holds.
+constexpr double kTwoTo64 = 18446744073709551616.0;
+
+inline void appendBigEndian(std::string& out, uint64_t value, unsigned bytes) {
+    for (unsigned shift = bytes * 8; shift > 0; shift -= 8) {
+        out.push_back(static_cast<char>(value >> (shift - 8)));
+    }
+}
+
+double decodeHalf(uint16_t half) {
+    int exponent = (half >> 10) & 0x1f;
+    int mantissa = half & 0x3ff;
+    double value;
+    if (exponent == 0) {
+        value = std::ldexp(mantissa, -24);
+    } else if (exponent == 31) {
+        value = mantissa == 0 ? INFINITY : NAN;
+    } else {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+/// Materializes the value that starts at the reader's current token.
+JSONVariant readValue(CBORReader& reader) {
+    switch (reader.token()) {
+        case JSONToken::BEGIN_OBJECT: {
+            JSONObject object;
+            object.reserve(reader.sizeHint());
+            while (reader.next() != JSONToken::END_OBJECT) {
+                JSONKey key(reader.stringValue());
+                reader.next();
+                object.insert_or_assign(std::move(key), std::make_shared<JSONValue>(readValue(reader)));
+            }
+            return object;
+        }
+        case JSONToken::BEGIN_ARRAY: {
+            JSONArray array;
+            array.reserve(reader.sizeHint());
+            while (reader.next() != JSONToken::END_ARRAY) {
+                array.push_back(std::make_shared<JSONValue>(readValue(reader)));
+            }
+            return array;
+        }
+        case JSONToken::STRING:
+            return std::string(reader.stringValue());
+        case JSONToken::NUMBER:
+            return reader.numberValue();
+        case JSONToken::BOOL:
+            return reader.boolValue();
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace
+
+#pragma mark - CBOR
+
+std::string CBOR::encode(const JSONVariant& value) {
+    CBORWriter writer;
+    writer.writeSelfDescribeTag();
+    writer.writeValue(value);
+    return writer.release();
+}
+
+void CBOR::encode(const JSONVariant& value, int fd) {
+    CBORWriter writer(fd);
+    writer.writeSelfDescribeTag();
+    writer.writeValue(value);
+    writer.flush();
+}
+
+JSONVariant CBOR::decode(const char* data, size_t length) {
+    CBORReader reader(data, length);
+    reader.next();
+    JSONVariant result = readValue(reader);
+    reader.next();                                                          // Rejects trailing bytes
+    return result;
+}
+
+JSONVariant CBOR::decodeAny(const char* data, size_t length) {
+    if (isCBOR(data, length)) {
+        return decode(data, length);
+    }
+    return JSON::decode(std::string_view(data, length));
+}
+
+bool CBOR::isCBOR(const char* data, size_t length) {
+    if (length >= sizeof(kSelfDescribe) && std::memcmp(data, kSelfDescribe, sizeof(kSelfDescribe)) == 0) {
+        return true;
+    }
+    // JSON text starts with ASCII; untagged CBOR containers start with 0x80-0xbf.
+    auto first = length > 0 ? static_cast<uint8_t>(data[0]) : 0;
+    return first >= 0x80 && first <= 0xbf;
+}
+
+#pragma mark - CBORWriter
+
+CBORWriter::CBORWriter() = default;
+
+CBORWriter::CBORWriter(int fd) : fd(fd) {
+    out.reserve(kWriteChunkSize);
+}
+
+CBORWriter::~CBORWriter() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        // Errors are only reported by an explicit flush.
+    }
+}
+
+void CBORWriter::beginObject(size_t count) {
+    if (count == kIndefinite) {
+        out.push_back(static_cast<char>(MAJOR_MAP << 5 | kIndefiniteInfo));
+    } else {
+        writeHead(MAJOR_MAP, count);
+    }
+    open.push_back(count == kIndefinite);
+}
+
+void CBORWriter::beginArray(size_t count) {
+    if (count == kIndefinite) {
+        out.push_back(static_cast<char>(MAJOR_ARRAY << 5 | kIndefiniteInfo));
+    } else {
+        writeHead(MAJOR_ARRAY, count);
+    }
+    open.push_back(count == kIndefinite);
+}
+
+void CBORWriter::end() {
+    if (open.empty()) {
+        throw std::logic_error("CBORWriter::end called without an open container");
+    }
+    if (open.back()) {
+        out.push_back(static_cast<char>(kBreak));
+        reserveChunk();
+    }
+    open.pop_back();
+}
+
+void CBORWriter::writeSelfDescribeTag() {
+    out.append(kSelfDescribe, sizeof(kSelfDescribe));
+}
+
+void CBORWriter::writeNull() {
+    out.push_back('\xf6');
+    reserveChunk();
+}
+
+void CBORWriter::writeBool(bool value) {
+    out.push_back(value ? '\xf5' : '\xf4');
+    reserveChunk();
+}
+
+void CBORWriter::writeNumber(double value) {
+    if (value == std::floor(value) && !std::signbit(value) && value < kTwoTo64) {
+        writeHead(MAJOR_UNSIGNED, static_cast<uint64_t>(value));
+        return;
+    }
+    if (value == std::floor(value) && value < 0 && value >= -kTwoTo64) {
+        writeHead(MAJOR_NEGATIVE, value == -kTwoTo64 ? UINT64_MAX : static_cast<uint64_t>(-value) - 1);
+        return;
+    }
+
+    // The narrowest float that holds the value exactly; NaN and -0 end up here as well.
+    float narrow = static_cast<float>(value);
+    bool fitsFloat = std::isinf(value) || (std::fabs(value) <= FLT_MAX && static_cast<double>(narrow) == value);
+    if (fitsFloat) {
+        uint32_t bits;
+        std::memcpy(&bits, &narrow, sizeof(bits));
+        out.push_back('\xfa');
+        appendBigEndian(out, bits, 4);
+    } else {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        out.push_back('\xfb');
+        appendBigEndian(out, bits, 8);
+    }
+    reserveChunk();
+}
+
+void CBORWriter::writeString(std::string_view value) {
+    writeHead(MAJOR_TEXT, value.size());
+    out.append(value.data(), value.size());
+    reserveChunk();
+}
+
+void CBORWriter::writeValue(const JSONVariant& value) {
+    std::visit([this](const auto& v) {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, std::nullptr_t>) {
+            writeNull();
+        } else if constexpr (std::is_same_v<T, bool>) {
+            writeBool(v);
+        } else if constexpr (std::is_same_v<T, double>) {
+            writeNumber(v);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            writeString(v);
+        } else if constexpr (std::is_same_v<T, JSONArray>) {
+            beginArray(v.size());
+            for (const auto& element : v) {
+                writeValue(element->value);
+            }
+            end();
+        } else if constexpr (std::is_same_v<T, JSONObject>) {
+            beginObject(v.size());
+            for (const auto& member : v) {
+                writeKey(member.first);
+                writeValue(member.second->value);
+            }
+            end();
+        }
+    }, value);
+}
+
+void CBORWriter::flush() {
+    if (fd < 0) return;
+
+    const char* bytes = out.data();
+    size_t length = out.size();
+    while (length > 0) {
+        ssize_t n = ::write(fd, bytes, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "CBORWriter: write failed");
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+    out.clear();
+}
+
+std::string CBORWriter::release() {
+    std::string result;
+    result.swap(out);
+    open.clear();
+    return result;
+}
+
+void CBORWriter::writeHead(unsigned major, uint64_t argument) {
+    char initial = static_cast<char>(major << 5);
+    if (argument < 24) {
+        out.push_back(static_cast<char>(initial | argument));
+    } else if (argument <= UINT8_MAX) {
+        out.push_back(static_cast<char>(initial | 24));
+        appendBigEndian(out, argument, 1);
+    } else if (argument <= UINT16_MAX) {
+        out.push_back(static_cast<char>(initial | 25));
+        appendBigEndian(out, argument, 2);
+    } else if (argument <= UINT32_MAX) {
+        out.push_back(static_cast<char>(initial | 26));
+        appendBigEndian(out, argument, 4);
+    } else {
+        out.push_back(static_cast<char>(initial | 27));
+        appendBigEndian(out, argument, 8);
+    }
+    reserveChunk();
+}
+
+void CBORWriter::reserveChunk() {
+    if (fd >= 0 && out.size() >= kWriteChunkSize) {
+        flush();
+    }
+}
+
+#pragma mark - CBORReader
+
+CBORReader::CBORReader(const char* data, size_t length)
+    : data(reinterpret_cast<const uint8_t*>(data)), length(length) {}
+
+JSONToken CBORReader::next() {
+    if (!frames.empty() && frames.back().remaining == 0) {
+        bool isMap = frames.back().isMap;
+        frames.pop_back();
+        afterValue();
+        return current = isMap ? JSONToken::END_OBJECT : JSONToken::END_ARRAY;
+    }
+    if (rootDone) {
+        if (pos != length) fail("unexpected trailing bytes");
+        return current = JSONToken::END_OF_DOCUMENT;
+    }
+
+    uint8_t initial = readByte();
+    while (initial >> 5 == MAJOR_TAG) {
+        readArgument(initial & 0x1f);                                       // Tags carry no JSON meaning
+        initial = readByte();
+    }
+
+    if (initial == kBreak) {
+        if (frames.empty() || frames.back().remaining != kUnbounded ||
+            (frames.back().isMap && !frames.back().expectKey)) {
+            fail("unexpected break");
+        }
+        bool isMap = frames.back().isMap;
+        frames.pop_back();
+        afterValue();
+        return current = isMap ? JSONToken::END_OBJECT : JSONToken::END_ARRAY;
+    }
+
+    unsigned major = initial >> 5;
+    unsigned info = initial & 0x1f;
+
+    bool isKey = false;
+    if (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (frame.remaining != kUnbounded) --frame.remaining;
+        if (frame.isMap) {
+            isKey = frame.expectKey;
+            frame.expectKey = !frame.expectKey;
+        }
+    }
+    if (isKey) {
+        if (major != MAJOR_TEXT) fail("map keys must be text strings");
+        readText(info);
+        return current = JSONToken::KEY;
+    }
+
+    switch (major) {
+        case MAJOR_UNSIGNED:
+            number = static_cast<double>(readArgument(info));
+            afterValue();
+            return current = JSONToken::NUMBER;
+
+        case MAJOR_NEGATIVE: {
+            uint64_t n = readArgument(info);
+            number = n == UINT64_MAX ? -kTwoTo64 : -static_cast<double>(n + 1);
+            afterValue();
+            return current = JSONToken::NUMBER;
+        }
+
+        case MAJOR_BYTES:
+            fail("byte strings are not supported");
+
+        case MAJOR_TEXT:
+            readText(info);
+            afterValue();
+            return current = JSONToken::STRING;
+
+        case MAJOR_ARRAY:
+        case MAJOR_MAP: {
+            bool isMap = major == MAJOR_MAP;
+            uint64_t count = kUnbounded;
+            if (info != kIndefiniteInfo) {
+                count = readArgument(info);
+                if (count > (isMap ? kUnbounded / 2 : kUnbounded - 1)) fail("container too large");
+                if (isMap) count *= 2;
+            }
+            frames.push_back({isMap, isMap, count});
+            return current = isMap ? JSONToken::BEGIN_OBJECT : JSONToken::BEGIN_ARRAY;
+        }
+
+        default:
+            break;
+    }
+
+    switch (info) {
+        case 20:
+        case 21:
+            boolean = info == 21;
+            afterValue();
+            return current = JSONToken::BOOL;
+        case 22:
+        case 23:                                                            // `undefined` has no JSON equivalent
+            afterValue();
+            return current = JSONToken::NUL;
+        case 25:
+            number = decodeHalf(static_cast<uint16_t>(readArgument(info)));
+            break;
+        case 26: {
+            uint32_t bits = static_cast<uint32_t>(readArgument(info));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            number = value;
+            break;
+        }
+        case 27: {
+            uint64_t bits = readArgument(info);
+            std::memcpy(&number, &bits, sizeof(number));
+            break;
+        }
+        default:
+            fail("unsupported simple value");
+    }
+    afterValue();
+    return current = JSONToken::NUMBER;
+}
+
+size_t CBORReader::sizeHint() const {
+    if ((current != JSONToken::BEGIN_OBJECT && current != JSONToken::BEGIN_ARRAY) ||
+        frames.back().remaining == kUnbounded) {
+        return 0;
+    }
+    const Frame& frame = frames.back();
+    uint64_t items = frame.isMap ? frame.remaining / 2 : frame.remaining;
+    return static_cast<size_t>(std::min<uint64_t>(items, length - pos));
+}
+
+JSONToken CBORReader::skipValue() {
+    if (current == JSONToken::KEY) {
+        next();
+    }
+    if (current == JSONToken::BEGIN_OBJECT || current == JSONToken::BEGIN_ARRAY) {
+        size_t target = frames.size() - 1;
+        while (frames.size() != target || (current != JSONToken::END_OBJECT && current != JSONToken::END_ARRAY)) {
+            next();
+        }
+    }
+    return current;
+}
+
+uint8_t CBORReader::readByte() {
+    if (pos == length) fail("unexpected end of input");
+    return data[pos++];
+}
+
+uint64_t CBORReader::readArgument(unsigned info) {
+    if (info < 24) {
+        return info;
+    }
+    if (info > 27) {
+        fail("invalid additional information");
+    }
+    unsigned bytes = 1u << (info - 24);
+    if (length - pos < bytes) fail("unexpected end of input");
+    uint64_t value = 0;
+    for (unsigned i = 0; i < bytes; ++i) {
+        value = value << 8 | data[pos++];
+    }
+    return value;
+}
+
+void CBORReader::readText(unsigned info) {
+    if (info != kIndefiniteInfo) {
+        uint64_t size = readArgument(info);
+        if (size > length - pos) fail("unexpected end of input");
+        text = std::string_view(reinterpret_cast<const char*>(data + pos), static_cast<size_t>(size));
+        pos += static_cast<size_t>(size);
+        return;
+    }
+
+    scratch.clear();
+    while (true) {
+        uint8_t initial = readByte();
+        if (initial == kBreak) break;
+        if (initial >> 5 != MAJOR_TEXT || (initial & 0x1f) == kIndefiniteInfo) fail("invalid string chunk");
+        uint64_t size = readArgument(initial & 0x1f);
+        if (size > length - pos) fail("unexpected end of input");
+        scratch.append(reinterpret_cast<const char*>(data + pos), static_cast<size_t>(size));
+        pos += static_cast<size_t>(size);
+    }
+    text = scratch;
+}
+
+void CBORReader::afterValue() {
+    if (frames.empty()) rootDone = true;
+}
+
+void CBORReader::fail(const char* what) const {
+    throw std::runtime_error("Malformed CBOR at offset " + std::to_string(pos) + ": " + what);
+}
+
+} // namespace sfcxx
+
+extern "C" {
+char* json_encode_cbor(JSONVariant value, size_t* length) {
+    try {
+        std::string cbor = sfcxx::CBOR::encode(static_cast<const sfcxx::JSONValue*>(value)->value);
+
+        char* encoded = static_cast<char*>(std::malloc(cbor.size() > 0 ? cbor.size() : 1));
+        if (encoded == nullptr) {
+            return nullptr;
+        }
+        std::memcpy(encoded, cbor.data(), cbor.size());
+        *length = cbor.size();
+        return encoded;
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+int json_encode_cbor_to_fd(JSONVariant value, int fd) {
+    try {
+        sfcxx::CBOR::encode(static_cast<const sfcxx::JSONValue*>(value)->value, fd);
+        return 0;
+    } catch (const std::system_error& error) {
+        errno = error.code().value();
+        return -1;
+    } catch (const std::exception&) {
+        errno = ENOMEM;
+        return -1;
+    }
+}
+
+JSONVariant json_decode_buffer(const char* data, size_t length) {
+    try {
+        return new sfcxx::JSONValue(sfcxx::CBOR::decodeAny(data, length));
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+}
@@ -0,0 +1,277 @@
+//===-- _SFCxxUtils/SFCxxCanvasLayout.cpp - Binary Canvas Layouts *- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the binary canvas layout declared in `SFCxxCanvasLayout.h`.
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxCanvasLayout.h"
+#include "include/SFCxxBase64.h"
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+
+namespace sfcxx {
+
+namespace {
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr bool kHostLittleEndian = false;
+#else
+constexpr bool kHostLittleEndian = true;
+#endif
+
+constexpr char kMagic[4] = {'S', 'F', 'C', 'L'};
+constexpr uint32_t kVersion = 1;
+
+/// The sections following the header, in file order.
+enum Section { IDS, TYPES, XS, YS, WIDTHS, HEIGHTS, TEXTS, STRINGS, SECTION_COUNT };
+
+/// The file header. All fields are little-endian.
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;                  ///< Zero.
+    uint64_t stringsLength;             ///< Size of the string table, including its final NUL.
+    uint64_t sections[SECTION_COUNT];   ///< Offset of each section from the start of the file.
+};
+
+static_assert(sizeof(Header) % 8 == 0, "sections must start 8-byte aligned");
+
+[[noreturn]] void fail(const char* what) {
+    throw std::runtime_error(std::string("Malformed canvas layout: ") + what);
+}
+
+constexpr uint64_t alignUp(uint64_t value) {
+    return (value + 7) & ~uint64_t(7);
+}
+
+/// Computes the section offsets for `count` items and returns the total file size.
+uint64_t layoutSections(uint64_t count, uint64_t stringsLength, uint64_t (&sections)[SECTION_COUNT]) {
+    uint64_t offset = sizeof(Header);
+    for (int section = IDS; section < STRINGS; ++section) {
+        sections[section] = offset;
+        offset = alignUp(offset + count * 4);
+    }
+    sections[STRINGS] = offset;
+    return offset + stringsLength;
+}
+
+uint32_t toLittleEndian(uint32_t value) {
+    if (kHostLittleEndian) return value;
+    return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+}
+
+uint64_t toLittleEndian(uint64_t value) {
+    if (kHostLittleEndian) return value;
+    return static_cast<uint64_t>(toLittleEndian(static_cast<uint32_t>(value))) << 32
+         | toLittleEndian(static_cast<uint32_t>(value >> 32));
+}
+
+/// Collects items into columns, storing each distinct string once.
+class LayoutBuilder {
+public:
+    void add(const SFCXMLItem& item) {
+        if (ids.size() == UINT32_MAX) {
+            throw std::length_error("CanvasLayout: too many items");
+        }
+        ids.push_back(intern(item.id));
+        types.push_back(intern(item.type));
+        xs.push_back(item.x);
+        ys.push_back(item.y);
+        widths.push_back(item.width);
+        heights.push_back(item.height);
+        texts.push_back(intern(item.text));
+    }
+
+    size_t size() const { return ids.size(); }
+
+    std::vector<unsigned char> finish() const {
+        uint64_t count = ids.size();
+        uint64_t stringsLength = strings.size() + 1;                        // The table always ends with NUL
+        Header header = {};
+        std::memcpy(header.magic, kMagic, 4);
+        header.version = toLittleEndian(kVersion);
+        header.count = toLittleEndian(static_cast<uint32_t>(count));
+        header.stringsLength = toLittleEndian(stringsLength);
+        uint64_t sections[SECTION_COUNT];
+        std::vector<unsigned char> out(layoutSections(count, stringsLength, sections));
+        for (int section = 0; section < SECTION_COUNT; ++section) {
+            header.sections[section] = toLittleEndian(sections[section]);
+        }
+
+        std::memcpy(out.data(), &header, sizeof(header));
+        storeColumn(out.data() + sections[IDS], ids.data(), count);
+        storeColumn(out.data() + sections[TYPES], types.data(), count);
+        storeColumn(out.data() + sections[XS], reinterpret_cast<const uint32_t*>(xs.data()), count);
+        storeColumn(out.data() + sections[YS], reinterpret_cast<const uint32_t*>(ys.data()), count);
+        storeColumn(out.data() + sections[WIDTHS], reinterpret_cast<const uint32_t*>(widths.data()), count);
+        storeColumn(out.data() + sections[HEIGHTS], reinterpret_cast<const uint32_t*>(heights.data()), count);
+        storeColumn(out.data() + sections[TEXTS], texts.data(), count);
+        std::memcpy(out.data() + sections[STRINGS], strings.data(), strings.size());
+        return out;
+    }
+
+private:
+    std::vector<uint32_t> ids, types, texts;
+    std::vector<int32_t> xs, ys, widths, heights;
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> offsets;     ///< Offset of each string in `strings`.
+
+    uint32_t intern(const char* text) {
+        if (text == nullptr) {
+            return CanvasLayout::kNullString;
+        }
+        auto [entry, inserted] = offsets.try_emplace(text, static_cast<uint32_t>(strings.size()));
+        if (inserted) {
+            size_t length = entry->first.size() + 1;
+            if (strings.size() + length >= UINT32_MAX) {                    // Keep room for the final NUL
+                offsets.erase(entry);
+                throw std::length_error("CanvasLayout: string table too large");
+            }
+            strings.append(entry->first.c_str(), length);
+        }
+        return entry->second;
+    }
+
+    static void storeColumn(unsigned char* out, const uint32_t* values, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (kHostLittleEndian) {
+            std::memcpy(out, values, count * 4);
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t value = toLittleEndian(values[i]);
+            std::memcpy(out + i * 4, &value, 4);
+        }
+    }
+};
+
+/// Streams parsed XML items into a builder.
+struct XMLImport {
+    LayoutBuilder builder;
+    std::exception_ptr error;           ///< Rethrown once parsing has stopped; exceptions must not unwind through libxml2.
+};
+
+int importItem(const SFCXMLItem* item, void* context) {
+    auto* import = static_cast<XMLImport*>(context);
+    try {
+        import->builder.add(*item);
+        return 0;
+    } catch (...) {
+        import->error = std::current_exception();
+        return 1;
+    }
+}
+
+/// Checks that every offset in a string column names a string in the table.
+void checkStrings(const uint32_t* column, size_t count, uint64_t stringsLength) {
+    for (size_t i = 0; i < count; ++i) {
+        if (column[i] != CanvasLayout::kNullString && column[i] >= stringsLength) fail("string offset out of range");
+    }
+}
+
+} // namespace
+
+std::vector<unsigned char> CanvasLayout::encode(const SFCXMLItem* items, size_t count) {
+    LayoutBuilder builder;
+    for (size_t i = 0; i < count; ++i) {
+        builder.add(items[i]);
+    }
+    return builder.finish();
+}
+
+void CanvasLayout::write(const std::string& filename, const SFCXMLItem* items, size_t count) {
+    write_image_file(filename, encode(items, count));
+}
+
+CanvasLayout CanvasLayout::view(const unsigned char* data, size_t length) {
+    if (!kHostLittleEndian) fail("big-endian hosts cannot read layouts in place");
+    if (length < sizeof(Header)) fail("missing header");
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint32_t) != 0) fail("misaligned buffer");
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, 4) != 0) fail("missing header");
+    if (header.version != kVersion) fail("unsupported version");
+    if (header.stringsLength == 0 || header.stringsLength > UINT32_MAX) fail("invalid string table size");
+
+    uint64_t sections[SECTION_COUNT];
+    if (layoutSections(header.count, header.stringsLength, sections) != length) fail("unexpected length");
+    if (std::memcmp(sections, header.sections, sizeof(sections)) != 0) fail("unexpected section offsets");
+
+    CanvasLayout layout;
+    layout.count = header.count;
+    layout.ids = reinterpret_cast<const uint32_t*>(data + sections[IDS]);
+    layout.types = reinterpret_cast<const uint32_t*>(data + sections[TYPES]);
+    layout.xs = reinterpret_cast<const int32_t*>(data + sections[XS]);
+    layout.ys = reinterpret_cast<const int32_t*>(data + sections[YS]);
+    layout.widths = reinterpret_cast<const int32_t*>(data + sections[WIDTHS]);
+    layout.heights = reinterpret_cast<const int32_t*>(data + sections[HEIGHTS]);
+    layout.texts = reinterpret_cast<const uint32_t*>(data + sections[TEXTS]);
+    layout.strings = reinterpret_cast<const char*>(data + sections[STRINGS]);
+
+    // Offsets in range and a final NUL are all it takes for every string to be terminated.
+    if (layout.strings[header.stringsLength - 1] != '\0') fail("unterminated string table");
+    checkStrings(layout.ids, layout.count, header.stringsLength);
+    checkStrings(layout.types, layout.count, header.stringsLength);
+    checkStrings(layout.texts, layout.count, header.stringsLength);
+    return layout;
+}
+
+CanvasLayout CanvasLayout::open(const std::string& filename) {
+    auto mapping = std::make_shared<const MappedFile>(filename);
+    CanvasLayout layout = view(mapping->data(), mapping->size());
+    layout.mapping = std::move(mapping);
+    return layout;
+}
+
+size_t CanvasLayout::convertFromXML(const std::string& xmlFilename, const std::string& layoutFilename) {
+    XMLImport import;
+    int result = parseXMLItems(xmlFilename.c_str(), importItem, &import);
+    if (import.error) {
+        std::rethrow_exception(import.error);
+    }
+    if (result != 0) {
+        throw std::runtime_error("Unable to parse XML file: " + xmlFilename);
+    }
+    write_image_file(layoutFilename, import.builder.finish());
+    return import.builder.size();
+}
+
+void CanvasLayout::writeXML(const std::string& filename, const char* rootElement) const {
+    std::vector<SFCXMLItem> items(count);
+    for (size_t i = 0; i < count; ++i) {
+        items[i] = item(i);
+    }
+    if (writeItemsToFile(filename.c_str(), rootElement, items.data(), count) != 0) {
+        throw std::system_error(errno, std::generic_category(), "CanvasLayout::writeXML: write failed");
+    }
+}
+
+}
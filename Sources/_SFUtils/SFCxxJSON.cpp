@@ -47,185 +47,639 @@
 //===----------------------------------------------------------------------===//
 
 #include "include/SFCxxJSON.h"
+#include "include/SFCxxJSONNumber.h"
 #include "include/SFCJSON.h"
 
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
 
 namespace sfcxx {
 
+namespace {
+
+[[noreturn]] void fail(const char* what, size_t offset) {
+    throw std::runtime_error("Malformed JSON at offset " + std::to_string(offset) + ": " + what);
+}
+
+inline bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+#pragma mark - Encoder sinks
+
+/// Appends the encoded JSON to a string.
+class StringSink {
+public:
+    explicit StringSink(std::string& out) : out(out) {}
+    void write(const char* data, size_t length) { out.append(data, length); }
+    void put(char c) { out.push_back(c); }
+
+private:
+    std::string& out;
+};
+
+/// Only measures the encoded JSON.
+class CountingSink {
+public:
+    void write(const char*, size_t length) { count += length; }
+    void put(char) { ++count; }
+    size_t size() const { return count; }
+
+private:
+    size_t count = 0;
+};
+
+/// Fills a fixed buffer and keeps counting once it is full.
+class BufferSink {
+public:
+    BufferSink(char* data, size_t capacity) : data(data), capacity(capacity) {}
+
+    void write(const char* bytes, size_t length) {
+        if (count < capacity) {
+            std::memcpy(data + count, bytes, std::min(length, capacity - count));
+        }
+        count += length;
+    }
+
+    void put(char c) {
+        if (count < capacity) data[count] = c;
+        ++count;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    char* data;
+    size_t capacity;
+    size_t count = 0;
+};
+
+/// Writes the encoded JSON to a file descriptor in `JSON::kWriteChunkSize` chunks.
+class FileSink {
+public:
+    explicit FileSink(int fd) : fd(fd), buffer(new char[JSON::kWriteChunkSize]) {}
+
+    void write(const char* bytes, size_t length) {
+        if (length > JSON::kWriteChunkSize - used) {
+            flush();
+            if (length >= JSON::kWriteChunkSize) {
+                writeAll(bytes, length);                                    // Too large to be worth buffering
+                return;
+            }
+        }
+        std::memcpy(buffer.get() + used, bytes, length);
+        used += length;
+    }
+
+    void put(char c) {
+        if (used == JSON::kWriteChunkSize) flush();
+        buffer[used++] = c;
+    }
+
+    void flush() {
+        writeAll(buffer.get(), used);
+        used = 0;
+    }
+
+private:
+    void writeAll(const char* bytes, size_t length) {
+        while (length > 0) {
+            ssize_t n = ::write(fd, bytes, length);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "JSON::encode: write failed");
+            }
+            bytes += n;
+            length -= static_cast<size_t>(n);
+        }
+    }
+
+    int fd;
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+};
+
+#pragma mark - String escaping
+
+template <typename Sink>
+void writeString(Sink& out, std::string_view text) {
+    out.put('"');
+    JSON::escapeTo(text, out);
+    out.put('"');
+}
+
+/// Reads the four hex digits of a `\\u` escape at `pos`. Returns false if they are not hex digits.
+bool readHex4(std::string_view raw, size_t pos, uint32_t& value) {
+    if (pos + 4 > raw.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = pos; i < pos + 4; ++i) {
+        char c = raw[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') digit = static_cast<uint32_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') digit = static_cast<uint32_t>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') digit = static_cast<uint32_t>(c - 'A' + 10);
+        else return false;
+        value = value << 4 | digit;
+    }
+    return true;
+}
+
+void appendUTF8(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xc0 | codePoint >> 6);
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xe0 | codePoint >> 12);
+        out += static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | codePoint >> 18);
+        out += static_cast<char>(0x80 | (codePoint >> 12 & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+}
+
+#pragma mark - Decoder helpers
+
+/// Indexes `length` bytes at `data` into a per-thread index that keeps its capacity across calls.
+const JSONStructuralIndex& indexDocument(const char* data, size_t length) {
+    thread_local JSONStructuralIndex index;
+    JSONScanner::buildIndex(data, length, index);
+    if (index.unterminatedString) {
+        throw std::runtime_error("Malformed JSON: unterminated string");
+    }
+    return index;
+}
+
+/// The decoded children of every container that is still open, innermost last.
+///
+/// A container's values are collected here and moved into it once its closing
+/// bracket is reached, so each container is allocated once, at its final size.
+/// The stack is per thread; it keeps up to `kRetainedBytes` of capacity
+/// between documents.
+template <typename T>
+class ChildStack {
+public:
+    static constexpr size_t kRetainedBytes = 1024 * 1024;
+
+    /// Opens a frame on top of the thread's stack.
+    ChildStack() : stack(storage()), base(stack.size()) {}
+
+    /// Discards the frame, including any values left after an error.
+    ~ChildStack() {
+        stack.erase(stack.begin() + static_cast<std::ptrdiff_t>(base), stack.end());
+        if (base == 0 && stack.capacity() * sizeof(T) > kRetainedBytes) {
+            stack.shrink_to_fit();
+        }
+    }
+
+    ChildStack(const ChildStack&) = delete;
+    ChildStack& operator=(const ChildStack&) = delete;
+
+    template <typename... Args>
+    void emplace(Args&&... args) { stack.emplace_back(std::forward<Args>(args)...); }
+
+    size_t size() const { return stack.size() - base; }
+
+    /// Returns move iterators over the values of this frame.
+    auto begin() { return std::make_move_iterator(stack.begin() + static_cast<std::ptrdiff_t>(base)); }
+    auto end() { return std::make_move_iterator(stack.end()); }
+
+private:
+    static std::vector<T>& storage() {
+        thread_local std::vector<T> values;
+        return values;
+    }
+
+    std::vector<T>& stack;
+    size_t base;
+};
+
+/// Checks the literal at `start`, which must be followed by whitespace or the next structural.
+template <typename Cursor>
+bool matchesLiteral(const Cursor& cursor, size_t start, const char* literal) {
+    size_t end = start + std::strlen(literal);
+    return end <= cursor.length && std::memcmp(cursor.data + start, literal, end - start) == 0 &&
+           (end == cursor.nextOffset() || isWhitespace(cursor.data[end]));
+}
+
+} // namespace
+
 std::string JSON::encode(const JSONVariant& value) {
     std::string result;
-    encodeValue(value, result);
+    StringSink sink(result);
+    encodeValue(value, sink);
+    return result;
+}
+
+size_t JSON::encodedSize(const JSONVariant& value) {
+    CountingSink sink;
+    encodeValue(value, sink);
+    return sink.size();
+}
+
+size_t JSON::encode(const JSONVariant& value, char* buffer, size_t capacity) {
+    BufferSink sink(buffer, capacity);
+    encodeValue(value, sink);
+    return sink.size();
+}
+
+void JSON::encode(const JSONVariant& value, int fd) {
+    FileSink sink(fd);
+    encodeValue(value, sink);
+    sink.flush();
+}
+
+JSONVariant JSON::decode(std::string_view json) {
+    const JSONStructuralIndex& index = indexDocument(json.data(), json.size());
+    Cursor cursor = {json.data(), json.size(), index.positions.data(), index.positions.size(), 0};
+    JSONVariant result = decodeValue(cursor);
+    if (cursor.next != cursor.count) {
+        fail("unexpected trailing characters", cursor.nextOffset());
+    }
+    return result;
+}
+
+JSONViewValue JSON::decodeView(std::string_view json) {
+    const JSONStructuralIndex& index = indexDocument(json.data(), json.size());
+    Cursor cursor = {json.data(), json.size(), index.positions.data(), index.positions.size(), 0};
+    JSONViewValue result = {decodeViewValue(cursor)};
+    if (cursor.next != cursor.count) {
+        fail("unexpected trailing characters", cursor.nextOffset());
+    }
     return result;
 }
 
-JSONVariant JSON::decode(const std::string& json) {
+void JSON::escape(std::string_view text, std::string& out) {
+    StringSink sink(out);
+    escapeTo(text, sink);
+}
+
+void JSON::unescape(std::string_view raw, std::string& out) {
+    out.reserve(out.size() + raw.size());
     size_t pos = 0;
-    return decodeValue(json, pos);
+    while (true) {
+        size_t end = JSONScanner::findQuoteOrBackslash(raw.data(), pos, raw.size());
+        out.append(raw.data() + pos, end - pos);                            // Copy the clean span in bulk
+        if (end >= raw.size()) {
+            return;
+        }
+        if (end + 1 >= raw.size() || raw[end] != '\\') {
+            throw std::runtime_error("Malformed JSON: invalid escape sequence");
+        }
+
+        pos = end + 2;
+        switch (raw[end + 1]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t codePoint;
+                if (!readHex4(raw, pos, codePoint)) {
+                    throw std::runtime_error("Malformed JSON: invalid \\u escape");
+                }
+                pos += 4;
+                if (codePoint >= 0xd800 && codePoint < 0xdc00) {
+                    uint32_t low;
+                    if (pos + 1 < raw.size() && raw[pos] == '\\' && raw[pos + 1] == 'u' &&
+                        readHex4(raw, pos + 2, low) && low >= 0xdc00 && low < 0xe000) {
+                        codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                        pos += 6;
+                    } else {
+                        codePoint = 0xfffd;                                 // Unpaired high surrogate
+                    }
+                } else if (codePoint >= 0xdc00 && codePoint < 0xe000) {
+                    codePoint = 0xfffd;                                     // Unpaired low surrogate
+                }
+                appendUTF8(out, codePoint);
+                break;
+            }
+            default:
+                throw std::runtime_error("Malformed JSON: invalid escape sequence");
+        }
+    }
 }
 
-void JSON::encodeValue(const JSONVariant& value, std::string& out) {
+template <typename Sink>
+void JSON::encodeValue(const JSONVariant& value, Sink& out) {
     if (std::holds_alternative<std::nullptr_t>(value)) {
-        out += "null";
+        out.write("null", 4);
     } else if (std::holds_alternative<bool>(value)) {
-        out += std::get<bool>(value) ? "true" : "false";
+        if (std::get<bool>(value)) {
+            out.write("true", 4);
+        } else {
+            out.write("false", 5);
+        }
     } else if (std::holds_alternative<double>(value)) {
-        std::ostringstream oss;
-        oss << std::setprecision(std::numeric_limits<double>::max_digits10) << std::get<double>(value);
-        out += oss.str();
+        char buffer[JSONNumber::kMaxFormattedLength];
+        out.write(buffer, JSONNumber::format(std::get<double>(value), buffer));
     } else if (std::holds_alternative<std::string>(value)) {
-        out += '"';
-        out += std::get<std::string>(value);
-        out += '"';
+        writeString(out, std::get<std::string>(value));
     } else if (std::holds_alternative<std::vector<std::shared_ptr<JSONValue>>>(value)) {
-        out += '[';
+        out.put('[');
         const auto& vec = std::get<std::vector<std::shared_ptr<JSONValue>>>(value);
         for (auto it = vec.begin(); it != vec.end(); ++it) {
-            if (it != vec.begin()) out += ',';
+            if (it != vec.begin()) out.put(',');
             encodeValue((*it)->value, out);
         }
-        out += ']';
-    } else if (std::holds_alternative<std::unordered_map<std::string, std::shared_ptr<JSONValue>>>(value)) {
-        out += '{';
-        const auto& map = std::get<std::unordered_map<std::string, std::shared_ptr<JSONValue>>>(value);
-        for (auto it = map.begin(); it != map.end(); ++it) {
-            if (it != map.begin()) out += ',';
-            out += '"';
-            out += it->first;
-            out += "\":";
+        out.put(']');
+    } else if (std::holds_alternative<JSONObject>(value)) {
+        out.put('{');
+        const auto& object = std::get<JSONObject>(value);
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            if (it != object.begin()) out.put(',');
+            writeString(out, it->first);
+            out.put(':');
             encodeValue(it->second->value, out);
         }
-        out += '}';
+        out.put('}');
     }
 }
 
-JSONVariant JSON::decodeValue(const std::string& json, size_t& pos) {
-    skipWhitespace(json, pos);
-    char current = json[pos];
+JSONVariant JSON::decodeValue(Cursor& cursor) {
+    char current = cursor.peek();
 
     if (current == '{') {
-        return decodeObject(json, pos);
+        return decodeObject(cursor);
     } else if (current == '[') {
-        return decodeArray(json, pos);
+        return decodeArray(cursor);
     } else if (current == '"') {
-        return decodeString(json, pos);
+        return decodeString(cursor);
     } else if (current == 't' || current == 'f') {
-        return decodeBool(json, pos);
+        return decodeBool(cursor);
     } else if (current == 'n') {
-        return decodeNull(json, pos);
-    } else {
-        return decodeNumber(json, pos);
+        return decodeNull(cursor);
+    } else if (current == '-' || (current >= '0' && current <= '9')) {
+        return decodeNumber(cursor);
     }
+    fail("expected a value", cursor.nextOffset());
 }
 
-JSONVariant JSON::decodeObject(const std::string& json, size_t& pos) {
-    std::unordered_map<std::string, std::shared_ptr<JSONValue>> result;
-    ++pos; // Skip '{'
-    skipWhitespace(json, pos);
+JSONVariant JSON::decodeObject(Cursor& cursor) {
+    JSONObject result;
+    cursor.advance();                                                       // Skip '{'
+    if (cursor.peek() == '}') {
+        cursor.advance();
+        return result;
+    }
 
-    while (pos < json.size() && json[pos] != '}') {
-        skipWhitespace(json, pos);
-        std::string key = decodeString(json, pos);
-        skipWhitespace(json, pos);
-        ++pos;                                                              // Skip ':'
-        skipWhitespace(json, pos);
-        result[key] = std::make_shared<JSONValue>(decodeValue(json, pos));
-        skipWhitespace(json, pos);
+    ChildStack<JSONObject::value_type> members;
+    while (true) {
+        if (cursor.peek() != '"') {
+            fail("expected an object key", cursor.nextOffset());
+        }
+        JSONKey key = decodeKey(cursor);
+        if (cursor.peek() != ':') {
+            fail("expected ':'", cursor.nextOffset());
+        }
+        cursor.advance();                                                   // Skip ':'
+        members.emplace(std::move(key), std::make_shared<JSONValue>(decodeValue(cursor)));
 
-        if (json[pos] == ',') {
-            ++pos;                                                          // Skip ','
-            skipWhitespace(json, pos);
+        char current = cursor.peek();
+        if (current != ',' && current != '}') {
+            fail("expected ',' or '}'", cursor.nextOffset());
         }
+        cursor.advance();                                                   // Skip ',' or '}'
+        if (current == '}') break;
     }
-    ++pos;                                                                  // Skip '}'
 
+    result.reserve(members.size());
+    for (auto member = members.begin(); member != members.end(); ++member) {
+        JSONObject::value_type entry = *member;
+        result.insert_or_assign(std::move(entry.first), std::move(entry.second));
+    }
     return result;
 }
 
-JSONVariant JSON::decodeArray(const std::string& json, size_t& pos) {
+JSONVariant JSON::decodeArray(Cursor& cursor) {
     std::vector<std::shared_ptr<JSONValue>> result;
-    ++pos;                                                                  // Skip '['
-    skipWhitespace(json, pos);
+    cursor.advance();                                                       // Skip '['
+    if (cursor.peek() == ']') {
+        cursor.advance();
+        return result;
+    }
 
-    while (pos < json.size() && json[pos] != ']') {
-        result.push_back(std::make_shared<JSONValue>(decodeValue(json, pos)));
-        skipWhitespace(json, pos);
+    ChildStack<std::shared_ptr<JSONValue>> elements;
+    while (true) {
+        elements.emplace(std::make_shared<JSONValue>(decodeValue(cursor)));
 
-        if (json[pos] == ',') {
-            ++pos;                                                          // Skip ','
-            skipWhitespace(json, pos);
+        char current = cursor.peek();
+        if (current != ',' && current != ']') {
+            fail("expected ',' or ']'", cursor.nextOffset());
         }
+        cursor.advance();                                                   // Skip ',' or ']'
+        if (current == ']') break;
     }
-    ++pos;                                                                  // Skip ']'
 
+    result.assign(elements.begin(), elements.end());
     return result;
 }
 
-void JSON::skipWhitespace(const std::string& json, size_t& pos) {
-    while (pos < json.size() && std::isspace(json[pos])) {
-        ++pos;
+std::string JSON::decodeString(Cursor& cursor) {
+    JSONLazyString string = decodeViewString(cursor);
+    if (!string.hasEscapes()) {
+        return std::string(string.raw());
     }
-}
-
-std::string JSON::decodeString(const std::string& json, size_t& pos) {
     std::string result;
-    ++pos;                                                                  // Skip opening quote
-    while (pos < json.size()) {
-        char current = json[pos++];
-        if (current == '"') {
-            return result;
-        } else if (current == '\\') {
-            if (pos < json.size()) {
-                result += json[pos++];
-            }
-        } else {
-            result += current;
-        }
-    }
+    unescape(string.raw(), result);
     return result;
 }
 
-double JSON::decodeNumber(const std::string& json, size_t& pos) {
-    size_t start = pos;
-    while (pos < json.size() && (std::isdigit(json[pos]) || json[pos] == '.' || json[pos] == '-')) {
-        ++pos;
+JSONKey JSON::decodeKey(Cursor& cursor) {
+    JSONLazyString string = decodeViewString(cursor);
+    if (!string.hasEscapes()) {
+        return JSONKey(string.raw());                                       // Interned straight from the input
     }
-    std::istringstream iss(json.substr(start, pos - start));
+    thread_local std::string scratch;
+    scratch.clear();
+    unescape(string.raw(), scratch);
+    return JSONKey(scratch);
+}
+
+double JSON::decodeNumber(Cursor& cursor) {
+    size_t start = cursor.advance();
     double result;
-    iss >> result;
+    const char* end = JSONNumber::parse(cursor.data + start, cursor.data + cursor.length, result);
+    if (end == nullptr || (static_cast<size_t>(end - cursor.data) < cursor.nextOffset() && !isWhitespace(*end))) {
+        fail("invalid number", start);
+    }
     return result;
 }
 
-bool JSON::decodeBool(const std::string& json, size_t& pos) {
-    if (json[pos] == 't') {
-        pos += 4; // true
+bool JSON::decodeBool(Cursor& cursor) {
+    size_t start = cursor.advance();
+    if (matchesLiteral(cursor, start, "true")) {
         return true;
-    } else {
-        pos += 5; // false
+    } else if (matchesLiteral(cursor, start, "false")) {
         return false;
     }
+    fail("invalid literal", start);
 }
 
-std::nullptr_t JSON::decodeNull(const std::string& json, size_t& pos) {
-    pos += 4; // null
+std::nullptr_t JSON::decodeNull(Cursor& cursor) {
+    size_t start = cursor.advance();
+    if (!matchesLiteral(cursor, start, "null")) {
+        fail("invalid literal", start);
+    }
     return nullptr;
 }
 
+JSONViewVariant JSON::decodeViewValue(Cursor& cursor) {
+    char current = cursor.peek();
+
+    if (current == '{') {
+        return decodeViewObject(cursor);
+    } else if (current == '[') {
+        return decodeViewArray(cursor);
+    } else if (current == '"') {
+        return decodeViewString(cursor);
+    } else if (current == 't' || current == 'f') {
+        return decodeBool(cursor);
+    } else if (current == 'n') {
+        return decodeNull(cursor);
+    } else if (current == '-' || (current >= '0' && current <= '9')) {
+        return decodeNumber(cursor);
+    }
+    fail("expected a value", cursor.nextOffset());
+}
+
+JSONViewObject JSON::decodeViewObject(Cursor& cursor) {
+    JSONViewObject result;
+    cursor.advance();                                                       // Skip '{'
+    if (cursor.peek() == '}') {
+        cursor.advance();
+        return result;
+    }
+
+    ChildStack<JSONViewObject::value_type> members;
+    while (true) {
+        if (cursor.peek() != '"') {
+            fail("expected an object key", cursor.nextOffset());
+        }
+        JSONLazyString key = decodeViewString(cursor);
+        if (cursor.peek() != ':') {
+            fail("expected ':'", cursor.nextOffset());
+        }
+        cursor.advance();                                                   // Skip ':'
+        members.emplace(std::move(key), JSONViewValue{decodeViewValue(cursor)});
+
+        char current = cursor.peek();
+        if (current != ',' && current != '}') {
+            fail("expected ',' or '}'", cursor.nextOffset());
+        }
+        cursor.advance();                                                   // Skip ',' or '}'
+        if (current == '}') break;
+    }
+
+    result.assign(members.begin(), members.end());
+    return result;
+}
+
+JSONViewArray JSON::decodeViewArray(Cursor& cursor) {
+    JSONViewArray result;
+    cursor.advance();                                                       // Skip '['
+    if (cursor.peek() == ']') {
+        cursor.advance();
+        return result;
+    }
+
+    ChildStack<JSONViewValue> elements;
+    while (true) {
+        elements.emplace(JSONViewValue{decodeViewValue(cursor)});
+
+        char current = cursor.peek();
+        if (current != ',' && current != ']') {
+            fail("expected ',' or ']'", cursor.nextOffset());
+        }
+        cursor.advance();                                                   // Skip ',' or ']'
+        if (current == ']') break;
+    }
+
+    result.assign(elements.begin(), elements.end());
+    return result;
+}
+
+JSONLazyString JSON::decodeViewString(Cursor& cursor) {
+    size_t start = cursor.advance() + 1;                                    // Skip opening quote
+    size_t pos = start;
+    bool escapes = false;
+    while (true) {
+        size_t end = JSONScanner::findQuoteOrBackslash(cursor.data, pos, cursor.length);
+        if (end >= cursor.length) {
+            fail("unterminated string", start);
+        }
+        if (cursor.data[end] == '"') {
+            return JSONLazyString(std::string_view(cursor.data + start, end - start), escapes);
+        }
+        escapes = true;
+        pos = end + 2;                                                      // Skip the escaped character
+    }
+}
+
 } // namespace sfcxx
 
 extern "C" {
-const char* json_encode(JSONVariant value) {
-    thread_local std::string encoded;
-    encoded = sfcxx::JSON::encode(*reinterpret_cast<const sfcxx::JSONVariant*>(&value));
-    
-    return encoded.c_str();
+char* json_encode(JSONVariant value) {
+    std::string json = sfcxx::JSON::encode(static_cast<const sfcxx::JSONValue*>(value)->value);
+
+    char* encoded = static_cast<char*>(std::malloc(json.size() + 1));
+    if (encoded == nullptr) {
+        return nullptr;
+    }
+    std::memcpy(encoded, json.c_str(), json.size() + 1);
+    return encoded;
+}
+
+size_t json_encoded_size(JSONVariant value) {
+    return sfcxx::JSON::encodedSize(static_cast<const sfcxx::JSONValue*>(value)->value);
+}
+
+size_t json_encode_to_buffer(JSONVariant value, char* buffer, size_t capacity) {
+    size_t writable = capacity > 0 ? capacity - 1 : 0;
+    size_t length = sfcxx::JSON::encode(static_cast<const sfcxx::JSONValue*>(value)->value, buffer, writable);
+    if (capacity > 0) {
+        buffer[std::min(length, writable)] = '\0';
+    }
+    return length;
+}
+
+int json_encode_to_fd(JSONVariant value, int fd) {
+    try {
+        sfcxx::JSON::encode(static_cast<const sfcxx::JSONValue*>(value)->value, fd);
+        return 0;
+    } catch (const std::system_error& error) {
+        errno = error.code().value();
+        return -1;
+    } catch (const std::exception&) {
+        errno = ENOMEM;
+        return -1;
+    }
 }
 
 JSONVariant json_decode(const char* json) {
-    auto variant = sfcxx::JSON::decode(json);
+    try {
+        auto variant = sfcxx::JSON::decode(json);
 
-    return new sfcxx::JSONValue(variant);
+        return new sfcxx::JSONValue(std::move(variant));
+    } catch (const std::exception&) {
+        return nullptr;
+    }
 }
 
 void free_json(JSONVariant value) {
@@ -0,0 +1,56 @@
+//===-- _SFCxxUtils/SFCxxJSONBinding.cpp - Typed JSON Binding ---*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the non-template parts of `JSONBind`.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONBinding.h"
+
+#include <stdexcept>
+
+namespace sfcxx {
+
+void JSONBind::copyString(std::string_view value, char* buffer, size_t capacity) {
+    size_t length = value.size();
+    if (length >= capacity) {
+        length = capacity - 1;
+        while (length > 0 && (static_cast<unsigned char>(value[length]) & 0xc0) == 0x80) {
+            --length;                                                       // Do not split a UTF-8 sequence
+        }
+    }
+    std::memcpy(buffer, value.data(), length);
+    buffer[length] = '\0';
+}
+
+void JSONBind::mismatch(std::string_view key, const char* expected) {
+    throw std::runtime_error("JSONBind: \"" + std::string(key) + "\" must be " + expected);
+}
+
+} // namespace sfcxx
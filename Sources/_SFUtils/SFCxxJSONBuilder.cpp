@@ -0,0 +1,233 @@
+//===-- _SFCxxUtils/SFCxxJSONBuilder.cpp - C JSON Builder -------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the `JSONBuilder` C API, which writes JSON text without
+///        building JSON variants, and the `JSONBuilderSink` used by C++ writers.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCJSON.h"
+#include "include/SFCxxJSON.h"
+#include "include/SFCxxJSONBuilder.h"
+#include "include/SFCxxJSONNumber.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+/// Makes room for `extra` more bytes plus a terminator. Returns false if they do not fit.
+bool reserve(JSONBuilder* builder, size_t extra) {
+    size_t needed = builder->length + extra + 1;
+    if (needed <= builder->capacity) {
+        return true;
+    }
+    if (!builder->growable) {
+        builder->error = 1;
+        return false;
+    }
+
+    size_t capacity = builder->capacity > 64 ? builder->capacity : 64;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    char* data = static_cast<char*>(builder->allocated ? std::realloc(builder->data, capacity) : std::malloc(capacity));
+    if (data == nullptr) {
+        builder->error = 1;
+        return false;
+    }
+    if (!builder->allocated && builder->length > 0) {
+        std::memcpy(data, builder->data, builder->length);                  // Leave the caller's buffer behind
+    }
+    builder->data = data;
+    builder->capacity = capacity;
+    builder->allocated = 1;
+    return true;
+}
+
+inline void write(JSONBuilder* builder, const char* bytes, size_t length) {
+    sfcxx::JSONBuilderSink(builder).write(bytes, length);
+}
+
+inline void put(JSONBuilder* builder, char c) {
+    sfcxx::JSONBuilderSink(builder).put(c);
+}
+
+/// Writes a quoted string, escaping quotes, backslashes and control characters.
+void writeString(JSONBuilder* builder, const char* value) {
+    sfcxx::JSONBuilderSink sink(builder);
+    sink.put('"');
+    sfcxx::JSON::escapeTo(value, sink);
+    sink.put('"');
+}
+
+/// Writes the separator that precedes a new value or key at the current depth.
+void beginItem(JSONBuilder* builder, bool isKey) {
+    if (builder->depth == 0) {
+        if (builder->length > 0 || isKey) builder->error = 1;                // One root value, no keys
+        return;
+    }
+    unsigned long long bit = 1ULL << (builder->depth - 1);
+    bool inObject = (builder->isObject & bit) != 0;
+    if (builder->afterKey) {
+        if (isKey) builder->error = 1;                                      // A key cannot follow a key
+        builder->afterKey = 0;
+        return;
+    }
+    if (inObject != isKey) {
+        builder->error = 1;                                                 // Object values need keys, arrays have none
+    }
+    if (builder->hasItems & bit) {
+        put(builder, ',');
+    }
+    builder->hasItems |= bit;
+}
+
+void beginContainer(JSONBuilder* builder, bool isObject) {
+    beginItem(builder, false);
+    if (builder->depth == JSON_BUILDER_MAX_DEPTH) {
+        builder->error = 1;
+        return;
+    }
+    unsigned long long bit = 1ULL << builder->depth;
+    builder->hasItems &= ~bit;
+    builder->isObject = isObject ? builder->isObject | bit : builder->isObject & ~bit;
+    ++builder->depth;
+    put(builder, isObject ? '{' : '[');
+}
+
+void endContainer(JSONBuilder* builder, bool isObject) {
+    if (builder->depth == 0 || builder->afterKey ||
+        ((builder->isObject >> (builder->depth - 1)) & 1) != static_cast<unsigned long long>(isObject)) {
+        builder->error = 1;
+        return;
+    }
+    --builder->depth;
+    put(builder, isObject ? '}' : ']');
+}
+
+} // namespace
+
+namespace sfcxx {
+
+JSONBuilderSink JSONBuilderSink::beginValue(JSONBuilder* builder) {
+    beginItem(builder, false);
+    return JSONBuilderSink(builder);
+}
+
+void JSONBuilderSink::writeSlow(const char* bytes, size_t length) {
+    if (reserve(builder, length)) {
+        std::memcpy(builder->data + builder->length, bytes, length);
+    }
+    builder->length += length;
+}
+
+} // namespace sfcxx
+
+extern "C" {
+void json_builder_init(JSONBuilder* builder, char* buffer, size_t capacity, int growable) {
+    std::memset(builder, 0, sizeof(*builder));
+    builder->data = buffer;
+    builder->capacity = buffer != nullptr ? capacity : 0;
+    builder->growable = growable;
+}
+
+void json_builder_begin_object(JSONBuilder* builder) {
+    beginContainer(builder, true);
+}
+
+void json_builder_end_object(JSONBuilder* builder) {
+    endContainer(builder, true);
+}
+
+void json_builder_begin_array(JSONBuilder* builder) {
+    beginContainer(builder, false);
+}
+
+void json_builder_end_array(JSONBuilder* builder) {
+    endContainer(builder, false);
+}
+
+void json_builder_key(JSONBuilder* builder, const char* key) {
+    beginItem(builder, true);
+    writeString(builder, key);
+    put(builder, ':');
+    builder->afterKey = 1;
+}
+
+void json_builder_string(JSONBuilder* builder, const char* value) {
+    beginItem(builder, false);
+    writeString(builder, value);
+}
+
+void json_builder_number(JSONBuilder* builder, double value) {
+    beginItem(builder, false);
+    char buffer[sfcxx::JSONNumber::kMaxFormattedLength];
+    write(builder, buffer, sfcxx::JSONNumber::format(value, buffer));
+}
+
+void json_builder_bool(JSONBuilder* builder, int value) {
+    beginItem(builder, false);
+    if (value) {
+        write(builder, "true", 4);
+    } else {
+        write(builder, "false", 5);
+    }
+}
+
+void json_builder_null(JSONBuilder* builder) {
+    beginItem(builder, false);
+    write(builder, "null", 4);
+}
+
+void json_builder_raw(JSONBuilder* builder, const char* json, size_t length) {
+    sfcxx::JSONBuilderSink::beginValue(builder).write(json, length);
+}
+
+long json_builder_finish(JSONBuilder* builder) {
+    if (builder->depth != 0 || builder->afterKey || builder->length == 0) {
+        builder->error = 1;
+    }
+    if (builder->length < builder->capacity) {
+        builder->data[builder->length] = '\0';
+    } else if (builder->capacity > 0) {
+        builder->data[builder->capacity - 1] = '\0';                        // Truncated
+    }
+    return builder->error ? -1 : static_cast<long>(builder->length);
+}
+
+void json_builder_free(JSONBuilder* builder) {
+    if (builder->allocated) {
+        std::free(builder->data);
+    }
+    builder->data = nullptr;
+    builder->capacity = 0;
+    builder->allocated = 0;
+}
+}
@@ -0,0 +1,459 @@
+//===-- _SFCxxUtils/SFCxxJSONDocument.cpp - On-Demand JSON ------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements on-demand access to the values of a JSON document.
+///
+/// Validation walks the structural index once with the same grammar states as
+/// `JSONReader` and stores, for every container, the index of its closing
+/// structural. Skipping a value is then a single lookup, whatever its size.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONDocument.h"
+#include "include/SFCxxJSONNumber.h"
+#include "include/SFCJSON.h"
+
+#include <cctype>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace sfcxx {
+
+namespace {
+
+/// What the grammar allows at the current structural.
+enum class State {
+    VALUE,
+    FIRST_KEY_OR_END,
+    KEY,
+    COLON,
+    FIRST_VALUE_OR_END,
+    COMMA_OR_END,
+    DONE
+};
+
+[[noreturn]] void fail(const char* what, size_t offset) {
+    throw std::runtime_error("Malformed JSON at offset " + std::to_string(offset) + ": " + what);
+}
+
+[[noreturn]] void typeMismatch(const char* expected, size_t offset) {
+    throw std::runtime_error("JSON value at offset " + std::to_string(offset) + " is not " + expected);
+}
+
+inline bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/// Returns the string whose opening quote is at `quote`. The document has been validated.
+JSONLazyString stringAt(std::string_view text, size_t quote) {
+    size_t start = quote + 1;
+    size_t pos = start;
+    bool escapes = false;
+    while (true) {
+        size_t end = JSONScanner::findQuoteOrBackslash(text.data(), pos, text.size());
+        if (text[end] == '"') {
+            return JSONLazyString(text.substr(start, end - start), escapes);
+        }
+        escapes = true;
+        pos = end + 2;                                                      // Skip the escaped character
+    }
+}
+
+/// Checks every escape sequence in the string at `quote` so that the lazy
+/// `JSON::unescape` of a loaded document cannot fail.
+void validateEscapes(std::string_view text, size_t quote) {
+    size_t pos = quote + 1;
+    while (true) {
+        size_t end = JSONScanner::findQuoteOrBackslash(text.data(), pos, text.size());
+        if (text[end] == '"') {
+            return;
+        }
+        pos = end + 2;
+        switch (text[end + 1]) {
+            case '"': case '\\': case '/':
+            case 'b': case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                for (size_t i = pos; i < pos + 4; ++i) {
+                    if (i >= text.size() || !std::isxdigit(static_cast<unsigned char>(text[i]))) {
+                        fail("invalid \\u escape", end);
+                    }
+                }
+                pos += 4;
+                break;
+            default:
+                fail("invalid escape sequence", end);
+        }
+    }
+}
+
+} // namespace
+
+#pragma mark - JSONDocument
+
+void JSONDocument::load(std::string_view json) {
+    text = json;
+    try {
+        JSONScanner::buildIndex(json.data(), json.size(), index);
+        if (index.unterminatedString) {
+            throw std::runtime_error("Malformed JSON: unterminated string");
+        }
+        validate();
+    } catch (...) {
+        text = std::string_view();
+        index.positions.clear();
+        closing.clear();
+        throw;
+    }
+}
+
+size_t JSONDocument::skip(size_t i) const {
+    char c = text[index.positions[i]];
+    return c == '{' || c == '[' ? closing[i] + 1 : i + 1;
+}
+
+void JSONDocument::validate() {
+    const char* data = text.data();
+    size_t length = text.size();
+    const std::vector<uint32_t>& positions = index.positions;
+    size_t count = positions.size();
+
+    closing.resize(count);
+    std::vector<uint32_t> open;                                             // Indices of the open containers
+    State state = State::VALUE;
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t offset = positions[i];
+        char c = data[offset];
+        switch (state) {
+            case State::DONE:
+                fail("unexpected trailing characters", offset);
+
+            case State::COLON:
+                if (c != ':') fail("expected ':'", offset);
+                state = State::VALUE;
+                continue;
+
+            case State::COMMA_OR_END: {
+                bool inObject = data[positions[open.back()]] == '{';
+                if (c == ',') {
+                    state = inObject ? State::KEY : State::VALUE;
+                    continue;
+                }
+                if (c != (inObject ? '}' : ']')) {
+                    fail(inObject ? "expected ',' or '}'" : "expected ',' or ']'", offset);
+                }
+                break;
+            }
+
+            case State::FIRST_KEY_OR_END:
+                if (c == '}') break;
+                [[fallthrough]];
+
+            case State::KEY:
+                if (c != '"') fail("expected an object key", offset);
+                validateEscapes(text, offset);
+                state = State::COLON;
+                continue;
+
+            case State::FIRST_VALUE_OR_END:
+                if (c == ']') break;
+                [[fallthrough]];
+
+            case State::VALUE: {
+                if (c == '{' || c == '[') {
+                    open.push_back(static_cast<uint32_t>(i));
+                    state = c == '{' ? State::FIRST_KEY_OR_END : State::FIRST_VALUE_OR_END;
+                    continue;
+                }
+
+                size_t next = i + 1 < count ? positions[i + 1] : length;
+                size_t end = offset + 1;
+                if (c == 't' || c == 'f' || c == 'n') {
+                    const char* literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+                    end = offset + std::strlen(literal);
+                    if (end > length || std::memcmp(data + offset, literal, end - offset) != 0) {
+                        fail("invalid literal", offset);
+                    }
+                } else if (c == '-' || (c >= '0' && c <= '9')) {
+                    double value;
+                    const char* last = JSONNumber::parse(data + offset, data + length, value);
+                    if (last == nullptr) fail("invalid number", offset);
+                    end = static_cast<size_t>(last - data);
+                } else if (c == '"') {
+                    validateEscapes(text, offset);
+                } else {
+                    fail("expected a value", offset);
+                }
+                if (c != '"' && end < next && !isWhitespace(data[end])) {
+                    fail(c == 't' || c == 'f' || c == 'n' ? "invalid literal" : "invalid number", offset);
+                }
+                state = open.empty() ? State::DONE : State::COMMA_OR_END;
+                continue;
+            }
+        }
+
+        closing[open.back()] = static_cast<uint32_t>(i);                    // Reached a matching '}' or ']'
+        open.pop_back();
+        state = open.empty() ? State::DONE : State::COMMA_OR_END;
+    }
+
+    if (state != State::DONE) {
+        fail("unexpected end of input", length);
+    }
+}
+
+#pragma mark - JSONElement
+
+char JSONElement::character() const {
+    return document->text[document->index.positions[index]];
+}
+
+size_t JSONElement::offset() const {
+    return document->index.positions[index];
+}
+
+JSONType JSONElement::type() const {
+    if (document == nullptr) {
+        return JSONType::MISSING;
+    }
+    switch (character()) {
+        case '{': return JSONType::OBJECT;
+        case '[': return JSONType::ARRAY;
+        case '"': return JSONType::STRING;
+        case 't':
+        case 'f': return JSONType::BOOL;
+        case 'n': return JSONType::NUL;
+        default:  return JSONType::NUMBER;
+    }
+}
+
+JSONElement JSONElement::operator[](std::string_view key) const {
+    if (type() != JSONType::OBJECT) {
+        return JSONElement();
+    }
+    // Members are only linked forwards, so keep the last match as `JSON::decode` does.
+    JSONElement found;
+    for (JSONElement member = first(); member; member = member.nextSibling()) {
+        if (member.key() == key) {
+            found = member;
+        }
+    }
+    return found;
+}
+
+JSONElement JSONElement::at(size_t position) const {
+    if (type() != JSONType::ARRAY) {
+        return JSONElement();
+    }
+    JSONElement element = first();
+    for (; element && position != 0; --position) {
+        element = element.nextSibling();
+    }
+    return element;
+}
+
+size_t JSONElement::size() const {
+    size_t count = 0;
+    for (JSONElement element = first(); element; element = element.nextSibling()) {
+        ++count;
+    }
+    return count;
+}
+
+JSONElement JSONElement::first() const {
+    JSONType kind = type();
+    if (kind != JSONType::OBJECT && kind != JSONType::ARRAY) {
+        return JSONElement();
+    }
+    if (document->closing[index] == index + 1) {
+        return JSONElement();                                               // Empty container
+    }
+    return JSONElement(document, kind == JSONType::OBJECT ? index + 3 : index + 1);   // Skip key and ':'
+}
+
+JSONElement JSONElement::nextSibling() const {
+    if (document == nullptr) {
+        return JSONElement();
+    }
+    const auto& positions = document->index.positions;
+    size_t next = document->skip(index);
+    if (next >= positions.size() || document->text[positions[next]] != ',') {
+        return JSONElement();
+    }
+    bool member = index >= 2 && document->text[positions[index - 1]] == ':';
+    return JSONElement(document, member ? next + 3 : next + 1);
+}
+
+JSONLazyString JSONElement::key() const {
+    if (document == nullptr || index < 2 || document->text[document->index.positions[index - 1]] != ':') {
+        throw std::runtime_error("JSON value is not an object member");
+    }
+    return stringAt(document->text, document->index.positions[index - 2]);
+}
+
+JSONLazyString JSONElement::getString() const {
+    if (type() != JSONType::STRING) {
+        typeMismatch("a string", document ? offset() : 0);
+    }
+    return stringAt(document->text, offset());
+}
+
+double JSONElement::getNumber() const {
+    if (type() != JSONType::NUMBER) {
+        typeMismatch("a number", document ? offset() : 0);
+    }
+    double value;
+    JSONNumber::parse(document->text.data() + offset(), document->text.data() + document->text.size(), value);
+    return value;
+}
+
+bool JSONElement::getBool() const {
+    if (type() != JSONType::BOOL) {
+        typeMismatch("a boolean", document ? offset() : 0);
+    }
+    return character() == 't';
+}
+
+std::string_view JSONElement::raw() const {
+    if (document == nullptr) {
+        return std::string_view();
+    }
+    std::string_view text = document->text;
+    size_t start = offset();
+    size_t end;
+    switch (character()) {
+        case '{':
+        case '[':
+            end = document->index.positions[document->closing[index]] + 1;
+            break;
+        case '"': {
+            std::string_view body = stringAt(text, start).raw();
+            end = static_cast<size_t>(body.data() - text.data()) + body.size() + 1;
+            break;
+        }
+        case 't':
+        case 'n':
+            end = start + 4;
+            break;
+        case 'f':
+            end = start + 5;
+            break;
+        default: {
+            double value;
+            end = static_cast<size_t>(JSONNumber::parse(text.data() + start, text.data() + text.size(), value) - text.data());
+            break;
+        }
+    }
+    return text.substr(start, end - start);
+}
+
+} // namespace sfcxx
+
+namespace {
+
+/// Follows a dot-separated member path from the root of `document`.
+sfcxx::JSONElement elementAtPath(JSONDocument document, const char* path) {
+    sfcxx::JSONElement element = static_cast<const sfcxx::JSONDocument*>(document)->root();
+    while (element && *path != '\0') {
+        const char* dot = std::strchr(path, '.');
+        size_t length = dot ? static_cast<size_t>(dot - path) : std::strlen(path);
+        element = element[std::string_view(path, length)];
+        path += dot ? length + 1 : length;
+    }
+    return element;
+}
+
+} // namespace
+
+extern "C" {
+JSONDocument json_document_create(void) {
+    return new (std::nothrow) sfcxx::JSONDocument();
+}
+
+int json_document_load(JSONDocument document, const char* json, size_t length) {
+    try {
+        static_cast<sfcxx::JSONDocument*>(document)->load(std::string_view(json, length));
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+long json_document_get_string(JSONDocument document, const char* path, char* buffer, size_t capacity) {
+    try {
+        sfcxx::JSONElement element = elementAtPath(document, path);
+        if (element.type() != sfcxx::JSONType::STRING) {
+            return -1;
+        }
+        sfcxx::JSONLazyString string = element.getString();                 // Owns the unescaped text
+        std::string_view value = string.value();
+        if (capacity > 0) {
+            size_t copied = value.size() < capacity ? value.size() : capacity - 1;
+            std::memcpy(buffer, value.data(), copied);
+            buffer[copied] = '\0';
+        }
+        return static_cast<long>(value.size());
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+int json_document_get_number(JSONDocument document, const char* path, double* value) {
+    try {
+        sfcxx::JSONElement element = elementAtPath(document, path);
+        if (element.type() != sfcxx::JSONType::NUMBER) {
+            return -1;
+        }
+        *value = element.getNumber();
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+int json_document_get_bool(JSONDocument document, const char* path, int* value) {
+    try {
+        sfcxx::JSONElement element = elementAtPath(document, path);
+        if (element.type() != sfcxx::JSONType::BOOL) {
+            return -1;
+        }
+        *value = element.getBool() ? 1 : 0;
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+void json_document_free(JSONDocument document) {
+    delete static_cast<sfcxx::JSONDocument*>(document);
+}
+}
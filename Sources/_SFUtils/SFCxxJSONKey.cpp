@@ -0,0 +1,119 @@
+//===-- _SFCxxUtils/SFCxxJSONKey.cpp - Interned JSON Keys -------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the process-wide key table behind `JSONKey`.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONKey.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace sfcxx {
+
+/// \brief The process-wide table of interned keys.
+///
+/// The table is split into shards with their own lock so that threads decoding
+/// in parallel rarely contend. In front of it, each thread keeps a small
+/// direct-mapped cache of recently seen entries, so the common case of a key
+/// that was just decoded takes no lock at all. Entries are never freed, which
+/// is what makes the unsynchronised cache reads safe.
+class JSONKeyTable {
+public:
+    using Entry = JSONKey::Entry;
+
+    static const Entry* find(std::string_view text, size_t hash) {
+        CacheSlot& slot = cache[hash & (kCacheSize - 1)];
+        if (slot.entry != nullptr && slot.hash == hash && slot.entry->text == text) {
+            return slot.entry;
+        }
+
+        Shard& shard = shards()[(hash >> 8) & (kShardCount - 1)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.keys.find(text);
+        if (it == shard.keys.end()) {
+            if (count.fetch_add(1, std::memory_order_relaxed) >= JSONKey::kMaxInternedKeys) {
+                count.fetch_sub(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            const Entry* entry = new Entry{std::string(text), hash};
+            it = shard.keys.emplace(entry->text, entry).first;          // Keyed by a view of the entry's own text
+        }
+        slot = {it->second, hash};
+        return it->second;
+    }
+
+    static size_t size() { return count.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kShardCount = 16;
+    static constexpr size_t kCacheSize = 256;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, const Entry*> keys;
+    };
+
+    struct CacheSlot {
+        const Entry* entry;
+        size_t hash;
+    };
+
+    static std::array<Shard, kShardCount>& shards() {
+        static auto* table = new std::array<Shard, kShardCount>();          // Never destroyed, like its entries
+        return *table;
+    }
+
+    static std::atomic<size_t> count;
+    static thread_local std::array<CacheSlot, kCacheSize> cache;
+};
+
+std::atomic<size_t> JSONKeyTable::count{0};
+thread_local std::array<JSONKeyTable::CacheSlot, JSONKeyTable::kCacheSize> JSONKeyTable::cache{};
+
+JSONKey::JSONKey() : JSONKey(std::string_view()) {}
+
+JSONKey::JSONKey(std::string_view text) {
+    size_t hash = std::hash<std::string_view>()(text);
+    entry = text.size() <= kMaxInternedLength ? JSONKeyTable::find(text, hash) : nullptr;
+    if (entry == nullptr) {
+        owner = std::make_shared<const Entry>(Entry{std::string(text), hash});
+        entry = owner.get();
+    }
+}
+
+size_t JSONKey::internedCount() {
+    return JSONKeyTable::size();
+}
+
+} // namespace sfcxx
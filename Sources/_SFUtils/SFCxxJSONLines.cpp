@@ -0,0 +1,273 @@
+//===-- _SFCxxUtils/SFCxxJSONLines.cpp - NDJSON Batches ---------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements NDJSON batches and the worker pool that decodes them.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONLines.h"
+#include "include/SFCJSON.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace sfcxx {
+
+namespace {
+
+/// \brief A fixed set of threads that help callers run batches of independent tasks.
+///
+/// One batch runs at a time. A caller that finds the pool busy, for example
+/// because it is itself running inside a batch, runs its tasks on its own.
+/// The pool is created on first use and lives until the process exits.
+class WorkerPool {
+public:
+    static WorkerPool& shared() {
+        static WorkerPool* pool = new WorkerPool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return *pool;
+    }
+
+    size_t size() const { return workers.size(); }
+
+    /// Runs `task(0)` to `task(count - 1)` on the caller and at most `helpers`
+    /// workers, and returns once all of them have finished. `task` must not throw.
+    void run(size_t count, size_t helpers, const std::function<void(size_t)>& task) {
+        std::unique_lock<std::mutex> exclusive(running, std::try_to_lock);
+        if (!exclusive.owns_lock() || helpers == 0 || workers.empty()) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        Batch current{&task, count, std::min(helpers, workers.size())};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch = &current;
+            ++generation;
+        }
+        wake.notify_all();
+
+        work(current);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        batch = nullptr;                                                    // Late workers must not join
+        done.wait(lock, [&] { return current.active == 0; });
+    }
+
+private:
+    struct Batch {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        size_t helpers;                 ///< Workers that may still join; guarded by `mutex`.
+        size_t active = 0;              ///< Workers currently running tasks; guarded by `mutex`.
+        std::atomic<size_t> next{0};    ///< Next task index to hand out.
+
+        Batch(const std::function<void(size_t)>* task, size_t count, size_t helpers)
+            : task(task), count(count), helpers(helpers) {}
+    };
+
+    explicit WorkerPool(size_t count) {
+        workers.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            workers.emplace_back([this] { loop(); });
+        }
+    }
+
+    static void work(Batch& current) {
+        for (size_t i = current.next.fetch_add(1); i < current.count; i = current.next.fetch_add(1)) {
+            (*current.task)(i);
+        }
+    }
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t seen = 0;
+        for (;;) {
+            wake.wait(lock, [&] { return generation != seen; });
+            seen = generation;
+            Batch* current = batch;
+            if (current == nullptr || current->helpers == 0) {
+                continue;
+            }
+            --current->helpers;
+            ++current->active;
+
+            lock.unlock();
+            work(*current);
+            lock.lock();
+
+            if (--current->active == 0) {
+                done.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex running;                 ///< Held by the caller whose batch is running.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    Batch* batch = nullptr;
+    uint64_t generation = 0;
+};
+
+/// A byte range of the input that starts at the beginning of a line.
+struct Chunk {
+    std::string_view text;
+    std::vector<JSONVariant> records;
+    std::exception_ptr error;
+    size_t errorLine = 0;               ///< Zero-based line of `error` within the chunk.
+};
+
+bool isBlank(std::string_view line) {
+    for (char c : line) {
+        if (c != ' ' && c != '\t' && c != '\r') return false;
+    }
+    return true;
+}
+
+void decodeChunk(Chunk& chunk) {
+    std::string_view rest = chunk.text;
+    for (size_t line = 0; !rest.empty(); ++line) {
+        const char* newline = static_cast<const char*>(std::memchr(rest.data(), '\n', rest.size()));
+        size_t length = newline ? static_cast<size_t>(newline - rest.data()) : rest.size();
+        std::string_view record = rest.substr(0, length);
+        rest.remove_prefix(newline ? length + 1 : length);
+
+        if (!record.empty() && record.back() == '\r') {
+            record.remove_suffix(1);
+        }
+        if (isBlank(record)) {
+            continue;
+        }
+        try {
+            chunk.records.push_back(JSON::decode(record));
+        } catch (...) {
+            chunk.error = std::current_exception();
+            chunk.errorLine = line;
+            return;
+        }
+    }
+}
+
+/// Splits `data` into at most `count` chunks of similar size, each ending after a newline.
+std::vector<Chunk> split(std::string_view data, size_t count) {
+    std::vector<Chunk> chunks;
+    chunks.reserve(count);
+    size_t start = 0;
+    for (size_t i = 1; i <= count && start < data.size(); ++i) {
+        size_t end = data.size();
+        if (i < count) {
+            size_t target = std::max(start, data.size() / count * i);
+            const void* newline = std::memchr(data.data() + target, '\n', data.size() - target);
+            end = newline ? static_cast<const char*>(newline) - data.data() + 1 : data.size();
+        }
+        chunks.emplace_back();
+        chunks.back().text = data.substr(start, end - start);
+        start = end;
+    }
+    return chunks;
+}
+
+} // namespace
+
+std::vector<JSONVariant> JSONLines::decode(std::string_view data, size_t threads) {
+    WorkerPool& pool = WorkerPool::shared();
+    if (threads == 0) {
+        threads = pool.size() + 1;
+    }
+
+    size_t count = std::max<size_t>(1, std::min(threads * 4, data.size() / kMinChunkSize));
+    std::vector<Chunk> chunks = split(data, count);
+    pool.run(chunks.size(), threads - 1, [&chunks](size_t i) { decodeChunk(chunks[i]); });
+
+    size_t total = 0;
+    for (const Chunk& chunk : chunks) {
+        if (chunk.error) {
+            size_t line = static_cast<size_t>(std::count(data.data(), chunk.text.data(), '\n')) + chunk.errorLine + 1;
+            try {
+                std::rethrow_exception(chunk.error);
+            } catch (const std::exception& error) {
+                throw std::runtime_error("Malformed NDJSON on line " + std::to_string(line) + ": " + error.what());
+            }
+        }
+        total += chunk.records.size();
+    }
+
+    std::vector<JSONVariant> records;
+    records.reserve(total);
+    for (Chunk& chunk : chunks) {
+        std::move(chunk.records.begin(), chunk.records.end(), std::back_inserter(records));
+    }
+    return records;
+}
+
+std::string JSONLines::encode(const std::vector<JSONVariant>& records) {
+    size_t total = 0;
+    for (const JSONVariant& record : records) {
+        total += JSON::encodedSize(record) + 1;
+    }
+
+    std::string result(total, '\0');
+    size_t length = 0;
+    for (const JSONVariant& record : records) {
+        length += JSON::encode(record, &result[length], total - length);
+        result[length++] = '\n';
+    }
+    return result;
+}
+
+} // namespace sfcxx
+
+extern "C" {
+JSONVariant json_decode_lines(const char* data, size_t length) {
+    try {
+        std::vector<sfcxx::JSONVariant> records = sfcxx::JSONLines::decode(std::string_view(data, length));
+
+        std::vector<std::shared_ptr<sfcxx::JSONValue>> array;
+        array.reserve(records.size());
+        for (sfcxx::JSONVariant& record : records) {
+            array.push_back(std::make_shared<sfcxx::JSONValue>(std::move(record)));
+        }
+        return new sfcxx::JSONValue(std::move(array));
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+}
@@ -0,0 +1,177 @@
+//===-- _SFCxxUtils/SFCxxJSONNumber.cpp - JSON Number Codec -----*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the allocation-free number codec used by the JSON encoder and decoder.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONNumber.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace sfcxx {
+
+namespace {
+
+/// Powers of ten that are exactly representable as doubles.
+constexpr double kExactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+constexpr uint64_t kMaxExactMantissa = 1ULL << 53;
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/// Converts text with a terminator through `strtod`, which reports range errors in `errno`.
+double parseTerminated(const char* first, const char* last, bool& overflow) {
+    char buffer[64];
+    size_t length = static_cast<size_t>(last - first);
+    double value;
+    errno = 0;
+    if (length < sizeof(buffer)) {
+        std::memcpy(buffer, first, length);
+        buffer[length] = '\0';
+        value = std::strtod(buffer, nullptr);
+    } else {
+        value = std::strtod(std::string(first, last).c_str(), nullptr);
+    }
+    // ERANGE is also raised on underflow, where strtod returns the nearest subnormal or zero.
+    overflow = errno == ERANGE && std::isinf(value);
+    return value;
+}
+
+/// Converts already validated number text that the fast path could not handle.
+///
+/// Returns `false` if the magnitude is too large for a `double`. Values too small
+/// to represent round to the nearest subnormal or signed zero.
+bool parseSlow(const char* first, const char* last, double& value) {
+    bool overflow = false;
+#if defined(__cpp_lib_to_chars)
+    if (std::from_chars(first, last, value).ec == std::errc::result_out_of_range) {
+        // Rare: let strtod tell overflow apart from underflow and round the latter.
+        value = parseTerminated(first, last, overflow);
+    }
+#else
+    // Standard libraries without floating-point from_chars.
+    value = parseTerminated(first, last, overflow);
+#endif
+    return !overflow;
+}
+
+} // namespace
+
+const char* JSONNumber::parse(const char* first, const char* last, double& value) {
+    const char* p = first;
+    bool negative = p < last && *p == '-';
+    if (negative) ++p;
+
+    uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool truncated = false;
+
+    auto accumulate = [&](char c, bool fraction) {
+        unsigned digit = static_cast<unsigned>(c - '0');
+        if (mantissa == 0 && digit == 0) {
+            if (fraction) --exponent;
+        } else if (significantDigits < 19) {
+            mantissa = mantissa * 10 + digit;
+            ++significantDigits;
+            if (fraction) --exponent;
+        } else {
+            truncated = true;
+        }
+    };
+
+    if (p == last || !isDigit(*p)) return nullptr;
+    if (*p == '0') {
+        ++p;                                                                // No leading zeros
+    } else {
+        while (p < last && isDigit(*p)) accumulate(*p++, false);
+    }
+
+    if (p < last && *p == '.') {
+        ++p;
+        if (p == last || !isDigit(*p)) return nullptr;
+        while (p < last && isDigit(*p)) accumulate(*p++, true);
+    }
+
+    if (p < last && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p < last && (*p == '+' || *p == '-')) {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        if (p == last || !isDigit(*p)) return nullptr;
+        int explicitExponent = 0;
+        while (p < last && isDigit(*p)) {
+            if (explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (*p - '0');
+            ++p;
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    // Exact when both the mantissa and the power of ten are exact doubles.
+    if (!truncated && mantissa <= kMaxExactMantissa && exponent >= -22 && exponent <= 22) {
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / kExactPowersOfTen[-exponent] : result * kExactPowersOfTen[exponent];
+        value = negative ? -result : result;
+    } else if (!parseSlow(first, p, value)) {
+        return nullptr;
+    }
+    return p;
+}
+
+size_t JSONNumber::format(double value, char* buffer) {
+    if (!std::isfinite(value)) {
+        std::memcpy(buffer, "null", 4);
+        return 4;
+    }
+
+    if (value == std::trunc(value) && std::fabs(value) < static_cast<double>(kMaxExactMantissa) &&
+        !(value == 0 && std::signbit(value))) {
+        auto result = std::to_chars(buffer, buffer + kMaxFormattedLength, static_cast<int64_t>(value));
+        return static_cast<size_t>(result.ptr - buffer);
+    }
+
+    auto result = std::to_chars(buffer, buffer + kMaxFormattedLength, value);
+    return static_cast<size_t>(result.ptr - buffer);
+}
+
+} // namespace sfcxx
@@ -0,0 +1,199 @@
+//===-- _SFCxxUtils/SFCxxJSONObject.cpp - Ordered JSON Objects --*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the insertion-ordered object type used by `JSONVariant`.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONObject.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace sfcxx {
+
+JSONObject::JSONObject(std::initializer_list<std::pair<std::string_view, std::shared_ptr<JSONValue>>> members) {
+    entries.reserve(members.size());
+    for (const auto& member : members) {
+        insert_or_assign(member.first, member.second);
+    }
+}
+
+void JSONObject::clear() {
+    entries.clear();
+    slots.clear();
+}
+
+JSONObject::iterator JSONObject::find(std::string_view key) {
+    size_t pos = position(key);
+    return pos == kNotFound ? entries.end() : entries.begin() + pos;
+}
+
+JSONObject::const_iterator JSONObject::find(std::string_view key) const {
+    size_t pos = position(key);
+    return pos == kNotFound ? entries.end() : entries.begin() + pos;
+}
+
+JSONObject::iterator JSONObject::find(const JSONKey& key) {
+    size_t pos = position(key);
+    return pos == kNotFound ? entries.end() : entries.begin() + pos;
+}
+
+JSONObject::const_iterator JSONObject::find(const JSONKey& key) const {
+    size_t pos = position(key);
+    return pos == kNotFound ? entries.end() : entries.begin() + pos;
+}
+
+std::shared_ptr<JSONValue>& JSONObject::operator[](std::string_view key) {
+    size_t pos = position(key);
+    if (pos != kNotFound) {
+        return entries[pos].second;
+    }
+    return append(JSONKey(key), nullptr)->second;
+}
+
+std::shared_ptr<JSONValue>& JSONObject::at(std::string_view key) {
+    size_t pos = position(key);
+    if (pos == kNotFound) {
+        throw std::out_of_range("JSONObject::at: no member named \"" + std::string(key) + "\"");
+    }
+    return entries[pos].second;
+}
+
+const std::shared_ptr<JSONValue>& JSONObject::at(std::string_view key) const {
+    return const_cast<JSONObject*>(this)->at(key);
+}
+
+std::pair<JSONObject::iterator, bool> JSONObject::insert_or_assign(std::string_view key, std::shared_ptr<JSONValue> value) {
+    return insert_or_assign(JSONKey(key), std::move(value));
+}
+
+std::pair<JSONObject::iterator, bool> JSONObject::insert_or_assign(JSONKey key, std::shared_ptr<JSONValue> value) {
+    size_t pos = position(key);
+    if (pos != kNotFound) {
+        entries[pos].second = std::move(value);
+        return {entries.begin() + pos, false};
+    }
+    return {append(std::move(key), std::move(value)), true};
+}
+
+std::pair<JSONObject::iterator, bool> JSONObject::emplace(std::string_view key, std::shared_ptr<JSONValue> value) {
+    return emplace(JSONKey(key), std::move(value));
+}
+
+std::pair<JSONObject::iterator, bool> JSONObject::emplace(JSONKey key, std::shared_ptr<JSONValue> value) {
+    size_t pos = position(key);
+    if (pos != kNotFound) {
+        return {entries.begin() + pos, false};
+    }
+    return {append(std::move(key), std::move(value)), true};
+}
+
+size_t JSONObject::erase(std::string_view key) {
+    size_t pos = position(key);
+    if (pos == kNotFound) {
+        return 0;
+    }
+    entries.erase(entries.begin() + pos);
+    if (!slots.empty()) {
+        rebuildIndex();                                                     // Positions after `pos` have shifted
+    }
+    return 1;
+}
+
+size_t JSONObject::position(std::string_view key) const {
+    if (slots.empty()) {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].first == key) return i;
+        }
+        return kNotFound;
+    }
+
+    size_t mask = slots.size() - 1;
+    for (size_t i = std::hash<std::string_view>()(key) & mask; slots[i] != 0; i = (i + 1) & mask) {
+        size_t pos = slots[i] - 1;
+        if (entries[pos].first == key) return pos;
+    }
+    return kNotFound;
+}
+
+size_t JSONObject::position(const JSONKey& key) const {
+    if (slots.empty()) {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].first == key) return i;
+        }
+        return kNotFound;
+    }
+
+    size_t mask = slots.size() - 1;
+    for (size_t i = key.hash() & mask; slots[i] != 0; i = (i + 1) & mask) {
+        size_t pos = slots[i] - 1;
+        if (entries[pos].first == key) return pos;
+    }
+    return kNotFound;
+}
+
+JSONObject::iterator JSONObject::append(JSONKey key, std::shared_ptr<JSONValue> value) {
+    entries.emplace_back(std::move(key), std::move(value));
+    if (entries.size() > kIndexThreshold) {
+        if (entries.size() * 2 > slots.size()) {
+            rebuildIndex();                                                 // Keep the load factor below 1/2
+        } else {
+            indexEntry(entries.size() - 1);
+        }
+    }
+    return entries.end() - 1;
+}
+
+void JSONObject::indexEntry(size_t pos) {
+    size_t mask = slots.size() - 1;
+    size_t i = entries[pos].first.hash() & mask;
+    while (slots[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = static_cast<uint32_t>(pos + 1);
+}
+
+void JSONObject::rebuildIndex() {
+    if (entries.size() <= kIndexThreshold) {
+        slots.clear();
+        return;
+    }
+
+    size_t capacity = 64;
+    while (capacity < entries.size() * 4) {
+        capacity *= 2;
+    }
+    slots.assign(capacity, 0);
+    for (size_t pos = 0; pos < entries.size(); ++pos) {
+        indexEntry(pos);
+    }
+}
+
+} // namespace sfcxx
@@ -0,0 +1,768 @@
+//===-- _SFCxxUtils/SFCxxJSONPatch.cpp - JSON Patch -------------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements JSON Patch and JSON Merge Patch on documents and on text.
+///
+/// Patches on a `JSONVariant` copy each container on the way to an edit the
+/// first time it is written and work on that copy. The original tree is never
+/// modified, so a failing operation only has to drop the copy.
+///
+/// Patches on text are split into rounds of operations that do not affect
+/// each other's paths. A round indexes the current text once, turns each
+/// operation into a byte range and its replacement, and splices all of them
+/// in one pass.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONPatch.h"
+#include "include/SFCxxCBOR.h"
+#include "include/SFCJSON.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace sfcxx {
+
+namespace {
+
+using JSONArray = std::vector<std::shared_ptr<JSONValue>>;
+using Pointer = std::vector<std::string>;
+
+[[noreturn]] void invalid(size_t operation, const std::string& what) {
+    throw std::invalid_argument("Invalid JSON Patch operation " + std::to_string(operation) + ": " + what);
+}
+
+[[noreturn]] void failed(size_t operation, const std::string& what) {
+    throw std::runtime_error("JSON Patch operation " + std::to_string(operation) + " failed: " + what);
+}
+
+/// Parses an array index token. `-` stands for the end of the array and is only accepted if `allowEnd` is set.
+bool parseIndex(const std::string& token, size_t size, bool allowEnd, size_t& index) {
+    if (token == "-") {
+        index = size;
+        return allowEnd;
+    }
+    if (token.empty() || token.size() > 18 || (token[0] == '0' && token.size() > 1)) {
+        return false;
+    }
+    index = 0;
+    for (char c : token) {
+        if (c < '0' || c > '9') return false;
+        index = index * 10 + static_cast<size_t>(c - '0');
+    }
+    return allowEnd ? index <= size : index < size;
+}
+
+bool isPrefix(const Pointer& prefix, const Pointer& path, size_t prefixLength) {
+    return prefixLength <= path.size() && std::equal(prefix.begin(), prefix.begin() + prefixLength, path.begin());
+}
+
+/// Compares two values as RFC 6902 `test` does: objects ignore member order.
+bool equal(const JSONVariant& a, const JSONVariant& b) {
+    if (a.index() != b.index()) {
+        return false;
+    }
+    if (const auto* array = std::get_if<JSONArray>(&a)) {
+        const auto& other = std::get<JSONArray>(b);
+        if (array->size() != other.size()) return false;
+        for (size_t i = 0; i < array->size(); ++i) {
+            if (!equal((*array)[i]->value, other[i]->value)) return false;
+        }
+        return true;
+    }
+    if (const auto* object = std::get_if<JSONObject>(&a)) {
+        const auto& other = std::get<JSONObject>(b);
+        if (object->size() != other.size()) return false;
+        for (const auto& member : *object) {
+            auto it = other.find(member.first);
+            if (it == other.end() || !equal(member.second->value, it->second->value)) return false;
+        }
+        return true;
+    }
+    if (const auto* text = std::get_if<std::string>(&a)) return *text == std::get<std::string>(b);
+    if (const auto* number = std::get_if<double>(&a)) return *number == std::get<double>(b);
+    if (const auto* flag = std::get_if<bool>(&a)) return *flag == std::get<bool>(b);
+    return true;
+}
+
+/// Returns `target` with `patch` merged into it (RFC 7386). Subtrees are shared, not copied.
+JSONVariant merged(const JSONVariant* target, const JSONVariant& patch) {
+    const auto* members = std::get_if<JSONObject>(&patch);
+    if (members == nullptr) {
+        return patch;
+    }
+    const auto* existing = target ? std::get_if<JSONObject>(target) : nullptr;
+    JSONObject result = existing ? *existing : JSONObject();
+    for (const auto& member : *members) {
+        if (std::holds_alternative<std::nullptr_t>(member.second->value)) {
+            result.erase(member.first);
+            continue;
+        }
+        auto it = result.find(member.first);
+        const JSONVariant* current = it != result.end() ? &it->second->value : nullptr;
+        result.insert_or_assign(member.first, std::make_shared<JSONValue>(merged(current, member.second->value)));
+    }
+    return result;
+}
+
+/// Applies operations to a private copy of a document, copying containers on first write.
+class TreeEditor {
+public:
+    explicit TreeEditor(const JSONVariant& document) : root(document) {}
+
+    /// Returns the value at `path`, or `nullptr`. With `forWrite`, the containers on the way are made private.
+    JSONVariant* find(const Pointer& path, size_t length, bool forWrite) {
+        JSONVariant* node = &root;
+        for (size_t i = 0; i < length; ++i) {
+            std::shared_ptr<JSONValue>* child = nullptr;
+            if (auto* object = std::get_if<JSONObject>(node)) {
+                auto it = object->find(path[i]);
+                if (it == object->end()) return nullptr;
+                child = &it->second;
+            } else if (auto* array = std::get_if<JSONArray>(node)) {
+                size_t index;
+                if (!parseIndex(path[i], array->size(), false, index)) return nullptr;
+                child = &(*array)[index];
+            } else {
+                return nullptr;
+            }
+            if (forWrite && fresh.count(child->get()) == 0) {
+                *child = std::make_shared<JSONValue>((*child)->value);
+                fresh.insert(child->get());
+            }
+            node = &(*child)->value;
+        }
+        return node;
+    }
+
+    void add(size_t operation, const Pointer& path, std::shared_ptr<JSONValue> node) {
+        if (path.empty()) {
+            root = node->value;
+            return;
+        }
+        JSONVariant* parent = find(path, path.size() - 1, true);
+        if (auto* object = parent ? std::get_if<JSONObject>(parent) : nullptr) {
+            object->insert_or_assign(path.back(), std::move(node));
+        } else if (auto* array = parent ? std::get_if<JSONArray>(parent) : nullptr) {
+            size_t index;
+            if (!parseIndex(path.back(), array->size(), true, index)) failed(operation, "array index out of range");
+            array->insert(array->begin() + static_cast<std::ptrdiff_t>(index), std::move(node));
+        } else {
+            failed(operation, "parent does not exist");
+        }
+    }
+
+    std::shared_ptr<JSONValue> remove(size_t operation, const Pointer& path) {
+        if (path.empty()) {
+            failed(operation, "cannot remove the root");
+        }
+        JSONVariant* parent = find(path, path.size() - 1, true);
+        std::shared_ptr<JSONValue> node;
+        if (auto* object = parent ? std::get_if<JSONObject>(parent) : nullptr) {
+            auto it = object->find(path.back());
+            if (it == object->end()) failed(operation, "path does not exist");
+            node = std::move(it->second);
+            object->erase(path.back());
+        } else if (auto* array = parent ? std::get_if<JSONArray>(parent) : nullptr) {
+            size_t index;
+            if (!parseIndex(path.back(), array->size(), false, index)) failed(operation, "path does not exist");
+            node = std::move((*array)[index]);
+            array->erase(array->begin() + static_cast<std::ptrdiff_t>(index));
+        } else {
+            failed(operation, "path does not exist");
+        }
+        return node;
+    }
+
+    /// Makes every node shared again, after a subtree has been copied to a second location.
+    void share() { fresh.clear(); }
+
+    JSONVariant root;
+
+private:
+    std::unordered_set<const JSONValue*> fresh;         ///< Nodes created by this editor, safe to modify in place.
+};
+
+/// A byte range of the text being patched and its replacement.
+struct Edit {
+    size_t offset;
+    size_t length;
+    std::string text;
+};
+
+/// Turns operations into edits of the text indexed by `document`.
+class TextEditor {
+public:
+    TextEditor(const JSONDocument& document, std::string_view text) : document(document), text(text) {}
+
+    JSONElement find(const Pointer& path, size_t length) const {
+        JSONElement element = document.root();
+        for (size_t i = 0; i < length && element; ++i) {
+            if (element.type() == JSONType::OBJECT) {
+                element = element[path[i]];
+            } else {
+                size_t index;
+                element = parseIndex(path[i], SIZE_MAX, false, index) ? element.at(index) : JSONElement();
+            }
+        }
+        return element;
+    }
+
+    void replace(size_t operation, const Pointer& path, std::string value, std::vector<Edit>& edits) const {
+        JSONElement element = find(path, path.size());
+        if (!element) failed(operation, "path does not exist");
+        edits.push_back({startOf(element), element.raw().size(), std::move(value)});
+    }
+
+    void add(size_t operation, const Pointer& path, std::string value, std::vector<Edit>& edits) const {
+        if (path.empty()) {
+            edits.push_back({0, text.size(), std::move(value)});
+            return;
+        }
+        JSONElement parent = find(path, path.size() - 1);
+        JSONType type = parent.type();
+        if (type == JSONType::OBJECT) {
+            if (JSONElement existing = parent[path.back()]) {
+                edits.push_back({startOf(existing), existing.raw().size(), std::move(value)});
+                return;
+            }
+            std::string member = JSON::encode(path.back()) + ":" + value;
+            append(parent, parent.first(), std::move(member), edits);
+        } else if (type == JSONType::ARRAY) {
+            size_t size = parent.size();
+            size_t index;
+            if (!parseIndex(path.back(), size, true, index)) failed(operation, "array index out of range");
+            if (index < size) {
+                edits.push_back({startOf(parent.at(index)), 0, value + ","});
+            } else {
+                append(parent, parent.first(), std::move(value), edits);
+            }
+        } else {
+            failed(operation, "parent does not exist");
+        }
+    }
+
+    void remove(size_t operation, const Pointer& path, std::vector<Edit>& edits) const {
+        if (path.empty()) {
+            failed(operation, "cannot remove the root");
+        }
+        JSONElement parent = find(path, path.size() - 1);
+        if (parent.type() == JSONType::OBJECT) {
+            removeMembers(operation, parent, path.back(), edits);
+            return;
+        }
+        size_t index = 0;
+        if (parent.type() != JSONType::ARRAY || !parseIndex(path.back(), SIZE_MAX, false, index)) {
+            failed(operation, "path does not exist");
+        }
+
+        JSONElement previous;
+        JSONElement target = parent.first();
+        for (; target && index-- != 0; previous = target, target = target.nextSibling()) {}
+        if (!target) failed(operation, "path does not exist");
+
+        // Take one separating comma with the element: the one after it, or the one before the last element.
+        size_t begin = startOf(target);
+        size_t end = endOf(target);
+        if (JSONElement next = target.nextSibling()) {
+            end = startOf(next);
+        } else if (previous) {
+            begin = endOf(previous);
+        }
+        edits.push_back({begin, end - begin, std::string()});
+    }
+
+    std::string_view raw(size_t operation, const Pointer& path) const {
+        JSONElement element = find(path, path.size());
+        if (!element) failed(operation, "path does not exist");
+        return element.raw();
+    }
+
+private:
+    size_t startOf(const JSONElement& element) const { return static_cast<size_t>(element.raw().data() - text.data()); }
+    size_t endOf(const JSONElement& element) const { return startOf(element) + element.raw().size(); }
+    size_t keyStart(const JSONElement& member) const {
+        return static_cast<size_t>(member.key().raw().data() - text.data()) - 1;
+    }
+
+    /// Removes every member of `object` named `key`, as decoding leaves only one of them.
+    void removeMembers(size_t operation, const JSONElement& object, std::string_view key, std::vector<Edit>& edits) const {
+        JSONElement kept;                                                   // The last member that stays
+        JSONElement last;
+        bool found = false;
+        for (JSONElement member = object.first(); member; member = member.nextSibling()) {
+            if (member.key() == key) {
+                found = true;
+            } else {
+                kept = member;
+            }
+            last = member;
+        }
+        if (!found) failed(operation, "path does not exist");
+
+        // A member before the last kept one goes with the comma after it; the members after it go with
+        // the comma before them, so the edits never overlap.
+        size_t keptStart = kept ? startOf(kept) : 0;
+        for (JSONElement member = object.first(); kept && startOf(member) != keptStart; member = member.nextSibling()) {
+            if (member.key() == key) {
+                size_t begin = keyStart(member);
+                edits.push_back({begin, keyStart(member.nextSibling()) - begin, std::string()});
+            }
+        }
+        size_t begin = kept ? endOf(kept) : keyStart(object.first());
+        if (begin < endOf(last)) {
+            edits.push_back({begin, endOf(last) - begin, std::string()});
+        }
+    }
+
+    /// Inserts `item` after the last element of `container`, whose first element is `first`.
+    void append(const JSONElement& container, JSONElement first, std::string item, std::vector<Edit>& edits) const {
+        if (!first) {
+            edits.push_back({endOf(container) - 1, 0, std::move(item)});                 // Before the closing bracket
+            return;
+        }
+        JSONElement last = first;
+        for (JSONElement next = first.nextSibling(); next; next = next.nextSibling()) {
+            last = next;
+        }
+        edits.push_back({endOf(last), 0, "," + item});
+    }
+
+    const JSONDocument& document;
+    std::string_view text;
+};
+
+/// Whether an operation changes the layout of the container that holds its path.
+inline bool isStructural(JSONPatchOperation op) {
+    return op == JSONPatchOperation::ADD || op == JSONPatchOperation::REMOVE || op == JSONPatchOperation::COPY;
+}
+
+} // namespace
+
+#pragma mark - Building
+
+JSONPatch::Pointer JSONPatch::parsePointer(std::string_view pointer) {
+    Pointer tokens;
+    if (pointer.empty()) {
+        return tokens;
+    }
+    if (pointer[0] != '/') {
+        throw std::invalid_argument("Invalid JSON Pointer at offset 0: expected '/'");
+    }
+    std::string token;
+    for (size_t i = 1; i <= pointer.size(); ++i) {
+        if (i == pointer.size() || pointer[i] == '/') {
+            tokens.push_back(std::move(token));
+            token.clear();
+        } else if (pointer[i] == '~') {
+            if (i + 1 == pointer.size() || (pointer[i + 1] != '0' && pointer[i + 1] != '1')) {
+                throw std::invalid_argument("Invalid JSON Pointer at offset " + std::to_string(i) +
+                                            ": '~' must be followed by '0' or '1'");
+            }
+            token.push_back(pointer[++i] == '0' ? '~' : '/');
+        } else {
+            token.push_back(pointer[i]);
+        }
+    }
+    return tokens;
+}
+
+JSONPatch::JSONPatch(const JSONVariant& patch) {
+    const auto* list = std::get_if<JSONArray>(&patch);
+    if (list == nullptr) {
+        throw std::invalid_argument("Invalid JSON Patch: expected an array of operations");
+    }
+
+    static const std::pair<const char*, JSONPatchOperation> kNames[] = {
+        {"add", JSONPatchOperation::ADD},     {"remove", JSONPatchOperation::REMOVE},
+        {"replace", JSONPatchOperation::REPLACE}, {"move", JSONPatchOperation::MOVE},
+        {"copy", JSONPatchOperation::COPY},   {"test", JSONPatchOperation::TEST},
+    };
+
+    operations.reserve(list->size());
+    for (size_t i = 0; i < list->size(); ++i) {
+        const auto* object = std::get_if<JSONObject>(&(*list)[i]->value);
+        if (object == nullptr) invalid(i, "expected an object");
+
+        auto member = [&](const char* name) -> const JSONVariant* {
+            auto it = object->find(name);
+            return it != object->end() ? &it->second->value : nullptr;
+        };
+        auto pointer = [&](const char* name) {
+            const JSONVariant* value = member(name);
+            const auto* text = value ? std::get_if<std::string>(value) : nullptr;
+            if (text == nullptr) invalid(i, std::string("missing \"") + name + "\"");
+            try {
+                return parsePointer(*text);
+            } catch (const std::invalid_argument& error) {
+                invalid(i, error.what());
+            }
+        };
+
+        const JSONVariant* name = member("op");
+        const auto* op = name ? std::get_if<std::string>(name) : nullptr;
+        const auto* entry = std::find_if(std::begin(kNames), std::end(kNames),
+                                         [&](const auto& candidate) { return op && *op == candidate.first; });
+        if (entry == std::end(kNames)) invalid(i, "unknown \"op\"");
+
+        Pointer from;
+        JSONVariant value = nullptr;
+        if (entry->second == JSONPatchOperation::MOVE || entry->second == JSONPatchOperation::COPY) {
+            from = pointer("from");
+        } else if (entry->second != JSONPatchOperation::REMOVE) {
+            const JSONVariant* given = member("value");
+            if (given == nullptr) invalid(i, "missing \"value\"");
+            value = *given;
+        }
+        push(entry->second, pointer("path"), std::move(from), std::move(value));
+    }
+}
+
+JSONPatch JSONPatch::parse(std::string_view json) {
+    return JSONPatch(JSON::decode(json));
+}
+
+JSONPatch& JSONPatch::add(std::string_view path, JSONVariant value) {
+    return push(JSONPatchOperation::ADD, parsePointer(path), Pointer(), std::move(value));
+}
+
+JSONPatch& JSONPatch::remove(std::string_view path) {
+    return push(JSONPatchOperation::REMOVE, parsePointer(path), Pointer(), nullptr);
+}
+
+JSONPatch& JSONPatch::replace(std::string_view path, JSONVariant value) {
+    return push(JSONPatchOperation::REPLACE, parsePointer(path), Pointer(), std::move(value));
+}
+
+JSONPatch& JSONPatch::move(std::string_view from, std::string_view path) {
+    return push(JSONPatchOperation::MOVE, parsePointer(path), parsePointer(from), nullptr);
+}
+
+JSONPatch& JSONPatch::copy(std::string_view from, std::string_view path) {
+    return push(JSONPatchOperation::COPY, parsePointer(path), parsePointer(from), nullptr);
+}
+
+JSONPatch& JSONPatch::test(std::string_view path, JSONVariant value) {
+    return push(JSONPatchOperation::TEST, parsePointer(path), Pointer(), std::move(value));
+}
+
+JSONPatch& JSONPatch::append(const JSONPatch& other) {
+    operations.insert(operations.end(), other.operations.begin(), other.operations.end());
+    return *this;
+}
+
+JSONPatch& JSONPatch::push(JSONPatchOperation op, Pointer path, Pointer from, JSONVariant value) {
+    if (op == JSONPatchOperation::MOVE && from.size() < path.size() && isPrefix(from, path, from.size())) {
+        throw std::invalid_argument("Invalid JSON Patch operation " + std::to_string(operations.size()) +
+                                    ": cannot move a value into itself");
+    }
+    std::string encoded;
+    if (op == JSONPatchOperation::ADD || op == JSONPatchOperation::REPLACE) {
+        encoded = JSON::encode(value);
+    }
+    operations.push_back({op, std::move(path), std::move(from), std::move(value), std::move(encoded)});
+    return *this;
+}
+
+#pragma mark - Applying
+
+void JSONPatch::apply(JSONVariant& document) const {
+    TreeEditor editor(document);
+    for (size_t i = 0; i < operations.size(); ++i) {
+        const Operation& operation = operations[i];
+        switch (operation.op) {
+            case JSONPatchOperation::ADD:
+                editor.add(i, operation.path, std::make_shared<JSONValue>(operation.value));
+                break;
+            case JSONPatchOperation::REMOVE:
+                editor.remove(i, operation.path);
+                break;
+            case JSONPatchOperation::REPLACE: {
+                JSONVariant* target = editor.find(operation.path, operation.path.size(), true);
+                if (target == nullptr) failed(i, "path does not exist");
+                *target = operation.value;
+                break;
+            }
+            case JSONPatchOperation::MOVE:
+                if (operation.from != operation.path) {
+                    editor.add(i, operation.path, editor.remove(i, operation.from));
+                }
+                break;
+            case JSONPatchOperation::COPY: {
+                const JSONVariant* source = editor.find(operation.from, operation.from.size(), false);
+                if (source == nullptr) failed(i, "\"from\" does not exist");
+                auto node = std::make_shared<JSONValue>(*source);
+                editor.share();                                             // Both copies share their children
+                editor.add(i, operation.path, std::move(node));
+                break;
+            }
+            case JSONPatchOperation::TEST: {
+                const JSONVariant* target = editor.find(operation.path, operation.path.size(), false);
+                if (target == nullptr) failed(i, "path does not exist");
+                if (!equal(*target, operation.value)) failed(i, "test failed");
+                break;
+            }
+        }
+    }
+    document = std::move(editor.root);
+}
+
+void JSONPatch::apply(std::string& json) const {
+    std::string result;
+    std::string_view text = json;
+    JSONDocument document;
+    std::vector<Edit> edits;
+    std::vector<std::pair<const Pointer*, bool>> touched;                   // Paths of the round, and whether structural
+
+    auto flush = [&] {
+        if (touched.empty()) return;
+        std::stable_sort(edits.begin(), edits.end(), [](const Edit& a, const Edit& b) {
+            return a.offset != b.offset ? a.offset < b.offset : a.length < b.length;   // Inserts before replacements
+        });
+        std::string next;
+        size_t size = text.size();
+        for (const Edit& edit : edits) {
+            size += edit.text.size() - edit.length;
+        }
+        next.reserve(size);
+        size_t pos = 0;
+        for (const Edit& edit : edits) {
+            next.append(text.data() + pos, edit.offset - pos);
+            next.append(edit.text);
+            pos = edit.offset + edit.length;
+        }
+        next.append(text.data() + pos, text.size() - pos);
+        result = std::move(next);
+        text = result;
+        edits.clear();
+        touched.clear();
+    };
+
+    // Two operations can share a round if neither changes the layout of a container the other's path goes through.
+    auto conflicts = [&](const Pointer& path, bool structural) {
+        for (const auto& [other, otherStructural] : touched) {
+            size_t shared = std::min(path.size(), other->size());
+            if (isPrefix(path, *other, shared) ||
+                (otherStructural && isPrefix(*other, path, other->size() - 1)) ||
+                (structural && isPrefix(path, *other, path.size() - 1))) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto begin = [&](std::initializer_list<std::pair<const Pointer*, bool>> paths) {
+        for (const auto& [path, structural] : paths) {
+            if (conflicts(*path, structural)) {
+                flush();
+                break;
+            }
+        }
+        if (touched.empty()) {
+            document.load(text);
+        }
+        touched.insert(touched.end(), paths);
+    };
+
+    for (size_t i = 0; i < operations.size(); ++i) {
+        const Operation& operation = operations[i];
+        const Pointer& path = operation.path;
+        switch (operation.op) {
+            case JSONPatchOperation::ADD:
+                begin({{&path, true}});
+                TextEditor(document, text).add(i, path, operation.encoded, edits);
+                break;
+            case JSONPatchOperation::REMOVE:
+                begin({{&path, true}});
+                TextEditor(document, text).remove(i, path, edits);
+                break;
+            case JSONPatchOperation::REPLACE:
+                begin({{&path, false}});
+                TextEditor(document, text).replace(i, path, operation.encoded, edits);
+                break;
+            case JSONPatchOperation::COPY: {
+                begin({{&operation.from, false}, {&path, true}});
+                TextEditor editor(document, text);
+                editor.add(i, path, std::string(editor.raw(i, operation.from)), edits);
+                break;
+            }
+            case JSONPatchOperation::MOVE: {
+                if (operation.from == path) break;
+                flush();                                                    // The target is resolved after the removal
+                begin({{&operation.from, true}});
+                std::string value(TextEditor(document, text).raw(i, operation.from));
+                TextEditor(document, text).remove(i, operation.from, edits);
+                flush();
+                begin({{&path, true}});
+                TextEditor(document, text).add(i, path, std::move(value), edits);
+                break;
+            }
+            case JSONPatchOperation::TEST: {
+                begin({{&path, false}});
+                JSONVariant value = JSON::decode(TextEditor(document, text).raw(i, path));
+                if (!equal(value, operation.value)) failed(i, "test failed");
+                break;
+            }
+        }
+    }
+    flush();
+
+    if (text.data() == result.data()) {
+        json = std::move(result);
+    }
+}
+
+#pragma mark - Merge Patch
+
+void JSONPatch::merge(JSONVariant& target, const JSONVariant& patch) {
+    target = merged(&target, patch);
+}
+
+void JSONPatch::merge(std::string& json, const JSONVariant& patch) {
+    JSONDocument document(json);
+    JSONPatch operations;
+    Pointer path;
+    mergeOperations(operations, document.root(), path, patch);
+    operations.apply(json);
+}
+
+void JSONPatch::mergeOperations(JSONPatch& patch, JSONElement target, Pointer& path, const JSONVariant& merge) {
+    const auto* members = std::get_if<JSONObject>(&merge);
+    if (members == nullptr || target.type() != JSONType::OBJECT) {
+        patch.push(JSONPatchOperation::ADD, path, Pointer(), merged(nullptr, merge));
+        return;
+    }
+    for (const auto& member : *members) {
+        JSONElement current = target[member.first];
+        const JSONVariant& value = member.second->value;
+        path.push_back(member.first);
+        if (std::holds_alternative<std::nullptr_t>(value)) {
+            if (current) patch.push(JSONPatchOperation::REMOVE, path, Pointer(), nullptr);
+        } else {
+            mergeOperations(patch, current, path, value);
+        }
+        path.pop_back();
+    }
+}
+
+} // namespace sfcxx
+
+extern "C" {
+JSONPatch json_patch_create(void) {
+    return new (std::nothrow) sfcxx::JSONPatch();
+}
+
+JSONPatch json_patch_parse(const char* json, size_t length) {
+    try {
+        return new sfcxx::JSONPatch(sfcxx::JSONPatch::parse(std::string_view(json, length)));
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+int json_patch_add(JSONPatch patch, const char* path, JSONVariant value) {
+    try {
+        static_cast<sfcxx::JSONPatch*>(patch)->add(path, static_cast<const sfcxx::JSONValue*>(value)->value);
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+int json_patch_remove(JSONPatch patch, const char* path) {
+    try {
+        static_cast<sfcxx::JSONPatch*>(patch)->remove(path);
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+int json_patch_replace(JSONPatch patch, const char* path, JSONVariant value) {
+    try {
+        static_cast<sfcxx::JSONPatch*>(patch)->replace(path, static_cast<const sfcxx::JSONValue*>(value)->value);
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+int json_patch_apply(JSONPatch patch, JSONVariant document) {
+    try {
+        static_cast<const sfcxx::JSONPatch*>(patch)->apply(static_cast<sfcxx::JSONValue*>(document)->value);
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+char* json_patch_apply_buffer(JSONPatch patch, const char* data, size_t length, size_t* outLength) {
+    try {
+        const auto* operations = static_cast<const sfcxx::JSONPatch*>(patch);
+        std::string result;
+        if (sfcxx::CBOR::isCBOR(data, length)) {
+            sfcxx::JSONVariant document = sfcxx::CBOR::decode(data, length);
+            operations->apply(document);
+            result = sfcxx::CBOR::encode(document);
+        } else {
+            result.assign(data, length);
+            operations->apply(result);
+        }
+
+        char* patched = static_cast<char*>(std::malloc(result.size() + 1));
+        if (patched == nullptr) {
+            return nullptr;
+        }
+        std::memcpy(patched, result.c_str(), result.size() + 1);
+        *outLength = result.size();
+        return patched;
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+int json_merge_patch(JSONVariant target, JSONVariant patch) {
+    try {
+        sfcxx::JSONPatch::merge(static_cast<sfcxx::JSONValue*>(target)->value,
+                                static_cast<const sfcxx::JSONValue*>(patch)->value);
+        return 0;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+void json_patch_free(JSONPatch patch) {
+    delete static_cast<sfcxx::JSONPatch*>(patch);
+}
+}
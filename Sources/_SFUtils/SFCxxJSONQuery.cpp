@@ -0,0 +1,455 @@
+//===-- _SFCxxUtils/SFCxxJSONQuery.cpp - JSON Path Queries ------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements compiled path queries over JSON documents.
+///
+/// A compiled path is a list of steps. While a document is walked, the set of
+/// steps that may match next is kept as a bit set per value: a child inherits
+/// the bits of `..` steps and gains the bit after every step it matches. A
+/// value whose set contains the bit past the last step is selected, and a
+/// child whose set is empty is skipped.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONQuery.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace sfcxx {
+
+namespace {
+
+using JSONArray = std::vector<std::shared_ptr<JSONValue>>;
+
+constexpr size_t kNoIndex = SIZE_MAX;
+
+[[noreturn]] void invalid(size_t offset, const char* what) {
+    throw std::invalid_argument("Invalid JSON path at offset " + std::to_string(offset) + ": " + what);
+}
+
+inline size_t lowestState(uint64_t states) {
+    return static_cast<size_t>(__builtin_ctzll(states));
+}
+
+/// Parses an array index without sign or leading zeros, or returns `kNoIndex`.
+size_t parseIndex(std::string_view text) {
+    if (text.empty() || text.size() > 18 || (text[0] == '0' && text.size() > 1)) {
+        return kNoIndex;
+    }
+    size_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return kNoIndex;
+        value = value * 10 + static_cast<size_t>(c - '0');
+    }
+    return value;
+}
+
+/// Walks a decoded `JSONVariant` tree.
+struct VariantNodes {
+    using Node = const JSONVariant*;
+
+    static bool exists(Node node) { return node != nullptr; }
+    static bool isObject(Node node) { return std::holds_alternative<JSONObject>(*node); }
+    static bool isArray(Node node) { return std::holds_alternative<JSONArray>(*node); }
+
+    static Node member(Node node, std::string_view key) {
+        const auto& object = std::get<JSONObject>(*node);
+        auto it = object.find(key);
+        return it == object.end() ? nullptr : valueOf(it->second);
+    }
+
+    static Node element(Node node, size_t index) {
+        const auto& array = std::get<JSONArray>(*node);
+        return index < array.size() ? valueOf(array[index]) : nullptr;
+    }
+
+    template <typename Visit>
+    static bool forEachMember(Node node, Visit&& visit) {
+        for (const auto& member : std::get<JSONObject>(*node)) {
+            if (member.second && !visit(std::string_view(member.first), &member.second->value)) return false;
+        }
+        return true;
+    }
+
+    template <typename Visit>
+    static bool forEachElement(Node node, Visit&& visit) {
+        const auto& array = std::get<JSONArray>(*node);
+        for (size_t index = 0; index < array.size(); ++index) {
+            if (array[index] && !visit(index, &array[index]->value)) return false;
+        }
+        return true;
+    }
+
+    static Node valueOf(const std::shared_ptr<JSONValue>& value) { return value ? &value->value : nullptr; }
+};
+
+/// Walks a `JSONDocument` without materializing it.
+struct ElementNodes {
+    using Node = JSONElement;
+
+    static bool exists(Node node) { return static_cast<bool>(node); }
+    static bool isObject(Node node) { return node.type() == JSONType::OBJECT; }
+    static bool isArray(Node node) { return node.type() == JSONType::ARRAY; }
+    static Node member(Node node, std::string_view key) { return node[key]; }
+    static Node element(Node node, size_t index) { return node.at(index); }
+
+    template <typename Visit>
+    static bool forEachMember(Node node, Visit&& visit) {
+        for (JSONElement member = node.first(); member; member = member.nextSibling()) {
+            if (!visit(member.key(), member)) return false;
+        }
+        return true;
+    }
+
+    template <typename Visit>
+    static bool forEachElement(Node node, Visit&& visit) {
+        size_t index = 0;
+        for (JSONElement element = node.first(); element; element = element.nextSibling()) {
+            if (!visit(index++, element)) return false;
+        }
+        return true;
+    }
+};
+
+JSONToken advance(JSONReader& reader) {
+    JSONToken token = reader.next();
+    if (token == JSONToken::NEED_MORE_INPUT) {
+        throw std::logic_error("JSONQuery: the reader ran out of input");
+    }
+    return token;
+}
+
+void skip(JSONReader& reader) {
+    if (reader.skipValue() == JSONToken::NEED_MORE_INPUT) {
+        throw std::logic_error("JSONQuery: the reader ran out of input");
+    }
+}
+
+/// Materializes the value that starts at the reader's current token.
+JSONVariant readValue(JSONReader& reader) {
+    switch (reader.token()) {
+        case JSONToken::BEGIN_OBJECT: {
+            JSONObject object;
+            while (advance(reader) != JSONToken::END_OBJECT) {
+                JSONKey key(reader.stringValue());
+                advance(reader);
+                object.insert_or_assign(std::move(key), std::make_shared<JSONValue>(readValue(reader)));
+            }
+            return object;
+        }
+        case JSONToken::BEGIN_ARRAY: {
+            JSONArray array;
+            while (advance(reader) != JSONToken::END_ARRAY) {
+                array.push_back(std::make_shared<JSONValue>(readValue(reader)));
+            }
+            return array;
+        }
+        case JSONToken::STRING:
+            return std::string(reader.stringValue());
+        case JSONToken::NUMBER:
+            return reader.numberValue();
+        case JSONToken::BOOL:
+            return reader.boolValue();
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace
+
+#pragma mark - Compilation
+
+JSONQuery::JSONQuery(std::string_view expression) {
+    if (!expression.empty() && expression[0] == '$') {
+        compilePath(expression);
+    } else {
+        compilePointer(expression);
+    }
+    if (steps.size() > kMaxSteps) {
+        invalid(expression.size(), "too many steps");
+    }
+}
+
+void JSONQuery::compilePointer(std::string_view expression) {
+    if (expression.empty()) {
+        return;                                                             // The whole document
+    }
+    if (expression[0] != '/') {
+        invalid(0, "expected '/' or '$'");
+    }
+
+    size_t pos = 1;
+    while (true) {
+        size_t end = std::min(expression.find('/', pos), expression.size());
+        std::string token;
+        for (size_t i = pos; i < end; ++i) {
+            if (expression[i] != '~') {
+                token += expression[i];
+            } else if (i + 1 < end && (expression[i + 1] == '0' || expression[i + 1] == '1')) {
+                token += expression[++i] == '0' ? '~' : '/';
+            } else {
+                invalid(i, "'~' must be followed by '0' or '1'");
+            }
+        }
+        size_t index = parseIndex(token);
+        steps.push_back({Step::Kind::KEY_OR_INDEX, false, std::move(token), index});
+        if (end == expression.size()) break;
+        pos = end + 1;
+    }
+}
+
+void JSONQuery::compilePath(std::string_view expression) {
+    size_t pos = 1;                                                         // Skip '$'
+    size_t length = expression.size();
+
+    while (pos < length) {
+        bool descendant = false;
+        if (expression[pos] == '.') {
+            descendant = pos + 1 < length && expression[pos + 1] == '.';
+            pos += descendant ? 2 : 1;
+            if (pos < length && expression[pos] == '*') {
+                steps.push_back({Step::Kind::WILDCARD, descendant, std::string(), kNoIndex});
+                ++pos;
+                continue;
+            }
+            if (!descendant || pos >= length || expression[pos] != '[') {
+                size_t end = pos;
+                while (end < length && expression[end] != '.' && expression[end] != '[') {
+                    ++end;
+                }
+                if (end == pos) invalid(pos, "expected a member name");
+                steps.push_back({Step::Kind::KEY, descendant, std::string(expression.substr(pos, end - pos)), kNoIndex});
+                pos = end;
+                continue;
+            }
+        }
+
+        if (expression[pos] != '[') {
+            invalid(pos, "expected '.' or '['");
+        }
+        ++pos;                                                              // Skip '['
+        if (pos < length && expression[pos] == '*') {
+            steps.push_back({Step::Kind::WILDCARD, descendant, std::string(), kNoIndex});
+            ++pos;
+        } else if (pos < length && (expression[pos] == '\'' || expression[pos] == '"')) {
+            char quote = expression[pos++];
+            std::string name;
+            while (pos < length && expression[pos] != quote) {
+                if (expression[pos] == '\\' && pos + 1 < length) ++pos;
+                name += expression[pos++];
+            }
+            if (pos == length) invalid(pos, "unterminated member name");
+            ++pos;                                                          // Skip the closing quote
+            steps.push_back({Step::Kind::KEY, descendant, std::move(name), kNoIndex});
+        } else {
+            size_t end = pos;
+            while (end < length && expression[end] >= '0' && expression[end] <= '9') {
+                ++end;
+            }
+            size_t index = parseIndex(expression.substr(pos, end - pos));
+            if (index == kNoIndex) invalid(pos, "expected an index, a quoted name or '*'");
+            steps.push_back({Step::Kind::INDEX, descendant, std::string(), index});
+            pos = end;
+        }
+        if (pos >= length || expression[pos] != ']') {
+            invalid(pos, "expected ']'");
+        }
+        ++pos;
+    }
+}
+
+#pragma mark - Evaluation
+
+template <typename Key>
+JSONQuery::StateSet JSONQuery::statesForMember(StateSet states, const Key& key) const {
+    StateSet result = 0;
+    for (; states != 0; states &= states - 1) {
+        size_t i = lowestState(states);
+        const Step& step = steps[i];
+        if (step.descendant) {
+            result |= StateSet(1) << i;                                     // `..` keeps looking further down
+        }
+        if (step.kind == Step::Kind::WILDCARD ||
+            (step.kind != Step::Kind::INDEX && key == std::string_view(step.name))) {
+            result |= StateSet(1) << (i + 1);
+        }
+    }
+    return result;
+}
+
+JSONQuery::StateSet JSONQuery::statesForElement(StateSet states, size_t index) const {
+    StateSet result = 0;
+    for (; states != 0; states &= states - 1) {
+        size_t i = lowestState(states);
+        const Step& step = steps[i];
+        if (step.descendant) {
+            result |= StateSet(1) << i;
+        }
+        if (step.kind == Step::Kind::WILDCARD || (step.kind != Step::Kind::KEY && step.index == index)) {
+            result |= StateSet(1) << (i + 1);
+        }
+    }
+    return result;
+}
+
+template <typename Nodes, typename Emit>
+bool JSONQuery::walk(typename Nodes::Node node, StateSet states, Emit& emit) const {
+    if ((states & finalState()) != 0 && !emit(node)) {
+        return false;
+    }
+    StateSet active = states & ~finalState();
+    if (active == 0) {
+        return true;
+    }
+
+    // A single step naming one member or index is a lookup, not a scan.
+    if ((active & (active - 1)) == 0) {
+        const Step& step = steps[lowestState(active)];
+        if (!step.descendant && step.kind != Step::Kind::WILDCARD) {
+            typename Nodes::Node child{};
+            if (Nodes::isObject(node) && step.kind != Step::Kind::INDEX) {
+                child = Nodes::member(node, step.name);
+            } else if (Nodes::isArray(node) && step.kind != Step::Kind::KEY && step.index != kNoIndex) {
+                child = Nodes::element(node, step.index);
+            }
+            return !Nodes::exists(child) || walk<Nodes>(child, active << 1, emit);
+        }
+    }
+
+    if (Nodes::isObject(node)) {
+        return Nodes::forEachMember(node, [&](const auto& key, typename Nodes::Node child) {
+            StateSet next = statesForMember(active, key);
+            return next == 0 || walk<Nodes>(child, next, emit);
+        });
+    }
+    if (Nodes::isArray(node)) {
+        return Nodes::forEachElement(node, [&](size_t index, typename Nodes::Node child) {
+            StateSet next = statesForElement(active, index);
+            return next == 0 || walk<Nodes>(child, next, emit);
+        });
+    }
+    return true;
+}
+
+std::vector<const JSONVariant*> JSONQuery::select(const JSONVariant& root) const {
+    std::vector<const JSONVariant*> results;
+    auto emit = [&](const JSONVariant* node) {
+        results.push_back(node);
+        return true;
+    };
+    walk<VariantNodes>(&root, 1, emit);
+    return results;
+}
+
+const JSONVariant* JSONQuery::selectFirst(const JSONVariant& root) const {
+    const JSONVariant* result = nullptr;
+    auto emit = [&](const JSONVariant* node) {
+        result = node;
+        return false;
+    };
+    walk<VariantNodes>(&root, 1, emit);
+    return result;
+}
+
+std::vector<JSONElement> JSONQuery::select(const JSONDocument& document) const {
+    std::vector<JSONElement> results;
+    auto emit = [&](JSONElement element) {
+        results.push_back(element);
+        return true;
+    };
+    if (JSONElement root = document.root()) {
+        walk<ElementNodes>(root, 1, emit);
+    }
+    return results;
+}
+
+JSONElement JSONQuery::selectFirst(const JSONDocument& document) const {
+    JSONElement result;
+    auto emit = [&](JSONElement element) {
+        result = element;
+        return false;
+    };
+    if (JSONElement root = document.root()) {
+        walk<ElementNodes>(root, 1, emit);
+    }
+    return result;
+}
+
+void JSONQuery::select(JSONReader& reader, const std::function<void(JSONVariant&&)>& onMatch) const {
+    advance(reader);
+    stream(reader, 1, onMatch);
+    advance(reader);                                                        // Validates that nothing follows the root
+}
+
+void JSONQuery::stream(JSONReader& reader, StateSet states, const std::function<void(JSONVariant&&)>& onMatch) const {
+    if ((states & finalState()) != 0) {
+        JSONVariant value = readValue(reader);
+
+        // Steps still pending below a selected value are matched on its decoded copy.
+        std::vector<JSONVariant> nested;
+        auto emit = [&](const JSONVariant* node) {
+            nested.push_back(*node);
+            return true;
+        };
+        if (StateSet rest = states & ~finalState()) {
+            walk<VariantNodes>(&value, rest, emit);
+        }
+
+        onMatch(std::move(value));
+        for (auto& match : nested) {
+            onMatch(std::move(match));
+        }
+        return;
+    }
+
+    if (reader.token() == JSONToken::BEGIN_OBJECT) {
+        while (advance(reader) != JSONToken::END_OBJECT) {
+            StateSet next = statesForMember(states, reader.stringValue());
+            advance(reader);
+            if (next != 0) {
+                stream(reader, next, onMatch);
+            } else {
+                skip(reader);
+            }
+        }
+    } else if (reader.token() == JSONToken::BEGIN_ARRAY) {
+        for (size_t index = 0; advance(reader) != JSONToken::END_ARRAY; ++index) {
+            StateSet next = statesForElement(states, index);
+            if (next != 0) {
+                stream(reader, next, onMatch);
+            } else {
+                skip(reader);
+            }
+        }
+    }
+}
+
+} // namespace sfcxx
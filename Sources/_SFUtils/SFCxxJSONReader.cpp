@@ -0,0 +1,319 @@
+//===-- _SFCxxUtils/SFCxxJSONReader.cpp - JSON Pull Parser ------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the event-based pull parser for JSON documents.
+///
+/// A token is only consumed once it is complete. If a chunked reader runs out
+/// of input in the middle of a token, the reader reports `NEED_MORE_INPUT` and
+/// parses the token again from its first byte once more input has arrived.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONReader.h"
+#include "include/SFCxxJSON.h"
+#include "include/SFCxxJSONNumber.h"
+#include "include/SFCxxJSONScanner.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+
+namespace sfcxx {
+
+namespace {
+
+inline bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool isDelimiter(char c) {
+    return isWhitespace(c) || c == ',' || c == ']' || c == '}';
+}
+
+inline bool isNumberCharacter(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+} // namespace
+
+JSONReader::JSONReader() : owning(true) {}
+
+JSONReader::JSONReader(std::string_view buffer)
+    : data(buffer.data()), size(buffer.size()), finished(true) {}
+
+JSONReader::JSONReader(int fd, size_t chunkSize)
+    : owning(true), fd(fd), chunkSize(chunkSize ? chunkSize : 1) {}
+
+void JSONReader::feed(const char* chunk, size_t length) {
+    if (!owning || fd >= 0 || finished) {
+        throw std::logic_error("JSONReader::feed requires an unfinished chunked reader");
+    }
+    compact();
+    storage.append(chunk, length);
+    data = storage.data();
+    size = storage.size();
+}
+
+void JSONReader::finish() {
+    if (!owning || fd >= 0) {
+        throw std::logic_error("JSONReader::finish requires a chunked reader");
+    }
+    finished = true;
+}
+
+JSONToken JSONReader::next() {
+    while (true) {
+        JSONToken token = readToken();
+        if (token == JSONToken::NEED_MORE_INPUT) {
+            if (fd >= 0 && !finished) {
+                fill();
+                continue;
+            }
+            return current = token;
+        }
+
+        current = token;
+        if (skipDepth != 0) {
+            bool completesValue = stack.size() + 1 == skipDepth && token != JSONToken::BEGIN_OBJECT &&
+                                  token != JSONToken::BEGIN_ARRAY && token != JSONToken::KEY;
+            if (!completesValue) continue;
+            skipDepth = 0;
+        }
+        return token;
+    }
+}
+
+JSONToken JSONReader::skipValue() {
+    if (current == JSONToken::BEGIN_OBJECT || current == JSONToken::BEGIN_ARRAY) {
+        skipDepth = stack.size();                                           // Target depth is one level up
+    } else if (current == JSONToken::KEY) {
+        skipDepth = stack.size() + 1;
+    } else {
+        return current;
+    }
+    return next();
+}
+
+JSONToken JSONReader::readToken() {
+    while (true) {
+        while (pos < size && isWhitespace(data[pos])) {
+            ++pos;
+        }
+        if (pos == size) {
+            if (!finished) return JSONToken::NEED_MORE_INPUT;
+            if (state == State::DONE) return JSONToken::END_OF_DOCUMENT;
+            fail("unexpected end of input");
+        }
+
+        char c = data[pos];
+        switch (state) {
+            case State::DONE:
+                fail("unexpected trailing characters");
+
+            case State::COMMA_OR_END: {
+                bool inObject = stack.back() == '{';
+                if (c == ',') {
+                    ++pos;
+                    state = inObject ? State::KEY : State::VALUE;
+                    continue;
+                }
+                if (c != (inObject ? '}' : ']')) {
+                    fail(inObject ? "expected ',' or '}'" : "expected ',' or ']'");
+                }
+                ++pos;
+                stack.pop_back();
+                afterValue();
+                return inObject ? JSONToken::END_OBJECT : JSONToken::END_ARRAY;
+            }
+
+            case State::COLON:
+                if (c != ':') fail("expected ':'");
+                ++pos;
+                state = State::VALUE;
+                continue;
+
+            case State::FIRST_KEY_OR_END:
+                if (c == '}') {
+                    ++pos;
+                    stack.pop_back();
+                    afterValue();
+                    return JSONToken::END_OBJECT;
+                }
+                [[fallthrough]];
+
+            case State::KEY:
+                if (c != '"') fail("expected an object key");
+                if (!readString()) return JSONToken::NEED_MORE_INPUT;
+                state = State::COLON;
+                return JSONToken::KEY;
+
+            case State::FIRST_VALUE_OR_END:
+                if (c == ']') {
+                    ++pos;
+                    stack.pop_back();
+                    afterValue();
+                    return JSONToken::END_ARRAY;
+                }
+                [[fallthrough]];
+
+            case State::VALUE:
+                switch (c) {
+                    case '{':
+                        ++pos;
+                        stack.push_back('{');
+                        state = State::FIRST_KEY_OR_END;
+                        return JSONToken::BEGIN_OBJECT;
+                    case '[':
+                        ++pos;
+                        stack.push_back('[');
+                        state = State::FIRST_VALUE_OR_END;
+                        return JSONToken::BEGIN_ARRAY;
+                    case '"':
+                        if (!readString()) return JSONToken::NEED_MORE_INPUT;
+                        afterValue();
+                        return JSONToken::STRING;
+                    case 't':
+                    case 'f':
+                        if (!readLiteral(c == 't' ? "true" : "false", c == 't' ? 4 : 5)) return JSONToken::NEED_MORE_INPUT;
+                        boolean = c == 't';
+                        afterValue();
+                        return JSONToken::BOOL;
+                    case 'n':
+                        if (!readLiteral("null", 4)) return JSONToken::NEED_MORE_INPUT;
+                        afterValue();
+                        return JSONToken::NUL;
+                    default:
+                        if (c != '-' && (c < '0' || c > '9')) fail("expected a value");
+                        if (!readNumber()) return JSONToken::NEED_MORE_INPUT;
+                        afterValue();
+                        return JSONToken::NUMBER;
+                }
+        }
+    }
+}
+
+bool JSONReader::readString() {
+    size_t end = pos + 1 + resumeScan;
+    while (true) {
+        end = JSONScanner::findQuoteOrBackslash(data, end, size);
+        if (end + 1 >= size && (end >= size || data[end] == '\\')) {
+            if (finished) fail("unterminated string");
+            resumeScan = end - pos - 1;                                     // Resume here once more input arrives
+            return false;
+        }
+        if (data[end] == '"') break;
+        end += 2;                                                           // Skip the escaped character
+    }
+    resumeScan = 0;
+
+    const char* body = data + pos + 1;
+    size_t length = end - pos - 1;
+    pos = end + 1;
+    if (std::memchr(body, '\\', length) == nullptr) {
+        text = std::string_view(body, length);                              // No escapes: point into the input
+        return true;
+    }
+
+    scratch.clear();
+    JSON::unescape(std::string_view(body, length), scratch);
+    text = scratch;
+    return true;
+}
+
+bool JSONReader::readNumber() {
+    size_t end = pos;
+    while (end < size && isNumberCharacter(data[end])) {
+        ++end;
+    }
+    if (end == size && !finished) return false;                             // More digits may follow
+
+    if (JSONNumber::parse(data + pos, data + end, number) != data + end ||
+        (end < size && !isDelimiter(data[end]))) {
+        fail("invalid number");
+    }
+    pos = end;
+    return true;
+}
+
+bool JSONReader::readLiteral(const char* literal, size_t length) {
+    size_t available = size - pos;
+    if (std::memcmp(data + pos, literal, std::min(available, length)) != 0) {
+        fail("invalid literal");
+    }
+    if (available <= length && !finished) return false;                     // Need the delimiter as well
+    if (available < length || (available > length && !isDelimiter(data[pos + length]))) {
+        fail("invalid literal");
+    }
+    pos += length;
+    return true;
+}
+
+bool JSONReader::fill() {
+    compact();
+    size_t old = storage.size();
+    storage.resize(old + chunkSize);
+
+    ssize_t n;
+    do {
+        n = ::read(fd, &storage[old], chunkSize);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        storage.resize(old);
+        throw std::system_error(errno, std::generic_category(), "JSONReader: read failed");
+    }
+
+    storage.resize(old + static_cast<size_t>(n));
+    data = storage.data();
+    size = storage.size();
+    finished = n == 0;
+    return n > 0;
+}
+
+void JSONReader::compact() {
+    // Only whole tokens are ever consumed, so everything before `pos` is garbage.
+    if (!owning || pos == 0 || pos < storage.size() / 2) return;
+    storage.erase(0, pos);
+    consumed += pos;
+    pos = 0;
+    data = storage.data();
+    size = storage.size();
+}
+
+void JSONReader::afterValue() {
+    state = stack.empty() ? State::DONE : State::COMMA_OR_END;
+}
+
+void JSONReader::fail(const char* what) const {
+    throw std::runtime_error("Malformed JSON at offset " + std::to_string(consumed + pos) + ": " + what);
+}
+
+} // namespace sfcxx
@@ -0,0 +1,482 @@
+//===-- _SFCxxUtils/SFCxxJSONScanner.cpp - Structural Scan ------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the vectorized first stage of the JSON decoder.
+///
+/// Every kernel only has to classify a 64-byte block into four bitmasks; the
+/// string tracking (escaped quotes, inside/outside of literals) and the
+/// extraction of offsets is shared, branch-free scalar bit arithmetic.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONScanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define SFC_JSON_SCAN_X86 1
+    #include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SFC_JSON_SCAN_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace sfcxx {
+
+namespace {
+
+/// \brief Character classes of one 64-byte block, one bit per byte.
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;
+    uint64_t whitespace;
+};
+
+using ClassifyFn = BlockMasks (*)(const uint8_t* block);
+using FindFn = size_t (*)(const char* data, size_t pos, size_t length);
+
+inline unsigned trailingZeros(uint64_t x) {
+    return static_cast<unsigned>(__builtin_ctzll(x));
+}
+
+/// Marks every byte preceded by an odd number of consecutive backslashes.
+inline uint64_t findEscapedCharacters(uint64_t backslash, uint64_t& prevEndsOddBackslash) {
+    const uint64_t evenBits = 0x5555555555555555ULL;
+    const uint64_t oddBits = ~evenBits;
+
+    uint64_t startEdges = backslash & ~(backslash << 1);
+    uint64_t evenStartMask = evenBits ^ prevEndsOddBackslash;
+    uint64_t evenStarts = startEdges & evenStartMask;
+    uint64_t oddStarts = startEdges & ~evenStartMask;
+    uint64_t evenCarries = backslash + evenStarts;
+
+    uint64_t oddCarries = backslash + oddStarts;
+    bool endsOddBackslash = oddCarries < backslash;                         // Carry out of bit 63
+    oddCarries |= prevEndsOddBackslash;
+    prevEndsOddBackslash = endsOddBackslash ? 1ULL : 0ULL;
+
+    uint64_t evenCarryEnds = evenCarries & ~backslash;
+    uint64_t oddCarryEnds = oddCarries & ~backslash;
+    return (evenCarryEnds & oddBits) | (oddCarryEnds & evenBits);
+}
+
+/// Turns every quote bit into a toggle: bit i is the XOR of bits 0...i.
+inline uint64_t prefixXor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/// \brief Carries the string state across blocks and emits the structural offsets.
+class StructuralWriter {
+public:
+    explicit StructuralWriter(std::vector<uint32_t>& positions) : positions(positions) {}
+
+    void finishBlock(const BlockMasks& masks, size_t base) {
+        uint64_t escaped = findEscapedCharacters(masks.backslash, prevEndsOddBackslash);
+        uint64_t quote = masks.quote & ~escaped;
+
+        uint64_t inString = prefixXor(quote) ^ prevInString;               // Opening quote set, closing quote clear
+        prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+        uint64_t scalar = ~(masks.op | masks.whitespace);
+        uint64_t nonQuoteScalar = scalar & ~quote;
+        uint64_t followsScalar = (nonQuoteScalar << 1) | prevScalar;
+        prevScalar = nonQuoteScalar >> 63;
+
+        uint64_t structurals = (masks.op | (scalar & ~followsScalar)) & ~(inString ^ quote);
+        emit(structurals, static_cast<uint32_t>(base));
+    }
+
+    void finish(JSONStructuralIndex& index) {
+        positions.resize(count);
+        index.unterminatedString = prevInString != 0;
+    }
+
+private:
+    std::vector<uint32_t>& positions;
+    size_t count = 0;
+    uint64_t prevEndsOddBackslash = 0;
+    uint64_t prevInString = 0;
+    uint64_t prevScalar = 0;
+
+    void emit(uint64_t bits, uint32_t base) {
+        if (bits == 0) return;
+        if (positions.size() < count + 64) {
+            positions.resize(std::max(count + 64, positions.size() * 2));
+        }
+        uint32_t* out = positions.data() + count;
+        while (bits) {
+            *out++ = base + trailingZeros(bits);
+            bits &= bits - 1;
+        }
+        count = static_cast<size_t>(out - positions.data());
+    }
+};
+
+template <ClassifyFn Classify>
+inline void scanBlocks(const char* data, size_t length, JSONStructuralIndex& index) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    StructuralWriter writer(index.positions);
+
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64) {
+        writer.finishBlock(Classify(bytes + i), i);
+    }
+    if (i < length) {
+        uint8_t tail[64];
+        std::memset(tail, ' ', sizeof(tail));                               // Pad the last block with whitespace
+        std::memcpy(tail, bytes + i, length - i);
+        writer.finishBlock(Classify(tail), i);
+    }
+    writer.finish(index);
+}
+
+size_t findQuoteOrBackslashScalar(const char* data, size_t pos, size_t length) {
+    while (pos < length && data[pos] != '"' && data[pos] != '\\') {
+        ++pos;
+    }
+    return pos;
+}
+
+inline bool needsEscape(char c) {
+    return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+size_t findEscapeScalar(const char* data, size_t pos, size_t length) {
+    while (pos < length && !needsEscape(data[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+#if defined(SFC_JSON_SCAN_X86)
+
+#pragma mark - SSE2 kernel
+
+BlockMasks classifySSE2(const uint8_t* block) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lowerBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');                            // '[' | 0x20 == '{'
+    const __m128i closeBrace = _mm_set1_epi8('}');                           // ']' | 0x20 == '}'
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i lineFeed = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+
+    BlockMasks masks = {0, 0, 0, 0};
+    for (unsigned i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i folded = _mm_or_si128(v, lowerBit);
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, lineFeed), _mm_cmpeq_epi8(v, carriageReturn)));
+        unsigned shift = 16 * i;
+        masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        masks.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        masks.op |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(op))) << shift;
+        masks.whitespace |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(ws))) << shift;
+    }
+    return masks;
+}
+
+size_t findQuoteOrBackslashSSE2(const char* data, size_t pos, size_t length) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; pos + 16 <= length; pos += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash))));
+        if (mask) return pos + trailingZeros(mask);
+    }
+    return findQuoteOrBackslashScalar(data, pos, length);
+}
+
+size_t findEscapeSSE2(const char* data, size_t pos, size_t length) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; pos + 16 <= length; pos += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i isControl = _mm_cmpeq_epi8(_mm_min_epu8(v, control), v);  // v <= 0x1f, unsigned
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_or_si128(isControl, _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)))));
+        if (mask) return pos + trailingZeros(mask);
+    }
+    return findEscapeScalar(data, pos, length);
+}
+
+void buildIndexSSE2(const char* data, size_t length, JSONStructuralIndex& index) {
+    scanBlocks<classifySSE2>(data, length, index);
+}
+
+#pragma mark - AVX2 kernel
+
+__attribute__((target("avx2")))
+BlockMasks classifyAVX2(const uint8_t* block) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i lowerBit = _mm256_set1_epi8(0x20);
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i lineFeed = _mm256_set1_epi8('\n');
+    const __m256i carriageReturn = _mm256_set1_epi8('\r');
+
+    BlockMasks masks = {0, 0, 0, 0};
+    for (unsigned i = 0; i < 2; ++i) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+        __m256i folded = _mm256_or_si256(v, lowerBit);
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, lineFeed), _mm256_cmpeq_epi8(v, carriageReturn)));
+        unsigned shift = 32 * i;
+        masks.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+        masks.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << shift;
+        masks.op |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(op))) << shift;
+        masks.whitespace |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ws))) << shift;
+    }
+    return masks;
+}
+
+__attribute__((target("avx2")))
+size_t findQuoteOrBackslashAVX2(const char* data, size_t pos, size_t length) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    for (; pos + 32 <= length; pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash))));
+        if (mask) return pos + trailingZeros(mask);
+    }
+    return findQuoteOrBackslashSSE2(data, pos, length);
+}
+
+__attribute__((target("avx2")))
+size_t findEscapeAVX2(const char* data, size_t pos, size_t length) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1f);
+    for (; pos + 32 <= length; pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i isControl = _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(isControl, _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)))));
+        if (mask) return pos + trailingZeros(mask);
+    }
+    return findEscapeSSE2(data, pos, length);
+}
+
+__attribute__((target("avx2")))
+void buildIndexAVX2(const char* data, size_t length, JSONStructuralIndex& index) {
+    scanBlocks<classifyAVX2>(data, length, index);
+}
+
+#elif defined(SFC_JSON_SCAN_NEON)
+
+#pragma mark - NEON kernel
+
+inline uint64_t movemask64(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d) {
+    const uint8x16_t weights = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(a, weights), vandq_u8(b, weights));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(c, weights), vandq_u8(d, weights));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+BlockMasks classifyNEON(const uint8_t* block) {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t lowerBit = vdupq_n_u8(0x20);
+    const uint8x16_t openBrace = vdupq_n_u8('{');
+    const uint8x16_t closeBrace = vdupq_n_u8('}');
+    const uint8x16_t colon = vdupq_n_u8(':');
+    const uint8x16_t comma = vdupq_n_u8(',');
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    const uint8x16_t lineFeed = vdupq_n_u8('\n');
+    const uint8x16_t carriageReturn = vdupq_n_u8('\r');
+
+    uint8x16_t q[4], b[4], o[4], w[4];
+    for (unsigned i = 0; i < 4; ++i) {
+        uint8x16_t v = vld1q_u8(block + 16 * i);
+        uint8x16_t folded = vorrq_u8(v, lowerBit);
+        q[i] = vceqq_u8(v, quote);
+        b[i] = vceqq_u8(v, backslash);
+        o[i] = vorrq_u8(vorrq_u8(vceqq_u8(folded, openBrace), vceqq_u8(folded, closeBrace)),
+                        vorrq_u8(vceqq_u8(v, colon), vceqq_u8(v, comma)));
+        w[i] = vorrq_u8(vorrq_u8(vceqq_u8(v, space), vceqq_u8(v, tab)),
+                        vorrq_u8(vceqq_u8(v, lineFeed), vceqq_u8(v, carriageReturn)));
+    }
+
+    BlockMasks masks;
+    masks.quote = movemask64(q[0], q[1], q[2], q[3]);
+    masks.backslash = movemask64(b[0], b[1], b[2], b[3]);
+    masks.op = movemask64(o[0], o[1], o[2], o[3]);
+    masks.whitespace = movemask64(w[0], w[1], w[2], w[3]);
+    return masks;
+}
+
+size_t findQuoteOrBackslashNEON(const char* data, size_t pos, size_t length) {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    for (; pos + 16 <= length; pos += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + pos));
+        if (vmaxvq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)))) break;
+    }
+    return findQuoteOrBackslashScalar(data, pos, length);
+}
+
+size_t findEscapeNEON(const char* data, size_t pos, size_t length) {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    for (; pos + 16 <= length; pos += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + pos));
+        uint8x16_t hit = vorrq_u8(vcltq_u8(v, space), vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)));
+        if (vmaxvq_u8(hit)) break;
+    }
+    return findEscapeScalar(data, pos, length);
+}
+
+void buildIndexNEON(const char* data, size_t length, JSONStructuralIndex& index) {
+    scanBlocks<classifyNEON>(data, length, index);
+}
+
+#else
+
+#pragma mark - Scalar kernel
+
+enum : uint8_t {
+    kClassQuote = 1,
+    kClassBackslash = 2,
+    kClassOp = 4,
+    kClassWhitespace = 8
+};
+
+struct ClassTable {
+    uint8_t entries[256] = {};
+    constexpr ClassTable() {
+        entries[static_cast<uint8_t>('"')] = kClassQuote;
+        entries[static_cast<uint8_t>('\\')] = kClassBackslash;
+        for (char c : {'{', '}', '[', ']', ':', ','}) entries[static_cast<uint8_t>(c)] = kClassOp;
+        for (char c : {' ', '\t', '\n', '\r'}) entries[static_cast<uint8_t>(c)] = kClassWhitespace;
+    }
+};
+
+constexpr ClassTable kClassTable;
+
+BlockMasks classifyScalar(const uint8_t* block) {
+    BlockMasks masks = {0, 0, 0, 0};
+    for (unsigned i = 0; i < 64; ++i) {
+        uint8_t cls = kClassTable.entries[block[i]];
+        uint64_t bit = 1ULL << i;
+        if (cls & kClassQuote) masks.quote |= bit;
+        if (cls & kClassBackslash) masks.backslash |= bit;
+        if (cls & kClassOp) masks.op |= bit;
+        if (cls & kClassWhitespace) masks.whitespace |= bit;
+    }
+    return masks;
+}
+
+void buildIndexScalar(const char* data, size_t length, JSONStructuralIndex& index) {
+    scanBlocks<classifyScalar>(data, length, index);
+}
+
+#endif
+
+#pragma mark - Runtime dispatch
+
+struct Kernel {
+    const char* name;
+    void (*buildIndex)(const char* data, size_t length, JSONStructuralIndex& index);
+    FindFn findQuoteOrBackslash;
+    FindFn findEscape;
+};
+
+Kernel detectKernel() {
+#if defined(SFC_JSON_SCAN_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        return {"avx2", buildIndexAVX2, findQuoteOrBackslashAVX2, findEscapeAVX2};
+    }
+    return {"sse2", buildIndexSSE2, findQuoteOrBackslashSSE2, findEscapeSSE2};
+#elif defined(SFC_JSON_SCAN_NEON)
+    return {"neon", buildIndexNEON, findQuoteOrBackslashNEON, findEscapeNEON};
+#else
+    return {"scalar", buildIndexScalar, findQuoteOrBackslashScalar, findEscapeScalar};
+#endif
+}
+
+const Kernel& activeKernelInstance() {
+    static const Kernel kernel = detectKernel();
+    return kernel;
+}
+
+} // namespace
+
+void JSONScanner::buildIndex(const char* data, size_t length, JSONStructuralIndex& index) {
+    if (length > UINT32_MAX) {
+        throw std::length_error("JSON document exceeds 4 GiB");
+    }
+    index.positions.clear();
+    index.unterminatedString = false;
+    activeKernelInstance().buildIndex(data, length, index);
+}
+
+size_t JSONScanner::findQuoteOrBackslash(const char* data, size_t pos, size_t length) {
+    return activeKernelInstance().findQuoteOrBackslash(data, pos, length);
+}
+
+size_t JSONScanner::findEscape(const char* data, size_t pos, size_t length) {
+    return activeKernelInstance().findEscape(data, pos, length);
+}
+
+const char* JSONScanner::activeKernel() {
+    return activeKernelInstance().name;
+}
+
+} // namespace sfcxx
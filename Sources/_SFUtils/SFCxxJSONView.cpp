@@ -0,0 +1,73 @@
+//===-- _SFCxxUtils/SFCxxJSONView.cpp - Zero-Copy JSON Values ---*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the value types produced by `JSON::decodeView`.
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCxxJSONView.h"
+#include "include/SFCxxJSON.h"
+
+namespace sfcxx {
+
+std::string_view JSONLazyString::value() const {
+    if (!escapes) {
+        return raw();
+    }
+    if (!decoded) {
+        auto text = std::make_shared<std::string>();
+        JSON::unescape(raw(), *text);
+        decoded = std::move(text);
+    }
+    return *decoded;
+}
+
+bool JSONLazyString::operator==(std::string_view other) const {
+    if (!escapes) {
+        return raw() == other;
+    }
+    // An escape sequence is never shorter than the character it stands for.
+    return length >= other.size() && value() == other;
+}
+
+const JSONViewValue* JSONViewValue::find(std::string_view key) const {
+    const auto* object = std::get_if<JSONViewObject>(&value);
+    if (object == nullptr) {
+        return nullptr;
+    }
+    // Scan from the end so a duplicate key resolves as `JSON::decode` resolves it.
+    for (auto member = object->rbegin(); member != object->rend(); ++member) {
+        if (member->first == key) {
+            return &member->second;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace sfcxx
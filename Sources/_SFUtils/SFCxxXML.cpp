@@ -0,0 +1,712 @@
+//===-- _SFCxxUtils/SFCxxXML.cpp - XML Canvas Layouts -----------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the libxml2-based canvas layout reader and writer declared in `SFCXML.h`.
+///
+//===----------------------------------------------------------------------===//
+
+#include "include/SFCXML.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libxml/xmlreader.h>
+
+namespace sfcxx {
+
+namespace {
+
+#pragma mark - Item reader
+
+/// The element of an item whose text is being collected.
+enum class ItemField { NONE, ID, TYPE, X, Y, WIDTH, HEIGHT, TEXT };
+
+/// The grouping element of an item that is currently open.
+enum class ItemGroup { NONE, POSITION, SIZE };
+
+/// Parses the text of a coordinate element, allowing surrounding whitespace.
+bool parseCoordinate(const std::string& text, int& value) {
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(begin, &end, 10);
+    if (end == begin || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) {
+        return false;
+    }
+    while (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r') ++end;
+    if (*end != '\0') {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+/// Turns the node stream of an `xmlTextReader` into `SFCXMLItem` records.
+///
+/// The text of the current item is collected into strings that are cleared,
+/// not released, between items, so after the first few items parsing no
+/// longer allocates and memory use stays constant.
+class CanvasItemReader {
+public:
+    explicit CanvasItemReader(xmlTextReaderPtr reader) : reader(reader) {}
+
+    /// Reads the whole document, calling `callback` once per item.
+    ///
+    /// \return 0, the callback's nonzero result, or `XML_ERR_PRASE`.
+    int read(SFCXMLItemCallback callback, void* context) {
+        int status;
+        while ((status = xmlTextReaderRead(reader)) == 1) {
+            switch (xmlTextReaderNodeType(reader)) {
+            case XML_READER_TYPE_ELEMENT:
+                if (!startElement()) return XML_ERR_PRASE;
+                if (xmlTextReaderIsEmptyElement(reader) && !endElement(xmlTextReaderDepth(reader))) {
+                    return XML_ERR_PRASE;
+                }
+                break;
+            case XML_READER_TYPE_END_ELEMENT:
+                if (!endElement(xmlTextReaderDepth(reader))) return XML_ERR_PRASE;
+                break;
+            case XML_READER_TYPE_TEXT:
+            case XML_READER_TYPE_CDATA:
+            case XML_READER_TYPE_WHITESPACE:
+            case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+                if (field != ItemField::NONE && xmlTextReaderDepth(reader) == fieldDepth + 1) {
+                    target()->append(reinterpret_cast<const char*>(xmlTextReaderConstValue(reader)));
+                }
+                break;
+            default:
+                break;
+            }
+
+            if (complete) {
+                complete = false;
+                if (int result = callback(&item, context)) return result;
+            }
+        }
+        return status == 0 ? 0 : XML_ERR_PRASE;
+    }
+
+private:
+    xmlTextReaderPtr reader;
+    SFCXMLItem item = {};
+    std::string id, type, text, number;     ///< Reused between items.
+    bool inItem = false;
+    bool complete = false;                  ///< Set when `item` is ready for delivery.
+    int itemDepth = 0;
+    int fieldDepth = 0;
+    ItemField field = ItemField::NONE;
+    ItemGroup group = ItemGroup::NONE;
+
+    std::string* target() {
+        switch (field) {
+        case ItemField::ID:   return &id;
+        case ItemField::TYPE: return &type;
+        case ItemField::TEXT: return &text;
+        default:              return &number;
+        }
+    }
+
+    bool startElement() {
+        const char* name = reinterpret_cast<const char*>(xmlTextReaderConstLocalName(reader));
+        int depth = xmlTextReaderDepth(reader);
+
+        if (!inItem) {
+            // Items are the direct children of the root element.
+            if (depth == 1 && std::strcmp(name, "item") == 0) {
+                inItem = true;
+                itemDepth = depth;
+                id.clear();
+                type.clear();
+                text.clear();
+                item = SFCXMLItem{};
+            }
+            return true;
+        }
+
+        field = ItemField::NONE;
+        int level = depth - itemDepth;
+        if (level == 1) {
+            group = ItemGroup::NONE;
+            if (std::strcmp(name, "id") == 0)               field = ItemField::ID;
+            else if (std::strcmp(name, "type") == 0)        field = ItemField::TYPE;
+            else if (std::strcmp(name, "text") == 0)        field = ItemField::TEXT;
+            else if (std::strcmp(name, "position") == 0)    group = ItemGroup::POSITION;
+            else if (std::strcmp(name, "size") == 0)        group = ItemGroup::SIZE;
+        } else if (level == 2 && group == ItemGroup::POSITION) {
+            if (std::strcmp(name, "x") == 0)                field = ItemField::X;
+            else if (std::strcmp(name, "y") == 0)           field = ItemField::Y;
+        } else if (level == 2 && group == ItemGroup::SIZE) {
+            if (std::strcmp(name, "width") == 0)            field = ItemField::WIDTH;
+            else if (std::strcmp(name, "height") == 0)      field = ItemField::HEIGHT;
+        }
+
+        if (field != ItemField::NONE) {
+            fieldDepth = depth;
+            target()->clear();
+        }
+        return true;
+    }
+
+    bool endElement(int depth) {
+        if (!inItem) {
+            return true;
+        }
+        if (depth == itemDepth) {
+            inItem = false;
+            field = ItemField::NONE;
+            group = ItemGroup::NONE;
+            item.id = id.c_str();
+            item.type = type.c_str();
+            item.text = text.c_str();
+            complete = true;
+            return true;
+        }
+        if (field == ItemField::NONE || depth != fieldDepth) {
+            if (depth == itemDepth + 1) group = ItemGroup::NONE;
+            return true;
+        }
+
+        bool valid = true;
+        switch (field) {
+        case ItemField::X:      valid = parseCoordinate(number, item.x); break;
+        case ItemField::Y:      valid = parseCoordinate(number, item.y); break;
+        case ItemField::WIDTH:  valid = parseCoordinate(number, item.width); break;
+        case ItemField::HEIGHT: valid = parseCoordinate(number, item.height); break;
+        default:                break;
+        }
+        field = ItemField::NONE;
+        return valid;
+    }
+};
+
+#pragma mark - Reader pool
+
+/// Options for every reader: never fetch external entities or DTDs over the network.
+constexpr int kReaderOptions = XML_PARSE_NONET;
+
+/// Initializes libxml2 the first time any function of this file runs.
+///
+/// `xmlCleanupParser` is deliberately never called: it would tear down state
+/// that readers on other threads, or in the pool, still use.
+void initializeParser() {
+    static const bool initialized = (xmlInitParser(), true);
+    (void)initialized;
+}
+
+/// \brief Idle `xmlTextReader`s shared by all threads.
+///
+/// A reader is reset onto new input with `xmlReaderNewFile` or
+/// `xmlReaderNewMemory`, which keeps its parser context, input buffers and
+/// name dictionary, so only the first parse on a reader pays for building
+/// them. At most one reader per hardware thread is kept; the pool is created
+/// on first use and lives until the process exits.
+class ReaderPool {
+public:
+    static ReaderPool& shared() {
+        static ReaderPool* pool = new ReaderPool(std::max(1u, std::thread::hardware_concurrency()));
+        return *pool;
+    }
+
+    /// Takes an idle reader, or returns `nullptr` if there is none.
+    xmlTextReaderPtr acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle.empty()) {
+            return nullptr;
+        }
+        xmlTextReaderPtr reader = idle.back();
+        idle.pop_back();
+        return reader;
+    }
+
+    /// Closes the reader's input and keeps it for the next parse, or frees it if the pool is full.
+    void release(xmlTextReaderPtr reader) {
+        xmlTextReaderClose(reader);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (idle.size() < capacity) {
+                idle.push_back(reader);
+                return;
+            }
+        }
+        xmlFreeTextReader(reader);
+    }
+
+private:
+    explicit ReaderPool(size_t capacity) : capacity(capacity) {
+        idle.reserve(capacity);
+    }
+
+    std::mutex mutex;
+    std::vector<xmlTextReaderPtr> idle;     ///< Guarded by `mutex`.
+    size_t capacity;
+};
+
+/// Borrows a reader from the shared pool for one parse and returns it afterwards.
+class ReaderLease {
+public:
+    ReaderLease() : reader(ReaderPool::shared().acquire()) {}
+    ~ReaderLease() {
+        if (reader != nullptr) ReaderPool::shared().release(reader);
+    }
+    ReaderLease(const ReaderLease&) = delete;
+    ReaderLease& operator=(const ReaderLease&) = delete;
+
+    /// Points the reader at a file. Returns false if the file cannot be opened.
+    bool openFile(const char* filename) {
+        if (reader == nullptr) {
+            reader = xmlReaderForFile(filename, nullptr, kReaderOptions);
+            return reader != nullptr;
+        }
+        return reset(xmlReaderNewFile(reader, filename, nullptr, kReaderOptions));
+    }
+
+    /// Points the reader at a buffer, which must outlive the parse.
+    bool openBuffer(const char* buffer, size_t length) {
+        if (length > INT_MAX) {
+            return false;
+        }
+        int size = static_cast<int>(length);
+        if (reader == nullptr) {
+            reader = xmlReaderForMemory(buffer, size, nullptr, nullptr, kReaderOptions);
+            return reader != nullptr;
+        }
+        return reset(xmlReaderNewMemory(reader, buffer, size, nullptr, nullptr, kReaderOptions));
+    }
+
+    xmlTextReaderPtr get() const { return reader; }
+
+private:
+    xmlTextReaderPtr reader;
+
+    /// A reader that failed to reset is in an unknown state and is not pooled again.
+    bool reset(int status) {
+        if (status != 0) {
+            xmlFreeTextReader(reader);
+            reader = nullptr;
+        }
+        return status == 0;
+    }
+};
+
+/// Parses the items of an opened lease, mapping allocation failures to `XML_ERR_PRASE`.
+int readItems(const ReaderLease& lease, SFCXMLItemCallback callback, void* context) {
+    try {
+        return CanvasItemReader(lease.get()).read(callback, context);
+    } catch (const std::bad_alloc&) {
+        return XML_ERR_PRASE;
+    }
+}
+
+#pragma mark - Item arrays
+
+/// Collects items for `parseXMLItemArray`.
+struct ItemArray {
+    SFCXMLItem* items;
+    size_t capacity;
+    size_t count;
+};
+
+/// Copies an item into the array, with its three strings in one allocation.
+int storeItem(const SFCXMLItem* item, void* context) {
+    auto* array = static_cast<ItemArray*>(context);
+    if (array->count < array->capacity) {
+        size_t idLength = std::strlen(item->id) + 1;
+        size_t typeLength = std::strlen(item->type) + 1;
+        size_t textLength = std::strlen(item->text) + 1;
+
+        char* strings = static_cast<char*>(std::malloc(idLength + typeLength + textLength));
+        if (strings == nullptr) {
+            return -1;
+        }
+        std::memcpy(strings, item->id, idLength);
+        std::memcpy(strings + idLength, item->type, typeLength);
+        std::memcpy(strings + idLength + typeLength, item->text, textLength);
+
+        SFCXMLItem& stored = array->items[array->count];
+        stored = *item;
+        stored.id = strings;
+        stored.type = strings + idLength;
+        stored.text = strings + idLength + typeLength;
+    }
+    ++array->count;
+    return 0;
+}
+
+/// Returns the result of `parseXMLItemArray` for a finished parse, releasing
+/// the stored items on error.
+long finishItemArray(const ItemArray& array, int result) {
+    if (result != 0) {
+        freeXMLItemArray(array.items, std::min(array.count, array.capacity));
+        return result == XML_ERR_PRASE ? XML_ERR_PRASE : -1;
+    }
+    return static_cast<long>(array.count);
+}
+
+/// Prints one child element of an item, with its content if it has any.
+void printElement(const char* name, const char* content) {
+    printf("Element: %s\n", name);
+    if (*content != '\0') {
+        printf("Content: %s\n", content);
+    }
+}
+
+/// Prints an item the way `parseXML` always has: the name and text of each
+/// child element. `position` and `size` have no text of their own.
+int printItem(const SFCXMLItem* item, void* /*context*/) {
+    printElement("id", item->id);
+    printElement("type", item->type);
+    printElement("position", "");
+    printElement("size", "");
+    printElement("text", item->text);
+    return 0;
+}
+
+#pragma mark - Item writer sinks
+
+/// Number of bytes the descriptor and `xmlTextWriter` sinks buffer before each write.
+constexpr size_t kWriteChunkSize = 64 * 1024;
+
+/// Fills a fixed buffer and keeps counting once it is full.
+class BufferSink {
+public:
+    BufferSink(char* data, size_t capacity) : data(data), capacity(capacity) {}
+
+    void write(const char* bytes, size_t length) {
+        if (count < capacity) {
+            std::memcpy(data + count, bytes, std::min(length, capacity - count));
+        }
+        count += length;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    char* data;
+    size_t capacity;
+    size_t count = 0;
+};
+
+/// Collects output in `kWriteChunkSize` chunks and hands each full chunk to `Derived::emit`.
+template <typename Derived>
+class ChunkSink {
+public:
+    ChunkSink() : buffer(new char[kWriteChunkSize]) {}
+
+    void write(const char* bytes, size_t length) {
+        if (length > kWriteChunkSize - used) {
+            flush();
+            if (length >= kWriteChunkSize) {
+                static_cast<Derived*>(this)->emit(bytes, length);           // Too large to be worth buffering
+                return;
+            }
+        }
+        std::memcpy(buffer.get() + used, bytes, length);
+        used += length;
+    }
+
+    void flush() {
+        if (used > 0) static_cast<Derived*>(this)->emit(buffer.get(), used);
+        used = 0;
+    }
+
+private:
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+};
+
+/// Writes to a file descriptor.
+class FileSink : public ChunkSink<FileSink> {
+public:
+    explicit FileSink(int fd) : fd(fd) {}
+
+    void emit(const char* bytes, size_t length) {
+        while (length > 0) {
+            ssize_t n = ::write(fd, bytes, length);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "writeItems: write failed");
+            }
+            bytes += n;
+            length -= static_cast<size_t>(n);
+        }
+    }
+
+private:
+    int fd;
+};
+
+/// Passes raw markup to an `xmlTextWriter`, which closes a pending start tag first.
+class TextWriterSink : public ChunkSink<TextWriterSink> {
+public:
+    explicit TextWriterSink(xmlTextWriterPtr writer) : writer(writer) {}
+
+    void emit(const char* bytes, size_t length) {
+        if (length > INT_MAX || xmlTextWriterWriteRawLen(writer, reinterpret_cast<const xmlChar*>(bytes),
+                                                         static_cast<int>(length)) < 0) {
+            throw std::system_error(EIO, std::generic_category(), "writeItems: xmlTextWriter failed");
+        }
+    }
+
+private:
+    xmlTextWriterPtr writer;
+};
+
+#pragma mark - Item writer
+
+/// The XML declaration `xmlTextWriterStartDocument` writes for UTF-8 documents.
+constexpr char kDeclaration[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+
+template <typename Sink, size_t N>
+void writeLiteral(Sink& out, const char (&text)[N]) {
+    out.write(text, N - 1);
+}
+
+/// Writes element text, escaping exactly what `xmlTextWriterWriteString` escapes.
+template <typename Sink>
+void writeEscaped(Sink& out, const char* text) {
+    while (true) {
+        size_t clean = std::strcspn(text, "<>&\"\r");
+        out.write(text, clean);                                             // Copy the clean span in bulk
+        text += clean;
+        switch (*text++) {
+            case '<':  writeLiteral(out, "&lt;"); break;
+            case '>':  writeLiteral(out, "&gt;"); break;
+            case '&':  writeLiteral(out, "&amp;"); break;
+            case '"':  writeLiteral(out, "&quot;"); break;
+            case '\r': writeLiteral(out, "&#13;"); break;
+            default:   return;
+        }
+    }
+}
+
+/// Writes `<name>text</name>`, or `<name/>` if `text` is NULL, as `writeElement` does.
+template <typename Sink, size_t N>
+void writeTextElement(Sink& out, const char (&name)[N], const char* text) {
+    out.write("<", 1);
+    out.write(name, N - 1);
+    if (text == nullptr) {
+        out.write("/>", 2);
+        return;
+    }
+    out.write(">", 1);
+    writeEscaped(out, text);
+    out.write("</", 2);
+    out.write(name, N - 1);
+    out.write(">", 1);
+}
+
+/// Writes `<name>value</name>`, formatting the integer without the C library.
+template <typename Sink, size_t N>
+void writeNumberElement(Sink& out, const char (&name)[N], int value) {
+    char element[2 * N + 16];
+    char* p = element;
+    *p++ = '<';
+    std::memcpy(p, name, N - 1);
+    p += N - 1;
+    *p++ = '>';
+    p = std::to_chars(p, element + sizeof(element), value).ptr;
+    *p++ = '<';
+    *p++ = '/';
+    std::memcpy(p, name, N - 1);
+    p += N - 1;
+    *p++ = '>';
+    out.write(element, static_cast<size_t>(p - element));
+}
+
+/// Writes items with the same markup as a sequence of `writeItem` calls.
+template <typename Sink>
+void writeItemElements(Sink& out, const SFCXMLItem* items, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const SFCXMLItem& item = items[i];
+        writeLiteral(out, "<item>");
+        writeTextElement(out, "id", item.id);
+        writeTextElement(out, "type", item.type);
+        writeLiteral(out, "<position>");
+        writeNumberElement(out, "x", item.x);
+        writeNumberElement(out, "y", item.y);
+        writeLiteral(out, "</position><size>");
+        writeNumberElement(out, "width", item.width);
+        writeNumberElement(out, "height", item.height);
+        writeLiteral(out, "</size>");
+        writeTextElement(out, "text", item.text);
+        writeLiteral(out, "</item>");
+    }
+}
+
+/// Writes a complete document, as `startXMLDocument`, a root element, `writeItem`
+/// for every item and `endXMLDocument` would.
+template <typename Sink>
+void writeItemDocument(Sink& out, const char* rootElement, const SFCXMLItem* items, size_t count) {
+    size_t rootLength = std::strlen(rootElement);
+    writeLiteral(out, kDeclaration);
+    out.write("<", 1);
+    out.write(rootElement, rootLength);
+    if (count == 0) {
+        writeLiteral(out, "/>\n");
+        return;
+    }
+    out.write(">", 1);
+    writeItemElements(out, items, count);
+    out.write("</", 2);
+    out.write(rootElement, rootLength);
+    writeLiteral(out, ">\n");
+}
+
+/// Runs a write, mapping exceptions to -1 and `errno`.
+template <typename Body>
+int catchWriteErrors(Body body) {
+    try {
+        body();
+        return 0;
+    } catch (const std::system_error& error) {
+        errno = error.code().value();
+        return -1;
+    } catch (const std::exception&) {
+        errno = ENOMEM;
+        return -1;
+    }
+}
+
+} // namespace
+
+} // namespace sfcxx
+
+extern "C" {
+void parseXML(const char* filename) {
+    if (parseXMLItems(filename, sfcxx::printItem, nullptr) == XML_ERR_PRASE) {
+        fprintf(stderr, "Failed to parse XML file: %s\n", filename);
+    }
+}
+
+int parseXMLItems(const char* filename, SFCXMLItemCallback callback, void* context) {
+    sfcxx::initializeParser();
+
+    sfcxx::ReaderLease lease;
+    if (!lease.openFile(filename)) {
+        return XML_ERR_PRASE;
+    }
+    return sfcxx::readItems(lease, callback, context);
+}
+
+int parseXMLItemsFromBuffer(const char* buffer, size_t length, SFCXMLItemCallback callback, void* context) {
+    sfcxx::initializeParser();
+
+    sfcxx::ReaderLease lease;
+    if (!lease.openBuffer(buffer, length)) {
+        return XML_ERR_PRASE;
+    }
+    return sfcxx::readItems(lease, callback, context);
+}
+
+long parseXMLItemArray(const char* filename, SFCXMLItem* items, size_t capacity) {
+    sfcxx::ItemArray array = { items, capacity, 0 };
+    return sfcxx::finishItemArray(array, parseXMLItems(filename, sfcxx::storeItem, &array));
+}
+
+long parseXMLItemArrayFromBuffer(const char* buffer, size_t length, SFCXMLItem* items, size_t capacity) {
+    sfcxx::ItemArray array = { items, capacity, 0 };
+    return sfcxx::finishItemArray(array, parseXMLItemsFromBuffer(buffer, length, sfcxx::storeItem, &array));
+}
+
+void freeXMLItemArray(SFCXMLItem* items, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        std::free(const_cast<char*>(items[i].id));
+        items[i].id = items[i].type = items[i].text = nullptr;
+    }
+}
+
+xmlTextWriterPtr startXMLDocument(const char *filename) {
+    sfcxx::initializeParser();
+
+    xmlTextWriterPtr writer = xmlNewTextWriterFilename(filename, 0);
+    if (writer == NULL) {
+        fprintf(stderr, "Error creating the xml writer\n");
+        return NULL;
+    }
+    xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL);
+    return writer;
+}
+
+void writeElement(xmlTextWriterPtr writer, const char *elementName, const char *textContent) {
+    xmlTextWriterStartElement(writer, (const xmlChar *)elementName);
+    if (textContent != NULL) {
+        xmlTextWriterWriteString(writer, (const xmlChar *)textContent);
+    }
+    xmlTextWriterEndElement(writer);
+}
+
+void writeItem(xmlTextWriterPtr writer, const char *id, const char *type, int x, int y, int width, int height, const char *textFile) {
+    SFCXMLItem item = { id, type, x, y, width, height, textFile };
+    writeItems(writer, &item, 1);
+}
+
+int writeItems(xmlTextWriterPtr writer, const SFCXMLItem* items, size_t count) {
+    return sfcxx::catchWriteErrors([&] {
+        sfcxx::TextWriterSink sink(writer);
+        sfcxx::writeItemElements(sink, items, count);
+        sink.flush();
+    });
+}
+
+size_t writeItemsToBuffer(const char* rootElement, const SFCXMLItem* items, size_t count, char* buffer, size_t capacity) {
+    sfcxx::BufferSink sink(buffer, capacity);
+    sfcxx::writeItemDocument(sink, rootElement, items, count);
+    return sink.size();
+}
+
+int writeItemsToFd(const char* rootElement, const SFCXMLItem* items, size_t count, int fd) {
+    return sfcxx::catchWriteErrors([&] {
+        sfcxx::FileSink sink(fd);
+        sfcxx::writeItemDocument(sink, rootElement, items, count);
+        sink.flush();
+    });
+}
+
+int writeItemsToFile(const char* filename, const char* rootElement, const SFCXMLItem* items, size_t count) {
+    int fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    int result = writeItemsToFd(rootElement, items, count, fd);
+    int saved = errno;
+    if (::close(fd) != 0 && result == 0) {
+        return -1;
+    }
+    errno = saved;
+    return result;
+}
+
+void endXMLDocument(xmlTextWriterPtr writer) {
+    xmlTextWriterEndDocument(writer);
+    xmlFreeTextWriter(writer);
+}
+}
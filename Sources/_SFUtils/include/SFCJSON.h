@@ -43,6 +43,8 @@
 #ifndef SFCJSON_h
 #define SFCJSON_h
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -65,8 +67,8 @@ typedef void* JSONVariant;
  * @param value The JSON variant to encode. This can be of any JSON data type, including
  *              null, boolean, numeric, string, arrays, and objects.
  *
- * @return A null-terminated C-style string representing the encoded JSON data. The caller
- *         is responsible for freeing the allocated memory for the returned string.
+ * @return A null-terminated C-style string representing the encoded JSON data, or `NULL`
+ *         if memory allocation fails.
  *
  * @note The returned string is allocated dynamically and must be deallocated using the
  *       `free` function to avoid memory leaks.
@@ -74,7 +76,44 @@ typedef void* JSONVariant;
  * @warning The caller is responsible for freeing the allocated memory for the returned
  *          string using the `free` function. Failure to do so may lead to memory leaks.
  */
-const char* json_encode(JSONVariant value);
+char* json_encode(JSONVariant value);
+
+/**
+ * @brief Returns the length of the JSON string a JSON variant encodes to.
+ *
+ * @param value The JSON variant to measure.
+ *
+ * @return The encoded length in bytes, excluding a terminator.
+ */
+size_t json_encoded_size(JSONVariant value);
+
+/**
+ * @brief Encodes a JSON variant into a caller-provided buffer.
+ *
+ * Like `snprintf`, at most `capacity - 1` bytes are written, followed by a terminator.
+ * A buffer of `json_encoded_size(value) + 1` bytes always holds the complete output.
+ *
+ * @param value The JSON variant to encode.
+ * @param buffer The output buffer. May be `NULL` if `capacity` is 0.
+ * @param capacity Size of `buffer` in bytes.
+ *
+ * @return The full encoded length, excluding the terminator. A return value of
+ *         `capacity` or more means the output was truncated.
+ */
+size_t json_encode_to_buffer(JSONVariant value, char* buffer, size_t capacity);
+
+/**
+ * @brief Encodes a JSON variant directly to a file descriptor.
+ *
+ * The output is written in fixed-size chunks while it is produced, so large documents
+ * are never held in memory as a whole.
+ *
+ * @param value The JSON variant to encode.
+ * @param fd An open, writable file descriptor. It is not closed.
+ *
+ * @return 0 on success, or -1 if a write fails, with `errno` set accordingly.
+ */
+int json_encode_to_fd(JSONVariant value, int fd);
 
 /**
  * @brief Decodes a JSON string into a JSON variant.
@@ -85,19 +124,69 @@ const char* json_encode(JSONVariant value);
  *
  * @param json The JSON string to decode. The input string must be null-terminated.
  *
- * @return A JSONVariant representing the decoded JSON data. The caller is responsible
- *         for freeing the memory allocated for the JSON variant using the `free_json`
- *         function.
+ * @return A JSONVariant representing the decoded JSON data, or `NULL` if the input is
+ *         not well-formed JSON. The caller is responsible for freeing the memory allocated
+ *         for the JSON variant using the `free_json` function.
  *
- * @note The `json_decode` function does not validate the input JSON string for correctness.
- *       It assumes that the input string is a valid JSON string. If the input string is
- *       not a valid JSON string, the behavior of the function is undefined.
+ * @note The structure of the input is validated while decoding; malformed documents are
+ *       rejected instead of being partially decoded.
  *
  * @warning The caller is responsible for freeing the memory allocated for the JSON variant
  *          using the `free_json` function. Failure to do so may lead to memory leaks.
  */
 JSONVariant json_decode(const char* json);
 
+/**
+ * @brief Encodes a JSON variant as CBOR, a compact binary form of the same data.
+ *
+ * The output starts with the CBOR self-describe tag, so `json_decode_buffer` can tell it
+ * apart from JSON text. Every JSON variant survives a round trip through CBOR unchanged.
+ *
+ * @param value The JSON variant to encode.
+ * @param length Receives the number of encoded bytes. The output is not null-terminated.
+ *
+ * @return The encoded bytes, or `NULL` if memory allocation fails. The caller is
+ *         responsible for freeing the buffer using `free`.
+ */
+char* json_encode_cbor(JSONVariant value, size_t* length);
+
+/**
+ * @brief Encodes a JSON variant as CBOR directly to a file descriptor.
+ *
+ * @param value The JSON variant to encode.
+ * @param fd An open, writable file descriptor. It is not closed.
+ *
+ * @return 0 on success, or -1 if a write fails, with `errno` set accordingly.
+ */
+int json_encode_cbor_to_fd(JSONVariant value, int fd);
+
+/**
+ * @brief Decodes a buffer that holds either JSON text or CBOR into a JSON variant.
+ *
+ * The format is detected from the first bytes of the buffer; see `json_encode_cbor`.
+ *
+ * @param data The encoded document. It does not need to be null-terminated.
+ * @param length The number of bytes in `data`.
+ *
+ * @return A JSONVariant representing the decoded data, or `NULL` if the input is
+ *         malformed. The caller is responsible for freeing it using `free_json`.
+ */
+JSONVariant json_decode_buffer(const char* data, size_t length);
+
+/**
+ * @brief Decodes newline-delimited JSON into an array with one element per record.
+ *
+ * Large buffers are split on line boundaries and decoded on several threads; the
+ * records keep their input order. Blank lines are skipped.
+ *
+ * @param data The NDJSON text. It does not need to be null-terminated.
+ * @param length The number of bytes in `data`.
+ *
+ * @return A JSONVariant holding an array of the records, or `NULL` if any record is
+ *         malformed. The caller is responsible for freeing it using `free_json`.
+ */
+JSONVariant json_decode_lines(const char* data, size_t length);
+
 /**
  * @brief Frees the memory allocated for a JSON variant.
  *
@@ -287,6 +376,348 @@ void json_set_array(JSONVariant obj, const char* key, JSONVariant value);
  */
 void json_array_append_object(JSONVariant array, JSONVariant value);
 
+/**
+ * @brief Represents a validated JSON buffer for on-demand field access.
+ *
+ * A JSONDocument reads single fields of a document without decoding it into
+ * JSON variants. Fields are addressed by a dot-separated path of object keys,
+ * such as `"project.name"`; an empty path addresses the root value.
+ */
+typedef void* JSONDocument;
+
+/**
+ * @brief Creates an empty JSON document.
+ *
+ * A single document can be loaded with many buffers in turn, which reuses its
+ * index memory across loads.
+ *
+ * @return A new JSONDocument, or `NULL` if memory allocation fails. The caller is
+ *         responsible for freeing it using the `json_document_free` function.
+ */
+JSONDocument json_document_create(void);
+
+/**
+ * @brief Validates and indexes a JSON buffer.
+ *
+ * @param document The document to load the buffer into.
+ * @param json The JSON text. It does not need to be null-terminated.
+ * @param length Length of the JSON text in bytes.
+ *
+ * @return 0 on success, or -1 if the input is not well-formed JSON.
+ *
+ * @warning The buffer is not copied. It must remain valid until the document is
+ *          freed or loaded with another buffer.
+ */
+int json_document_load(JSONDocument document, const char* json, size_t length);
+
+/**
+ * @brief Reads a string field of a loaded document.
+ *
+ * The unescaped string is copied into `buffer` and null-terminated, truncating
+ * it if `capacity` is too small.
+ *
+ * @param document The loaded document.
+ * @param path Dot-separated path of object keys.
+ * @param buffer Output buffer of `capacity` bytes. May be `NULL` if `capacity` is 0.
+ * @param capacity Size of `buffer` in bytes.
+ *
+ * @return The full length of the string, excluding the terminator, or -1 if the
+ *         field does not exist or is not a string.
+ */
+long json_document_get_string(JSONDocument document, const char* path, char* buffer, size_t capacity);
+
+/**
+ * @brief Reads a numeric field of a loaded document.
+ *
+ * @param document The loaded document.
+ * @param path Dot-separated path of object keys.
+ * @param value Receives the number.
+ *
+ * @return 0 on success, or -1 if the field does not exist or is not a number.
+ */
+int json_document_get_number(JSONDocument document, const char* path, double* value);
+
+/**
+ * @brief Reads a boolean field of a loaded document.
+ *
+ * @param document The loaded document.
+ * @param path Dot-separated path of object keys.
+ * @param value Receives 1 for `true` and 0 for `false`.
+ *
+ * @return 0 on success, or -1 if the field does not exist or is not a boolean.
+ */
+int json_document_get_bool(JSONDocument document, const char* path, int* value);
+
+/**
+ * @brief Frees a JSON document. The loaded buffer itself is not freed.
+ *
+ * @param document The document to free.
+ */
+void json_document_free(JSONDocument document);
+
+/**
+ * @brief An opaque handle to a JSON Patch (RFC 6902).
+ *
+ * A patch is an ordered list of edits addressed by JSON Pointers, such as
+ * `"/flags/is_Favorite"`. Edits appended to one patch are applied together:
+ * either all of them succeed or the target is left unchanged.
+ */
+typedef void* JSONPatch;
+
+/**
+ * @brief Creates an empty JSON patch.
+ *
+ * @return A new JSONPatch, or `NULL` if memory allocation fails. The caller is
+ *         responsible for freeing it using the `json_patch_free` function.
+ */
+JSONPatch json_patch_create(void);
+
+/**
+ * @brief Creates a JSON patch from the text of an RFC 6902 patch document.
+ *
+ * @param json The patch document, an array of operation objects. It does not need to be null-terminated.
+ * @param length The number of bytes in `json`.
+ *
+ * @return A new JSONPatch, or `NULL` if the document is malformed. The caller is
+ *         responsible for freeing it using the `json_patch_free` function.
+ */
+JSONPatch json_patch_parse(const char* json, size_t length);
+
+/**
+ * @brief Appends an `add` operation: sets an object member or inserts an array element.
+ *
+ * @param patch The patch to append to.
+ * @param path A JSON Pointer to the new value. The last token `-` appends to an array.
+ * @param value The value to add. It is copied; the caller keeps ownership.
+ *
+ * @return 0 on success, or -1 if `path` is not a valid JSON Pointer.
+ */
+int json_patch_add(JSONPatch patch, const char* path, JSONVariant value);
+
+/**
+ * @brief Appends a `remove` operation.
+ *
+ * @return 0 on success, or -1 if `path` is not a valid JSON Pointer.
+ */
+int json_patch_remove(JSONPatch patch, const char* path);
+
+/**
+ * @brief Appends a `replace` operation, which requires the value at `path` to exist.
+ *
+ * @return 0 on success, or -1 if `path` is not a valid JSON Pointer.
+ */
+int json_patch_replace(JSONPatch patch, const char* path, JSONVariant value);
+
+/**
+ * @brief Applies a patch to a JSON variant.
+ *
+ * @return 0 on success, or -1 if an operation fails, in which case `document` is unchanged.
+ */
+int json_patch_apply(JSONPatch patch, JSONVariant document);
+
+/**
+ * @brief Applies a patch to an encoded document without decoding it into JSON variants.
+ *
+ * JSON text is edited in place: only the bytes of the changed values are rewritten and the
+ * rest of the document keeps its formatting. CBOR documents are decoded, patched and
+ * re-encoded.
+ *
+ * @param patch The patch to apply.
+ * @param data The encoded document, JSON text or CBOR.
+ * @param length The number of bytes in `data`.
+ * @param outLength Receives the length of the patched document, without the null terminator.
+ *
+ * @return The patched document, null-terminated, or `NULL` if the document is malformed or an
+ *         operation fails. The caller is responsible for freeing it using `free`.
+ */
+char* json_patch_apply_buffer(JSONPatch patch, const char* data, size_t length, size_t* outLength);
+
+/**
+ * @brief Applies a JSON Merge Patch (RFC 7386) to a JSON variant.
+ *
+ * Members of `patch` that are null are removed from `target`, objects are merged recursively
+ * and all other values replace the existing ones.
+ *
+ * @return 0 on success, or -1 if memory allocation fails.
+ */
+int json_merge_patch(JSONVariant target, JSONVariant patch);
+
+/**
+ * @brief Frees a JSON patch.
+ */
+void json_patch_free(JSONPatch patch);
+
+/**
+ * @brief The maximum number of nested objects and arrays a JSONBuilder can open.
+ */
+#define JSON_BUILDER_MAX_DEPTH 64
+
+/**
+ * @brief Writes JSON text directly into a buffer, one value at a time.
+ *
+ * A builder produces a document without creating JSON variants: containers are opened
+ * and closed with the `json_builder_begin_*` and `json_builder_end_*` functions, and
+ * keys and values are written in document order. Commas, colons and escaping are
+ * handled by the builder.
+ *
+ * The struct is meant to live on the stack. Calls never fail individually; the first
+ * error is recorded in `error` and reported by `json_builder_finish`.
+ *
+ * Example usage:
+ * @code
+ *   char storage[1024];
+ *   JSONBuilder builder;
+ *   json_builder_init(&builder, storage, sizeof(storage), 1);
+ *   json_builder_begin_object(&builder);
+ *   json_builder_key(&builder, "is_Favorite");
+ *   json_builder_bool(&builder, 1);
+ *   json_builder_end_object(&builder);
+ *   if (json_builder_finish(&builder) >= 0) {
+ *       puts(builder.data);
+ *   }
+ *   json_builder_free(&builder);
+ * @endcode
+ */
+typedef struct {
+    char* data;                     ///< The output. Starts as the caller's buffer.
+    size_t length;                  ///< Bytes written so far, or required for a fixed buffer that overflowed.
+    size_t capacity;                ///< Size of `data` in bytes.
+    int growable;                   ///< Whether the output may move to the heap when `data` is full.
+    int allocated;                  ///< Whether `data` is heap memory owned by the builder.
+    int error;                      ///< Nonzero once a call has failed.
+    int afterKey;                   ///< Whether the next value belongs to a key just written.
+    unsigned depth;                 ///< Number of open containers.
+    unsigned long long hasItems;    ///< Bit `n`: the container at depth `n + 1` has an item.
+    unsigned long long isObject;    ///< Bit `n`: the container at depth `n + 1` is an object.
+} JSONBuilder;
+
+/**
+ * @brief Prepares a builder to write into a caller-owned buffer.
+ *
+ * @param builder The builder to initialize.
+ * @param buffer The output buffer. May be `NULL` if `capacity` is 0.
+ * @param capacity Size of `buffer` in bytes.
+ * @param growable If nonzero, the output is moved to a heap buffer owned by the builder
+ *                 once `buffer` is full; free it with `json_builder_free`. If zero, writing
+ *                 past `capacity` is an error, but `length` keeps counting so the caller
+ *                 can retry with a buffer of `length + 1` bytes.
+ */
+void json_builder_init(JSONBuilder* builder, char* buffer, size_t capacity, int growable);
+
+/**
+ * @brief Opens an object as the next value.
+ *
+ * Inside an object the call must follow a key. Opening more than
+ * `JSON_BUILDER_MAX_DEPTH` containers, or a second root value, sets `builder->error`.
+ *
+ * @param builder The builder to write to.
+ */
+void json_builder_begin_object(JSONBuilder* builder);
+
+/**
+ * @brief Closes the innermost open container, which must be an object.
+ *
+ * Closing an array, closing with nothing open, or closing right after a key
+ * sets `builder->error` and writes nothing.
+ *
+ * @param builder The builder to write to.
+ */
+void json_builder_end_object(JSONBuilder* builder);
+
+/**
+ * @brief Opens an array as the next value.
+ *
+ * Inside an object the call must follow a key. Opening more than
+ * `JSON_BUILDER_MAX_DEPTH` containers, or a second root value, sets `builder->error`.
+ *
+ * @param builder The builder to write to.
+ */
+void json_builder_begin_array(JSONBuilder* builder);
+
+/**
+ * @brief Closes the innermost open container, which must be an array.
+ *
+ * Closing an object, closing with nothing open, or closing right after a key
+ * sets `builder->error` and writes nothing.
+ *
+ * @param builder The builder to write to.
+ */
+void json_builder_end_array(JSONBuilder* builder);
+
+/**
+ * @brief Writes an object key. The next call must write its value.
+ *
+ * Writing a key outside an object or directly after another key sets `builder->error`.
+ *
+ * @param builder The builder to write to.
+ * @param key The null-terminated key. It is escaped as needed.
+ */
+void json_builder_key(JSONBuilder* builder, const char* key);
+
+/**
+ * @brief Writes a string as the next value.
+ *
+ * Like every value, it must follow a key inside an object; writing it in the
+ * wrong place, or as a second root value, sets `builder->error`.
+ *
+ * @param builder The builder to write to.
+ * @param value The null-terminated string. Quotes, backslashes and control
+ *              characters are escaped.
+ */
+void json_builder_string(JSONBuilder* builder, const char* value);
+
+/**
+ * @brief Writes a number as the next value, in its shortest round-trip form.
+ *
+ * Infinities and NaN have no JSON representation and are written as `null`.
+ * A misplaced value sets `builder->error`, as for `json_builder_string`.
+ *
+ * @param builder The builder to write to.
+ * @param value The number to write.
+ */
+void json_builder_number(JSONBuilder* builder, double value);
+
+/**
+ * @brief Writes `true` or `false` as the next value.
+ *
+ * A misplaced value sets `builder->error`, as for `json_builder_string`.
+ *
+ * @param builder The builder to write to.
+ * @param value Nonzero for `true`, 0 for `false`.
+ */
+void json_builder_bool(JSONBuilder* builder, int value);
+
+/**
+ * @brief Writes `null` as the next value.
+ *
+ * A misplaced value sets `builder->error`, as for `json_builder_string`.
+ *
+ * @param builder The builder to write to.
+ */
+void json_builder_null(JSONBuilder* builder);
+
+/**
+ * @brief Writes `length` bytes of already encoded JSON as the next value.
+ *
+ * The text is copied as it is and not validated; it must be exactly one JSON value.
+ */
+void json_builder_raw(JSONBuilder* builder, const char* json, size_t length);
+
+/**
+ * @brief Completes the document and null-terminates `builder->data`.
+ *
+ * @return The length of the document, or -1 if a call failed, the output did not fit
+ *         a fixed buffer, or a container is still open.
+ */
+long json_builder_finish(JSONBuilder* builder);
+
+/**
+ * @brief Frees the heap buffer of a growable builder, if it allocated one.
+ *
+ * The caller's buffer is never freed. `builder->data` is invalid afterwards.
+ */
+void json_builder_free(JSONBuilder* builder);
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,67 +19,137 @@
 //===----------------------------------------------------------------------===//
 ///
 /// \file
+/// \brief Reads and writes canvas layouts as XML using libxml2.
 ///
 //===----------------------------------------------------------------------===//
 
 #ifndef SFCXML_h
 #define SFCXML_h
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-
+#include <stddef.h>
 #include <stdio.h>
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 #include <libxml/xmlwriter.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define XML_ERR_PRASE -30
 
+/**
+ * A canvas item as read from, or written to, an XML document.
+ *
+ * The layout mirrors the element structure written by `writeItem`:
+ * `<item><id/><type/><position><x/><y/></position><size><width/><height/></size><text/></item>`.
+ * Missing string elements are reported as empty strings, missing numbers as 0.
+ */
+typedef struct SFCXMLItem {
+    const char* id;             ///< The unique identifier of the item.
+    const char* type;           ///< The type of the item.
+    int x;                      ///< The x-coordinate of the item position.
+    int y;                      ///< The y-coordinate of the item position.
+    int width;                  ///< The width of the item.
+    int height;                 ///< The height of the item.
+    const char* text;           ///< The name of the text file associated with the item.
+} SFCXMLItem;
+
+/**
+ * Receives one item from `parseXMLItems`.
+ *
+ * @param item The parsed item. Its strings are owned by the parser and are only valid until the callback returns.
+ * @param context The context pointer passed to `parseXMLItems`.
+ *
+ * @return 0 to continue parsing, or any other value to stop.
+ */
+typedef int (*SFCXMLItemCallback)(const SFCXMLItem* item, void* context);
+
 /**
  * Parses an XML file and prints the content of each 'item' element.
  *
  * @param filename The path to the XML file to be parsed.
  *
- * This function initializes the XML parser, reads the specified XML file, and then iterates through each 'item' element.
- * For each 'item' element, it prints the name of each child element and its corresponding content.
+ * This function streams the specified XML file through `parseXMLItems` and prints the name and content of each
+ * child element of every 'item' element, in the order `writeItem` writes them.
  * If the XML file cannot be parsed, an error message is printed to stderr.
  *
  * @return void
  */
-void parseXML(const char* filename) {
-    xmlDoc *doc = NULL;                   // TODO: NULL ~> nullptr
-    xmlNode *root_element = NULL;
-    
-    xmlInitParser();
-    
-    doc = xmlReadFile(filename, NULL, 0);
-    if (doc == NULL) {
-        fprintf(stderr, "Failed to parse XML file: %s\n", filename);
-        return;
-    }
-
-    root_element = xmlDocGetRootElement(doc);
-
-    for (xmlNode *node = root_element->children; node; node = node->next) {
-        if (node->type == XML_ELEMENT_NODE && xmlStrcmp(node->name, (const xmlChar *)"item") == 0) {
-            xmlNode *child = node->children;
-            while (child) {
-                if (child->type == XML_ELEMENT_NODE) {
-                    printf("Element: %s\n", child->name);
-                    xmlNode *textNode = child->children;
-                    if (textNode && textNode->type == XML_TEXT_NODE) {
-                        printf("Content: %s\n", xmlNodeGetContent(textNode));
-                    }
-                }
-                child = child->next;
-            }
-        }
-    }
-
-    xmlFreeDoc(doc);
-    xmlCleanupParser();
-}
+void parseXML(const char* filename);
+
+/**
+ * Streams the 'item' elements of an XML file to a callback.
+ *
+ * @param filename The path to the XML file to be parsed.
+ * @param callback The function receiving each item, in document order.
+ * @param context An arbitrary pointer passed through to `callback`.
+ *
+ * The file is read with an `xmlTextReader`, so no document tree is built and memory use does not depend on the
+ * number of items. Only 'item' elements that are direct children of the root element are reported.
+ *
+ * libxml2 is initialized once per process, and readers are taken from a pool shared by all threads and reset onto
+ * each new input, so concurrent calls from any number of threads are safe and do not repeat the parser setup.
+ *
+ * @return 0 on success, the nonzero value returned by `callback` if it stopped parsing, or `XML_ERR_PRASE` if the
+ *         file cannot be read, is not well-formed, or contains a coordinate that is not an integer.
+ */
+int parseXMLItems(const char* filename, SFCXMLItemCallback callback, void* context);
+
+/**
+ * Streams the 'item' elements of an XML document in memory to a callback.
+ *
+ * @param buffer The XML text. It does not need to be NUL-terminated.
+ * @param length The length of `buffer` in bytes.
+ * @param callback The function receiving each item, in document order.
+ * @param context An arbitrary pointer passed through to `callback`.
+ *
+ * This function behaves like `parseXMLItems`, but reads the document from `buffer` without copying it.
+ *
+ * @return 0 on success, the nonzero value returned by `callback` if it stopped parsing, or `XML_ERR_PRASE` if the
+ *         buffer is not well-formed, contains a coordinate that is not an integer, or is larger than `INT_MAX` bytes.
+ */
+int parseXMLItemsFromBuffer(const char* buffer, size_t length, SFCXMLItemCallback callback, void* context);
+
+/**
+ * Parses the 'item' elements of an XML file into a caller-provided array.
+ *
+ * @param filename The path to the XML file to be parsed.
+ * @param items The array receiving the items, in document order.
+ * @param capacity The number of elements in `items`.
+ *
+ * Every filled item owns a single allocation holding its strings; release them with `freeXMLItemArray`.
+ * Items beyond `capacity` are counted but not stored, so a first call with a capacity of 0 sizes the array.
+ *
+ * @return The number of items in the document, `XML_ERR_PRASE` if the file cannot be parsed, or -1 if memory
+ *         allocation fails. On error no item in `items` needs to be freed.
+ */
+long parseXMLItemArray(const char* filename, SFCXMLItem* items, size_t capacity);
+
+/**
+ * Parses the 'item' elements of an XML document in memory into a caller-provided array.
+ *
+ * @param buffer The XML text. It does not need to be NUL-terminated.
+ * @param length The length of `buffer` in bytes.
+ * @param items The array receiving the items, in document order.
+ * @param capacity The number of elements in `items`.
+ *
+ * This function behaves like `parseXMLItemArray`, but reads the document from `buffer`.
+ *
+ * @return The number of items in the document, `XML_ERR_PRASE` if the buffer cannot be parsed, or -1 if memory
+ *         allocation fails. On error no item in `items` needs to be freed.
+ */
+long parseXMLItemArrayFromBuffer(const char* buffer, size_t length, SFCXMLItem* items, size_t capacity);
+
+/**
+ * Releases the strings of items filled by `parseXMLItemArray`.
+ *
+ * @param items The array passed to `parseXMLItemArray`.
+ * @param count The number of filled items, the smaller of the capacity and the returned count.
+ *
+ * @return void
+ */
+void freeXMLItemArray(SFCXMLItem* items, size_t count);
 
 /**
  * Initializes and starts a new XML document for writing.
@@ -91,15 +161,7 @@ void parseXML(const char* filename) {
  *
  * @return A pointer to the XML writer if successful, or NULL if an error occurred.
  */
-xmlTextWriterPtr startXMLDocument(const char *filename) {
-    xmlTextWriterPtr writer = xmlNewTextWriterFilename(filename, 0);
-    if (writer == NULL) {
-        fprintf(stderr, "Error creating the xml writer\n");
-        return NULL;
-    }
-    xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL);
-    return writer;
-}
+xmlTextWriterPtr startXMLDocument(const char *filename);
 
 /**
  * Writes an XML element with the given name and content to the specified writer.
@@ -113,13 +175,7 @@ xmlTextWriterPtr startXMLDocument(const char *filename) {
  *
  * @return void
  */
-void writeElement(xmlTextWriterPtr writer, const char *elementName, const char *textContent) {
-    xmlTextWriterStartElement(writer, (const xmlChar *)elementName);
-    if (textContent != NULL) {
-        xmlTextWriterWriteString(writer, (const xmlChar *)textContent);
-    }
-    xmlTextWriterEndElement(writer);
-}
+void writeElement(xmlTextWriterPtr writer, const char *elementName, const char *textContent);
 
 
 /**
@@ -136,37 +192,69 @@ void writeElement(xmlTextWriterPtr writer, const char *elementName, const char *
  *
  * This function starts a new 'item' element with the given attributes, writes child elements for position, size, and text,
  * and then ends the 'item' element. The position and size elements contain child elements for x, y, width, and height, respectively.
+ * To write many items, pass them to `writeItems` in one call.
  *
  * @return void
  */
-void writeItem(xmlTextWriterPtr writer, const char *id, const char *type, int x, int y, int width, int height, const char *textFile) {
-    char buffer[20];
-    
-    xmlTextWriterStartElement(writer, (const xmlChar *)"item");
-    
-    writeElement(writer, "id", id);
-    writeElement(writer, "type", type);
-    
-    xmlTextWriterStartElement(writer, (const xmlChar *)"position");
-    sprintf(buffer, "%d", x);
-    writeElement(writer, "x", buffer);
-    
-    sprintf(buffer, "%d", y);
-    writeElement(writer, "y", buffer);
-    xmlTextWriterEndElement(writer);
-    
-    xmlTextWriterStartElement(writer, (const xmlChar *)"size");
-    sprintf(buffer, "%d", width);
-    writeElement(writer, "width", buffer);
-    
-    sprintf(buffer, "%d", height);
-    writeElement(writer, "height", buffer);
-    xmlTextWriterEndElement(writer);
-    
-    writeElement(writer, "text", textFile);
-    
-    xmlTextWriterEndElement(writer);
-}
+void writeItem(xmlTextWriterPtr writer, const char *id, const char *type, int x, int y, int width, int height, const char *textFile);
+
+/**
+ * Writes a batch of XML 'item' elements to the specified writer.
+ *
+ * @param writer The XML writer to which the 'item' elements will be written.
+ * @param items The items to write, in order.
+ * @param count The number of items.
+ *
+ * The markup is identical to calling `writeItem` for every item, but it is formatted directly into 64 KiB chunks
+ * that are passed to the writer with `xmlTextWriterWriteRawLen`, instead of about a dozen writer calls per item.
+ * Text is escaped as `xmlTextWriterWriteString` escapes it; a NULL string writes an empty element.
+ *
+ * @return 0 on success, or -1 if the writer reported an error.
+ */
+int writeItems(xmlTextWriterPtr writer, const SFCXMLItem* items, size_t count);
+
+/**
+ * Formats a complete XML document of 'item' elements into a caller-provided buffer.
+ *
+ * @param rootElement The name of the root element enclosing the items.
+ * @param items The items to write, in order.
+ * @param count The number of items.
+ * @param buffer The output buffer. No terminator is written.
+ * @param capacity The size of `buffer` in bytes.
+ *
+ * The document is byte-for-byte what `startXMLDocument`, a root element, `writeItem` for every item and
+ * `endXMLDocument` produce, without going through libxml2. Call once with a capacity of 0 to size the buffer.
+ *
+ * @return The full length of the document. If it exceeds `capacity`, only the first `capacity` bytes were written.
+ */
+size_t writeItemsToBuffer(const char* rootElement, const SFCXMLItem* items, size_t count, char* buffer, size_t capacity);
+
+/**
+ * Writes a complete XML document of 'item' elements to a file descriptor.
+ *
+ * @param rootElement The name of the root element enclosing the items.
+ * @param items The items to write, in order.
+ * @param count The number of items.
+ * @param fd An open, writable file descriptor. It is not closed.
+ *
+ * The document is the same as written by `writeItemsToBuffer`. It is formatted in one pass and written in 64 KiB
+ * chunks, so memory use does not depend on the number of items.
+ *
+ * @return 0 on success, or -1 with `errno` set if a write fails.
+ */
+int writeItemsToFd(const char* rootElement, const SFCXMLItem* items, size_t count, int fd);
+
+/**
+ * Writes a complete XML document of 'item' elements to a file, replacing its contents.
+ *
+ * @param filename The path of the file to write. It is created with mode 0644 if it does not exist.
+ * @param rootElement The name of the root element enclosing the items.
+ * @param items The items to write, in order.
+ * @param count The number of items.
+ *
+ * @return 0 on success, or -1 with `errno` set if the file cannot be opened or written.
+ */
+int writeItemsToFile(const char* filename, const char* rootElement, const SFCXMLItem* items, size_t count);
 
 /**
  * Closes the XML document and frees the associated resources.
@@ -178,10 +266,7 @@ void writeItem(xmlTextWriterPtr writer, const char *id, const char *type, int x,
  *
  * @return void
  */
-void endXMLDocument(xmlTextWriterPtr writer) {
-    xmlTextWriterEndDocument(writer);
-    xmlFreeTextWriter(writer);
-}
+void endXMLDocument(xmlTextWriterPtr writer);
 
 #ifdef __cplusplus
 }
@@ -26,7 +26,9 @@
 #ifndef SFCxxBase64_h
 #define SFCxxBase64_h
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
 
 /// \namespace sfcxx
@@ -36,31 +38,297 @@
 /// providing utility functions, document handling and other internal functions.
 namespace sfcxx {
 
+/// The Base64 alphabets and padding rules of RFC 4648.
+enum class Base64Variant {
+    STANDARD,                   ///< '+' and '/', padded with '=' (section 4).
+    STANDARD_NO_PADDING,        ///< '+' and '/', without padding.
+    URL_SAFE,                   ///< '-' and '_', padded with '=' (section 5).
+    URL_SAFE_NO_PADDING,        ///< '-' and '_', without padding, as used in URLs and tokens.
+};
+
 /// Encodes binary data to a Base64 string.
 ///
 /// This function takes a pointer to a binary data array and its length, and returns the Base64 encoded string.
+/// Whole blocks are encoded with the vector kernel reported by `base64_active_kernel`.
 ///
 /// \param bytes_to_encode Pointer to the binary data to encode.
 /// \param len Length of the binary data.
+/// \param variant The alphabet and padding to use.
 /// \return Base64 encoded string.
-std::string base64_encode(const unsigned char* bytes_to_encode, unsigned int len);
+std::string base64_encode(const unsigned char* bytes_to_encode, size_t len,
+                          Base64Variant variant = Base64Variant::STANDARD);
 
 /// Decodes a Base64 string to binary data.
 ///
 /// This function takes a Base64 encoded string and returns the decoded binary data as a vector of unsigned chars.
+/// Decoding stops at the first padding character or byte outside the alphabet, so padded and
+/// unpadded input decode alike.
 ///
 /// \param encoded_string The Base64 encoded string to decode.
+/// \param variant The alphabet to decode; padding is not required either way.
 /// \return Vector of decoded binary data.
-std::vector<unsigned char> base64_decode(const std::string& encoded_string);
+std::vector<unsigned char> base64_decode(std::string_view encoded_string,
+                                         Base64Variant variant = Base64Variant::STANDARD);
+
+/// Returns the exact length of the Base64 text for `length` input bytes.
+///
+/// \param length Number of input bytes.
+/// \param variant The variant the text is encoded with.
+/// \return The number of characters `base64_encode_into` writes.
+size_t base64_encoded_size(size_t length, Base64Variant variant = Base64Variant::STANDARD);
+
+/// Returns the length of the data encoded in `text`.
+///
+/// Only the trailing padding is inspected, so this is constant time. The
+/// result is exact for well-formed input and an upper bound otherwise.
+///
+/// \param text The Base64 text.
+/// \param length Number of characters at `text`.
+/// \return The number of bytes `base64_decode_into` writes at most.
+size_t base64_decoded_size(const char* text, size_t length);
+
+/// Encodes binary data into a caller-provided buffer.
+///
+/// No terminator is written. Pass a buffer of `base64_encoded_size(length, variant)`
+/// characters to encode without any allocation.
+///
+/// \param data The binary data to encode.
+/// \param length Number of bytes at `data`.
+/// \param out The output buffer.
+/// \param variant The alphabet and padding to use.
+/// \return The number of characters written.
+size_t base64_encode_into(const unsigned char* data, size_t length, char* out,
+                          Base64Variant variant = Base64Variant::STANDARD);
+
+/// Decodes Base64 text into a caller-provided buffer.
+///
+/// Decoding stops like `base64_decode`. A buffer of `base64_decoded_size(text, length)`
+/// bytes is enough; a few bytes more let the vector kernel handle the last blocks too.
+///
+/// \param text The Base64 text.
+/// \param length Number of characters at `text`.
+/// \param out The output buffer.
+/// \param capacity Size of `out` in bytes.
+/// \param variant The alphabet to decode.
+/// \return The number of bytes written.
+/// \throws std::length_error If `capacity` is less than `base64_decoded_size(text, length)`.
+size_t base64_decode_into(const char* text, size_t length, unsigned char* out, size_t capacity,
+                          Base64Variant variant = Base64Variant::STANDARD);
+
+/// Number of input bytes the descriptor and file functions encode per step.
+///
+/// A multiple of 3, so every chunk but the last encodes to whole groups.
+constexpr size_t kBase64ChunkSize = 48 * 1024;
+
+/// Encodes Base64 incrementally.
+///
+/// Pass the input to `update` in pieces of any size, then call `finish` once.
+/// Up to two bytes that do not fill a 3-byte group are held back between
+/// calls, so the output is the same as `base64_encode` of the whole input
+/// while only one piece has to be in memory at a time.
+class Base64Encoder {
+public:
+    explicit Base64Encoder(Base64Variant variant = Base64Variant::STANDARD);
+
+    /// Returns the most characters `update` writes for `length` input bytes.
+    static constexpr size_t maxOutput(size_t length) { return (length + 2) / 3 * 4; }
+
+    /// Encodes the next piece of input.
+    ///
+    /// \param data The input bytes.
+    /// \param length Number of bytes at `data`.
+    /// \param out Receives the characters; it must have room for `maxOutput(length)`.
+    /// \return The number of characters written.
+    size_t update(const unsigned char* data, size_t length, char* out);
+
+    /// Writes the last group, padded if the variant is, and resets the encoder.
+    ///
+    /// \param out Receives the characters; it must have room for 4.
+    /// \return The number of characters written.
+    size_t finish(char* out);
+
+private:
+    unsigned char pending[3];
+    size_t pendingLength = 0;
+    bool urlSafe;
+    bool padded;
+};
+
+/// Decodes Base64 incrementally.
+///
+/// The counterpart of `Base64Encoder`. Like `base64_decode`, decoding stops
+/// at the first padding character or byte outside the alphabet; any input
+/// after that is ignored.
+class Base64Decoder {
+public:
+    explicit Base64Decoder(Base64Variant variant = Base64Variant::STANDARD);
+
+    /// Returns the most bytes `update` writes for `length` input characters.
+    static constexpr size_t maxOutput(size_t length) { return (length + 3) / 4 * 3; }
+
+    /// Decodes the next piece of input.
+    ///
+    /// \param data The input characters.
+    /// \param length Number of characters at `data`.
+    /// \param out Receives the bytes; it must have room for `maxOutput(length)`.
+    /// \return The number of bytes written.
+    size_t update(const char* data, size_t length, unsigned char* out);
+
+    /// Decodes the next piece of input into a buffer of known size.
+    ///
+    /// The decoder writes no more bytes than the input encodes; `capacity` only
+    /// limits the vector stores, which may write past the decoded bytes.
+    ///
+    /// \param data The input characters.
+    /// \param length Number of characters at `data`.
+    /// \param out Receives the bytes.
+    /// \param capacity Size of `out` in bytes.
+    /// \return The number of bytes written.
+    size_t update(const char* data, size_t length, unsigned char* out, size_t capacity);
+
+    /// Writes the bytes of a trailing partial group and resets the decoder.
+    ///
+    /// \param out Receives the bytes; it must have room for 2.
+    /// \return The number of bytes written.
+    size_t finish(unsigned char* out);
+
+    /// Returns true once padding or a byte outside the alphabet has been seen.
+    bool stopped() const { return done; }
+
+private:
+    unsigned char pending[4];
+    size_t pendingLength = 0;
+    bool done = false;
+    bool urlSafe;
+};
+
+/// Encodes everything read from `input` and writes the Base64 text to `output`.
+///
+/// Memory use is bounded by `kBase64ChunkSize`, whatever the size of the input.
+/// Neither descriptor is closed.
+///
+/// \param input An open, readable file descriptor.
+/// \param output An open, writable file descriptor.
+/// \param variant The alphabet and padding to use.
+/// \throws std::system_error If a read or write fails.
+void base64_encode_fd(int input, int output, Base64Variant variant = Base64Variant::STANDARD);
+
+/// Decodes the Base64 text read from `input` and writes the bytes to `output`.
+///
+/// Reading stops once the decoder has stopped. Neither descriptor is closed.
+///
+/// \param input An open, readable file descriptor.
+/// \param output An open, writable file descriptor.
+/// \param variant The alphabet to decode.
+/// \throws std::system_error If a read or write fails.
+void base64_decode_fd(int input, int output, Base64Variant variant = Base64Variant::STANDARD);
+
+/// Encodes a file, such as an image, chunk by chunk and writes the Base64 text to `output`.
+///
+/// \param filename The name of the file to encode.
+/// \param output An open, writable file descriptor. It is not closed.
+/// \param variant The alphabet and padding to use.
+/// \throws std::runtime_error If the file cannot be opened.
+/// \throws std::system_error If a read or write fails.
+void base64_encode_file(const std::string& filename, int output,
+                        Base64Variant variant = Base64Variant::STANDARD);
+
+/// Decodes the Base64 text read from `input` chunk by chunk into a file, replacing it.
+///
+/// \param input An open, readable file descriptor. It is not closed.
+/// \param filename The name of the file to write.
+/// \param variant The alphabet to decode.
+/// \throws std::runtime_error If the file cannot be created.
+/// \throws std::system_error If a read or write fails.
+void base64_decode_file(int input, const std::string& filename,
+                        Base64Variant variant = Base64Variant::STANDARD);
+
+/// Returns the name of the Base64 kernel selected for this CPU.
+///
+/// One of `"avx2"`, `"ssse3"`, `"neon"` or `"scalar"`. The fastest kernel is chosen on
+/// first use, unless `base64_select_kernel` has selected another.
+///
+/// \return A static string naming the kernel.
+const char* base64_active_kernel();
+
+/// Selects the Base64 kernel by name, so tests and benchmarks can compare kernels.
+///
+/// Call it while no other thread is encoding or decoding.
+///
+/// \param name One of the names `base64_active_kernel` returns.
+/// \return `false`, leaving the selection unchanged, if this CPU cannot run that kernel.
+bool base64_select_kernel(const char* name);
+
+/// Number of bytes `write_image_file` passes to each `pwrite`.
+constexpr size_t kImageWriteChunkSize = 8 * 1024 * 1024;
+
+/// A read-only view of a file mapped into memory.
+///
+/// Pages are read on first access, so mapping a large image costs nothing
+/// until its bytes are used, and encoding it does not copy it first. The
+/// mapping is private: later changes to the file may or may not be visible.
+class MappedFile {
+public:
+    /// Maps the whole of `filename`.
+    ///
+    /// \throws std::runtime_error If the file cannot be opened.
+    /// \throws std::system_error If the file cannot be mapped.
+    explicit MappedFile(const std::string& filename);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const unsigned char* begin() const { return bytes; }
+    const unsigned char* end() const { return bytes + length; }
+
+private:
+    void unmap();
+
+    const unsigned char* bytes = nullptr;   ///< Null for an empty file.
+    size_t length = 0;
+};
+
+/// Maps an image file into memory for reading.
+///
+/// Use this instead of `read_image_file` when the content is only read, for
+/// example to pass it to `base64_encode_into`.
+///
+/// \param filename The name of the file to map.
+/// \return The mapping; the file is not kept open.
+/// \throws std::runtime_error If the file cannot be opened.
+/// \throws std::system_error If the file cannot be mapped.
+MappedFile map_image_file(const std::string& filename);
 
 /// Reads the entire binary content of an image file into a vector.
 ///
 /// This function takes the filename of an image file and returns its binary content as a vector of unsigned chars.
+/// The vector is sized from the file's length and filled with `read`.
 ///
 /// \param filename The name of the file to read.
 /// \return Vector of binary data read from the file.
+/// \throws std::runtime_error If the file cannot be opened.
+/// \throws std::system_error If a read fails.
 std::vector<unsigned char> read_image_file(const std::string& filename);
 
+/// Writes binary data to an image file.
+///
+/// The file is replaced. Its blocks are preallocated where the platform
+/// supports it, then the data is written with `pwrite` in chunks of
+/// `kImageWriteChunkSize` bytes.
+///
+/// \param filename The name of the file to write.
+/// \param data The binary data to write.
+/// \param length Number of bytes at `data`.
+/// \throws std::runtime_error If the file cannot be created.
+/// \throws std::system_error If a write fails.
+void write_image_file(const std::string& filename, const unsigned char* data, size_t length);
+
 /// Writes binary data to an image file.
 ///
 /// This function takes a filename and binary data, and writes the data to the file.
@@ -0,0 +1,243 @@
+//===-- include/SFCxxCBOR.h - Binary JSON Encoding --------------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a CBOR (RFC 8949) encoding of `JSONVariant` documents.
+///
+/// CBOR stores the same data model as JSON in a compact binary form that is
+/// read without tokenizing text or converting numbers. Every `JSONVariant`
+/// round-trips exactly: integral numbers are stored as CBOR integers, other
+/// numbers as the narrowest float that holds them, and objects keep their
+/// member order.
+///
+/// Documents written by this module start with the self-describe tag
+/// (`0xd9 0xd9 0xf7`), which never starts a JSON text, so readers can accept
+/// either format through `CBOR::decodeAny`.
+///
+/// Example usage:
+/// \code
+///   std::string binary = sfcxx::CBOR::encode(config);
+///   sfcxx::JSONVariant decoded = sfcxx::CBOR::decodeAny(binary.data(), binary.size());
+///
+///   sfcxx::CBORWriter writer(fd);
+///   writer.beginObject();
+///   writer.writeKey("is_Favorite");
+///   writer.writeBool(true);
+///   writer.end();
+///   writer.flush();
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxCBOR_h
+#define SFCxxCBOR_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SFCxxJSON.h"
+#include "SFCxxJSONReader.h"
+
+namespace sfcxx {
+
+/// \brief Converts between `JSONVariant` and CBOR.
+class CBOR {
+public:
+    /// \brief Encodes a JSONVariant as a tagged CBOR document.
+    ///
+    /// \param value The JSONVariant to encode.
+    /// \return The encoded bytes.
+    static std::string encode(const JSONVariant& value);
+
+    /// \brief Encodes a JSONVariant as a tagged CBOR document directly to a file descriptor.
+    ///
+    /// \param value The JSONVariant to encode.
+    /// \param fd An open, writable file descriptor. It is not closed.
+    /// \throws std::system_error If a write fails.
+    static void encode(const JSONVariant& value, int fd);
+
+    /// \brief Decodes a CBOR document.
+    ///
+    /// \param data Pointer to the encoded bytes.
+    /// \param length Number of encoded bytes.
+    /// \return The decoded JSONVariant.
+    /// \throws std::runtime_error If the input is not well-formed CBOR, or uses items
+    ///         without a JSON equivalent such as byte strings or non-string keys.
+    static JSONVariant decode(const char* data, size_t length);
+
+    /// \brief Decodes a document that is either CBOR or JSON text.
+    ///
+    /// \throws std::runtime_error If the input is malformed in the detected format.
+    static JSONVariant decodeAny(const char* data, size_t length);
+
+    /// \brief Returns whether a buffer holds CBOR rather than JSON text.
+    ///
+    /// A buffer is CBOR if it starts with the self-describe tag or with a byte
+    /// that cannot start a JSON text (an untagged CBOR array or map).
+    static bool isCBOR(const char* data, size_t length);
+};
+
+/// \brief Writes a CBOR document item by item, without building a `JSONVariant`.
+///
+/// Containers opened without a count use CBOR's indefinite-length form, so
+/// documents can be produced in one pass. The writer does not check that the
+/// calls form a valid document; keys and values must alternate inside objects.
+class CBORWriter {
+public:
+    /// \brief Marks a container whose number of items is not known up front.
+    static constexpr size_t kIndefinite = SIZE_MAX;
+
+    /// \brief Number of bytes buffered by a file descriptor writer before each `write`.
+    static constexpr size_t kWriteChunkSize = 64 * 1024;
+
+    /// \brief Creates a writer that collects the document in memory; see `release`.
+    CBORWriter();
+
+    /// \brief Creates a writer that streams the document to a file descriptor.
+    ///
+    /// \param fd An open, writable file descriptor. It is not closed.
+    explicit CBORWriter(int fd);
+
+    /// \brief Flushes a file descriptor writer, ignoring write errors. Call `flush` to see them.
+    ~CBORWriter();
+
+    CBORWriter(const CBORWriter&) = delete;
+    CBORWriter& operator=(const CBORWriter&) = delete;
+
+    /// \brief Opens an object.
+    ///
+    /// \param count The number of members, or `kIndefinite`.
+    void beginObject(size_t count = kIndefinite);
+
+    /// \brief Opens an array.
+    ///
+    /// \param count The number of elements, or `kIndefinite`.
+    void beginArray(size_t count = kIndefinite);
+
+    /// \brief Closes the innermost open object or array.
+    ///
+    /// \throws std::logic_error If no container is open.
+    void end();
+
+    /// \brief Writes the self-describe tag that lets `CBOR::isCBOR` recognize any document.
+    ///
+    /// Call it before the root value. Documents whose root is an array or an
+    /// object are recognized without it.
+    void writeSelfDescribeTag();
+
+    void writeKey(std::string_view key) { writeString(key); }
+    void writeNull();
+    void writeBool(bool value);
+    void writeNumber(double value);
+    void writeString(std::string_view value);
+
+    /// \brief Writes a complete JSONVariant as the next item.
+    void writeValue(const JSONVariant& value);
+
+    /// \brief Writes buffered bytes to the file descriptor. Does nothing for memory writers.
+    ///
+    /// \throws std::system_error If a write fails.
+    void flush();
+
+    /// \brief Returns the document collected by a memory writer and leaves the writer empty.
+    std::string release();
+
+private:
+    void writeHead(unsigned major, uint64_t argument);
+    void reserveChunk();
+
+    std::string out;
+    int fd = -1;
+    std::vector<bool> open;             ///< Whether each open container is indefinite.
+};
+
+/// \brief Reads a CBOR document token by token.
+///
+/// The reader reports the same tokens as `JSONReader`, so code that consumes a
+/// token stream works with either format. Strings are returned as views into
+/// the buffer unless they were split into chunks. The buffer is not copied and
+/// must outlive the reader.
+class CBORReader {
+public:
+    /// \brief Creates a reader over a complete, caller-owned buffer.
+    CBORReader(const char* data, size_t length);
+
+    /// \brief Advances to the next token; see `JSONReader::next`.
+    ///
+    /// \throws std::runtime_error If the input is not well-formed CBOR.
+    JSONToken next();
+
+    /// \brief Skips the value that starts at the current token; see `JSONReader::skipValue`.
+    JSONToken skipValue();
+
+    JSONToken token() const { return current; }
+    size_t depth() const { return frames.size(); }
+    std::string_view stringValue() const { return text; }
+    double numberValue() const { return number; }
+    bool boolValue() const { return boolean; }
+
+    /// \brief Returns the number of items declared by the container that was just opened.
+    ///
+    /// Members for maps, elements for arrays. Returns 0 for indefinite-length
+    /// containers and for any other token. The count is capped by the bytes
+    /// left in the buffer, so it can be passed to `reserve` as is.
+    size_t sizeHint() const;
+
+private:
+    /// \brief An open array or map.
+    struct Frame {
+        bool isMap;
+        bool expectKey;                 ///< Maps only: whether the next item is a key.
+        uint64_t remaining;             ///< Items left (keys and values count separately), or `UINT64_MAX`.
+    };
+
+    uint8_t readByte();
+    uint64_t readArgument(unsigned info);
+    void readText(unsigned info);
+    void afterValue();
+    [[noreturn]] void fail(const char* what) const;
+
+    const uint8_t* data;
+    size_t length;
+    size_t pos = 0;
+    std::vector<Frame> frames;
+    bool rootDone = false;
+
+    JSONToken current = JSONToken::NEED_MORE_INPUT;
+    std::string_view text;
+    std::string scratch;                ///< Concatenated chunks of indefinite-length strings.
+    double number = 0;
+    bool boolean = false;
+};
+
+}
+
+#endif /* SFCxxCBOR_h */
@@ -0,0 +1,164 @@
+//===-- include/SFCxxCanvasIndex.h - Canvas Spatial Index -------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a packed R-tree over canvas items for viewport queries.
+///
+/// `CanvasIndex` is built once from the items of a canvas layout, as parsed
+/// by `parseXMLItemArray`, and answers which items intersect a rectangle in
+/// O(log n + k) instead of scanning every item. The tree is bulk-loaded: the
+/// items are sorted along a Hilbert curve and packed into full nodes of
+/// `kNodeCapacity` entries, level by level, so it has no slack and is stored
+/// in a handful of flat arrays. Those arrays are also the serialized form,
+/// which can be saved next to the canvas content and loaded without
+/// rebuilding.
+///
+/// Example usage:
+/// \code
+///   std::vector<SFCXMLItem> items(count);
+///   parseXMLItemArray("canvas.xml", items.data(), items.size());
+///   auto index = sfcxx::CanvasIndex::build(items.data(), items.size());
+///   index.save("canvas.index");
+///
+///   for (uint32_t item : index.query({0, 0, 1920, 1080})) {
+///       // items[item] is at least partly visible
+///   }
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxCanvasIndex_h
+#define SFCxxCanvasIndex_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SFCXML.h"
+
+namespace sfcxx {
+
+/// \brief An axis-aligned rectangle in canvas coordinates, as stored in an item's `position` and `size`.
+///
+/// A negative width or height extends the rectangle to the left or upwards.
+struct CanvasRect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+/// \brief A static, bulk-loaded R-tree over the bounding rectangles of canvas items.
+///
+/// Items are identified by their position in the array the index was built
+/// from. Rectangles are closed, so an item that only touches the viewport's
+/// edge is reported. Bounds are kept as 32-bit integers; an item extending
+/// beyond the `int` range is clamped to it.
+///
+/// An index is immutable once built and safe to query from several threads.
+class CanvasIndex {
+public:
+    /// \brief Number of entries per node.
+    static constexpr size_t kNodeCapacity = 16;
+
+    /// \brief Creates an empty index.
+    CanvasIndex() = default;
+
+    /// \brief Builds an index over the position and size of each item.
+    ///
+    /// \param items The items, in the order their indices are reported.
+    /// \param count Number of items; at most `UINT32_MAX`.
+    /// \throws std::length_error If there are too many items.
+    static CanvasIndex build(const SFCXMLItem* items, size_t count);
+
+    /// \brief Builds an index over rectangles.
+    ///
+    /// \param rects The rectangles, in the order their indices are reported.
+    /// \param count Number of rectangles; at most `UINT32_MAX`.
+    /// \throws std::length_error If there are too many rectangles.
+    static CanvasIndex build(const CanvasRect* rects, size_t count);
+
+    /// \brief Returns the number of indexed items.
+    size_t size() const { return itemCount; }
+    bool empty() const { return itemCount == 0; }
+
+    /// \brief Appends the indices of all items intersecting `viewport` to `out`.
+    ///
+    /// Indices are appended in tree order, not in item order. Reuse `out`
+    /// between queries to avoid allocating while panning.
+    ///
+    /// \param viewport The rectangle to search.
+    /// \param out Receives the item indices.
+    void query(const CanvasRect& viewport, std::vector<uint32_t>& out) const;
+
+    /// \brief Returns the indices of all items intersecting `viewport`.
+    std::vector<uint32_t> query(const CanvasRect& viewport) const;
+
+    /// \brief Serializes the index into a portable, little-endian byte array.
+    std::vector<unsigned char> serialize() const;
+
+    /// \brief Restores an index written by `serialize`.
+    ///
+    /// The data is validated, so a truncated or corrupted index is rejected
+    /// instead of producing wrong query results or reading out of bounds.
+    ///
+    /// \param data The serialized index.
+    /// \param length Number of bytes at `data`.
+    /// \return The index.
+    /// \throws std::runtime_error If the data is not a valid serialized index.
+    static CanvasIndex deserialize(const unsigned char* data, size_t length);
+
+    /// \brief Writes the serialized index to a file, replacing it.
+    ///
+    /// \throws std::runtime_error If the file cannot be created.
+    /// \throws std::system_error If a write fails.
+    void save(const std::string& filename) const;
+
+    /// \brief Reads an index written by `save`.
+    ///
+    /// \throws std::runtime_error If the file cannot be opened or is not a valid serialized index.
+    /// \throws std::system_error If the file cannot be mapped.
+    static CanvasIndex load(const std::string& filename);
+
+private:
+    /// \brief The bounds of one node or item, with inclusive maxima.
+    struct Box {
+        int32_t minX;
+        int32_t minY;
+        int32_t maxX;
+        int32_t maxY;
+    };
+
+    size_t itemCount = 0;
+    std::vector<Box> boxes;             ///< Items first, then each level of nodes; the root is last.
+    std::vector<uint32_t> indices;      ///< For items, the item index; for nodes, the position of the first child.
+    std::vector<size_t> levelBounds;    ///< End position in `boxes` of each level, from the items up.
+
+    static CanvasIndex pack(std::vector<Box> itemBoxes);
+    static Box boundsOf(const CanvasRect& rect);
+};
+
+}
+
+#endif /* SFCxxCanvasIndex_h */
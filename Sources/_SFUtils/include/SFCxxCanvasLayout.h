@@ -0,0 +1,183 @@
+//===-- include/SFCxxCanvasLayout.h - Binary Canvas Layouts -----*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a binary canvas layout format that is read in place.
+///
+/// A canvas layout in XML stores every coordinate as element text, so
+/// opening a large canvas means parsing megabytes of markup. The binary
+/// layout stores the same items as structure-of-arrays instead: packed
+/// little-endian arrays of ids, types, x, y, width, height and text file
+/// references, where the three string columns are offsets into a table of
+/// NUL-terminated, deduplicated strings.
+///
+/// `CanvasLayout::open` maps the file and points straight into it. Opening
+/// only checks the header and that every string offset is in range, so the
+/// coordinate arrays are never copied or converted, and pages are read only
+/// when they are used.
+///
+/// File layout, with every section starting on an 8-byte boundary:
+/// \code
+///   Header      magic "SFCL", version, item count, string table size, section offsets
+///   ids         uint32[count]   string offsets, or kNullString
+///   types       uint32[count]
+///   x, y        int32[count]
+///   widths      int32[count]
+///   heights     int32[count]
+///   texts       uint32[count]
+///   strings     char[]          NUL-terminated strings; the table ends with NUL
+/// \endcode
+///
+/// Converting XML to a layout and back yields the same items, and the same
+/// document as `writeItemsToFile` would write for them.
+///
+/// Example usage:
+/// \code
+///   sfcxx::CanvasLayout::convertFromXML("canvas.xml", "canvas.layout");
+///
+///   auto layout = sfcxx::CanvasLayout::open("canvas.layout");
+///   const int32_t* x = layout.x();
+///   for (size_t i = 0; i < layout.size(); ++i) {
+///       printf("%s at %d\n", layout.id(i), x[i]);
+///   }
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxCanvasLayout_h
+#define SFCxxCanvasLayout_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SFCXML.h"
+
+namespace sfcxx {
+
+class MappedFile;
+
+/// \brief A read-only canvas layout in the binary structure-of-arrays format.
+///
+/// A layout either maps a file, which it keeps alive, or views a buffer
+/// owned by the caller. Copies share the mapping. Strings returned by the
+/// accessors point into the layout and stay valid as long as any copy of it.
+class CanvasLayout {
+public:
+    /// \brief The string offset that stands for a NULL string.
+    static constexpr uint32_t kNullString = UINT32_MAX;
+
+    /// \brief Creates an empty layout.
+    CanvasLayout() = default;
+
+    /// \brief Encodes items into the binary format.
+    ///
+    /// \param items The items, in order. NULL strings are preserved.
+    /// \param count Number of items.
+    /// \return The encoded layout.
+    /// \throws std::length_error If there are more than `UINT32_MAX` items or
+    ///         the distinct strings do not fit in a 4 GiB string table.
+    static std::vector<unsigned char> encode(const SFCXMLItem* items, size_t count);
+
+    /// \brief Encodes items and writes them to a layout file, replacing it.
+    ///
+    /// \throws std::length_error See `encode`.
+    /// \throws std::runtime_error If the file cannot be created.
+    /// \throws std::system_error If a write fails.
+    static void write(const std::string& filename, const SFCXMLItem* items, size_t count);
+
+    /// \brief Reads a layout from a buffer in place.
+    ///
+    /// \param data The encoded layout, aligned to at least 4 bytes. It must
+    ///        outlive the returned layout and all of its copies.
+    /// \param length Number of bytes at `data`.
+    /// \throws std::runtime_error If the data is not a valid layout.
+    static CanvasLayout view(const unsigned char* data, size_t length);
+
+    /// \brief Maps a layout file and reads it in place.
+    ///
+    /// \throws std::runtime_error If the file cannot be opened or is not a valid layout.
+    /// \throws std::system_error If the file cannot be mapped.
+    static CanvasLayout open(const std::string& filename);
+
+    /// \brief Converts an XML canvas layout into a binary layout file.
+    ///
+    /// The XML is streamed with `parseXMLItems`, so the items are never all
+    /// held as `SFCXMLItem` records.
+    ///
+    /// \param xmlFilename The XML document to read.
+    /// \param layoutFilename The layout file to write.
+    /// \return The number of items converted.
+    /// \throws std::runtime_error If the XML cannot be parsed or the layout file cannot be created.
+    /// \throws std::length_error See `encode`.
+    /// \throws std::system_error If a write fails.
+    static size_t convertFromXML(const std::string& xmlFilename, const std::string& layoutFilename);
+
+    /// \brief Writes the layout as an XML document with `writeItemsToFile`.
+    ///
+    /// The root element name is not part of the binary layout, so it is passed in.
+    ///
+    /// \param filename The XML document to write.
+    /// \param rootElement The name of the root element enclosing the items.
+    /// \throws std::system_error If the file cannot be opened or written.
+    void writeXML(const std::string& filename, const char* rootElement = "canvas") const;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /// \brief Returns the id of item `i`, or NULL if it was written as NULL.
+    const char* id(size_t i) const { return string(ids[i]); }
+    const char* type(size_t i) const { return string(types[i]); }
+    const char* text(size_t i) const { return string(texts[i]); }
+
+    /// \brief Returns the column of x-coordinates, `size()` values long.
+    const int32_t* x() const { return xs; }
+    const int32_t* y() const { return ys; }
+    const int32_t* width() const { return widths; }
+    const int32_t* height() const { return heights; }
+
+    /// \brief Returns item `i` as a record whose strings point into the layout.
+    SFCXMLItem item(size_t i) const {
+        return SFCXMLItem{id(i), type(i), xs[i], ys[i], widths[i], heights[i], text(i)};
+    }
+
+private:
+    const char* string(uint32_t offset) const { return offset == kNullString ? nullptr : strings + offset; }
+
+    std::shared_ptr<const MappedFile> mapping;  ///< Set when the layout was opened from a file.
+    size_t count = 0;
+    const uint32_t* ids = nullptr;
+    const uint32_t* types = nullptr;
+    const int32_t* xs = nullptr;
+    const int32_t* ys = nullptr;
+    const int32_t* widths = nullptr;
+    const int32_t* heights = nullptr;
+    const uint32_t* texts = nullptr;
+    const char* strings = nullptr;
+};
+
+}
+
+#endif /* SFCxxCanvasLayout_h */
@@ -49,28 +49,34 @@
 #ifndef SFCxxJSON_h
 #define SFCxxJSON_h
 
+#include <cstring>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 #include <variant>
 #include <memory>
 
+#include "SFCxxJSONObject.h"
+#include "SFCxxJSONScanner.h"
+#include "SFCxxJSONView.h"
+
 namespace sfcxx {
 
 /// \brief Represents a variant of JSON values.
 ///
 /// This variant type can hold null, boolean, numeric, string, arrays of JSON values,
-/// and objects (unordered maps) of JSON values.
+/// and objects of JSON values. Objects keep their members in insertion order.
 using JSONVariant = std::variant<std::nullptr_t, bool, double, std::string,
                                  std::vector<std::shared_ptr<struct JSONValue> >,
-                                 std::unordered_map<std::string, std::shared_ptr<struct JSONValue>>>;
+                                 JSONObject>;
 
 /// \brief Represents a JSON value.
 ///
-/// This struct serves as the base type for JSON values.
+/// This struct serves as the base type for JSON values. The variant is moved
+/// into place, so wrapping a decoded container never copies its children.
 struct JSONValue {
     JSONVariant value;
-    JSONValue(JSONVariant val) : value(val) {}
+    JSONValue(JSONVariant val) : value(std::move(val)) {}
     ~JSONValue() = default;
 };
 
@@ -86,81 +92,233 @@ public:
     /// \return The encoded JSON string.
     static std::string encode(const JSONVariant& value);
 
+    /// \brief Returns the exact length of the JSON string `encode` would produce.
+    ///
+    /// \param value The JSONVariant to measure.
+    /// \return The encoded length in bytes.
+    static size_t encodedSize(const JSONVariant& value);
+
+    /// \brief Encodes a JSONVariant into a caller-provided buffer.
+    ///
+    /// No terminator is written. Pass a buffer of `encodedSize(value)` bytes to
+    /// encode without any intermediate allocation.
+    ///
+    /// \param value The JSONVariant to encode.
+    /// \param buffer The output buffer.
+    /// \param capacity Size of `buffer` in bytes.
+    /// \return The full encoded length. If it exceeds `capacity`, only the first
+    ///         `capacity` bytes have been written.
+    static size_t encode(const JSONVariant& value, char* buffer, size_t capacity);
+
+    /// \brief Encodes a JSONVariant directly to a file descriptor.
+    ///
+    /// The output is written in chunks of `kWriteChunkSize` bytes as it is
+    /// produced, so memory use does not depend on the size of the document.
+    ///
+    /// \param value The JSONVariant to encode.
+    /// \param fd An open, writable file descriptor. It is not closed.
+    /// \throws std::system_error If a write fails.
+    static void encode(const JSONVariant& value, int fd);
+
+    /// \brief Number of bytes buffered by the file descriptor encoder before each `write`.
+    static constexpr size_t kWriteChunkSize = 64 * 1024;
+
     /// \brief Decodes a JSON string into a JSONVariant.
     ///
+    /// The input is first indexed by `JSONScanner`; the recursive descent then
+    /// only visits structural characters.
+    ///
     /// \param json The JSON string to decode.
     /// \return The decoded JSONVariant.
-    static JSONVariant decode(const std::string& json);
+    /// \throws std::runtime_error If the input is not well-formed JSON.
+    static JSONVariant decode(std::string_view json);
+
+    /// \brief Decodes a JSON string into a tree that borrows its strings from `json`.
+    ///
+    /// Keys and string values are not copied or unescaped while decoding; see
+    /// `JSONLazyString`. Use this instead of `decode` when the result is only
+    /// read and the buffer is kept alive for as long as the tree.
+    ///
+    /// \param json The JSON text. It must outlive the returned tree.
+    /// \return The decoded root value.
+    /// \throws std::runtime_error If the input is not well-formed JSON.
+    static JSONViewValue decodeView(std::string_view json);
+
+    /// \brief Decodes the escape sequences of a JSON string body.
+    ///
+    /// `\\uXXXX` escapes are written as UTF-8, with surrogate pairs combined;
+    /// unpaired surrogates become U+FFFD.
+    ///
+    /// \param raw The text between the quotes, as it appears in the source.
+    /// \param out Receives the unescaped text; it is appended to.
+    /// \throws std::runtime_error If `raw` contains an invalid escape sequence.
+    static void unescape(std::string_view raw, std::string& out);
+
+    /// \brief Escapes text for use as a JSON string body, the inverse of `unescape`.
+    ///
+    /// Quotes, backslashes and control characters are escaped; all other bytes,
+    /// including UTF-8 sequences, are copied unchanged. Clean spans are found
+    /// with `JSONScanner::findEscape` and copied in bulk.
+    ///
+    /// \param text The text to escape.
+    /// \param out Receives the escaped text, without quotes; it is appended to.
+    static void escape(std::string_view text, std::string& out);
+
+    /// \brief Escapes text for use as a JSON string body into any output sink.
+    ///
+    /// This is the single escaping routine behind `escape`, the encoders and the
+    /// C `JSONBuilder`.
+    ///
+    /// \tparam Sink A type with `write(const char*, size_t)` and `put(char)`.
+    /// \param text The text to escape.
+    /// \param out Receives the escaped text, without quotes.
+    template <typename Sink>
+    static void escapeTo(std::string_view text, Sink& out);
 
 private:
-    /// \brief Recursively encodes a JSONVariant into a JSON string.
+    /// \brief Walks the structural index of the document being decoded.
+    ///
+    /// Every decode step consumes the next structural offset instead of
+    /// skipping whitespace character by character.
+    struct Cursor {
+        const char* data;                   ///< The JSON text.
+        size_t length;                      ///< Length of the JSON text in bytes.
+        const uint32_t* structurals;        ///< Structural offsets produced by `JSONScanner`.
+        size_t count;                       ///< Number of structural offsets.
+        size_t next;                        ///< Index of the next unconsumed structural.
+
+        /// \brief Returns the next structural character, or `'\0'` at the end of the index.
+        char peek() const { return next < count ? data[structurals[next]] : '\0'; }
+
+        /// \brief Consumes the next structural and returns its offset, or `length` at the end of the index.
+        size_t advance() { return next < count ? structurals[next++] : length; }
+
+        /// \brief Returns the offset of the next structural, or `length` at the end of the index.
+        size_t nextOffset() const { return next < count ? structurals[next] : length; }
+    };
+
+    /// \brief Recursively encodes a JSONVariant into a sink.
     ///
-    /// This method is used internally by the encode method.
+    /// This method is used internally by the encode methods. A sink provides
+    /// `write(const char*, size_t)` and `put(char)`; the sinks for strings,
+    /// buffers, descriptors and size measurement are defined next to it.
     ///
     /// \param value The JSONVariant to encode.
-    /// \param out The output string to store the encoded JSON.
-    static void encodeValue(const JSONVariant& value, std::string& out);
+    /// \param out The sink receiving the encoded JSON.
+    template <typename Sink>
+    static void encodeValue(const JSONVariant& value, Sink& out);
     
-    /// \brief Recursively decodes a JSON string into a JSONVariant.
+    /// \brief Recursively decodes the value starting at the next structural.
     ///
     /// This method is used internally by the decode method.
     ///
-    /// \param json The JSON string to decode.
-    /// \param pos The current position in the JSON string.
+    /// \param cursor The cursor over the structural index.
     /// \return The decoded JSONVariant.
-    static JSONVariant decodeValue(const std::string& json, size_t& pos);
+    static JSONVariant decodeValue(Cursor& cursor);
     
     
     /// \brief Decodes a JSON object from a JSON string.
     ///
-    /// \param json The JSON string to decode.
-    /// \param pos The current position in the JSON string.
+    /// \param cursor The cursor positioned at the opening brace.
     /// \return The decoded JSONVariant representing the object.
-    static JSONVariant decodeObject(const std::string& json, size_t& pos);
+    static JSONVariant decodeObject(Cursor& cursor);
     
     /// \brief Decodes a JSON array from a JSON string.
     ///
-    /// \param json The JSON string to decode.
-    /// \param pos The current position in the JSON string.
+    /// \param cursor The cursor positioned at the opening bracket.
     /// \return The decoded JSONVariant representing the array.
-    static JSONVariant decodeArray(const std::string& json, size_t& pos);
-
-    
-    /// \brief Skips whitespace characters in a JSON string.
-    ///
-    /// \param json The JSON string to process.
-    /// \param pos The current position in the JSON string.
-    static void skipWhitespace(const std::string& json, size_t& pos);
+    static JSONVariant decodeArray(Cursor& cursor);
     
     /// \brief Decodes a JSON string value from a JSON string.
     ///
-    /// \param json The JSON string to decode.
-    /// \param pos The current position in the JSON string.
+    /// \param cursor The cursor positioned at the opening quote.
     /// \return The decoded string value.
-    static std::string decodeString(const std::string& json, size_t& pos);
-    
+    static std::string decodeString(Cursor& cursor);
+
+    /// \brief Decodes an object key, interning it without an intermediate copy.
+    ///
+    /// \param cursor The cursor positioned at the opening quote.
+    /// \return The interned key.
+    static JSONKey decodeKey(Cursor& cursor);
+
     /// \brief Decodes a JSON numeric value from a JSON string.
     ///
-    /// \param json The JSON string to decode.
-    /// \param pos The current position in the JSON string.
+    /// \param cursor The cursor positioned at the first character of the number.
     /// \return The decoded numeric value.
-    static double decodeNumber(const std::string& json, size_t& pos);
+    static double decodeNumber(Cursor& cursor);
     
     /// \brief Decodes a JSON boolean value from a JSON string.
     ///
-    /// \param json The JSON string to decode.
-    /// \param pos The current position in the JSON string.
+    /// \param cursor The cursor positioned at the literal.
     /// \return The decoded boolean value.
-    static bool decodeBool(const std::string& json, size_t& pos);
+    static bool decodeBool(Cursor& cursor);
     
     /// \brief Decodes a JSON null value from a JSON string.
     ///
-    /// \param json The JSON string to decode.
-    /// \param pos The current position in the JSON string.
+    /// \param cursor The cursor positioned at the literal.
     /// \return The decoded null value.
-    static std::nullptr_t decodeNull(const std::string& json, size_t& pos);
+    static std::nullptr_t decodeNull(Cursor& cursor);
+
+    /// \brief Recursively decodes the value starting at the next structural into a view tree.
+    ///
+    /// This method is used internally by the decodeView method.
+    ///
+    /// \param cursor The cursor over the structural index.
+    /// \return The decoded value.
+    static JSONViewVariant decodeViewValue(Cursor& cursor);
+
+    /// \brief Decodes a JSON object into a view tree.
+    ///
+    /// \param cursor The cursor positioned at the opening brace.
+    /// \return The members in document order.
+    static JSONViewObject decodeViewObject(Cursor& cursor);
+
+    /// \brief Decodes a JSON array into a view tree.
+    ///
+    /// \param cursor The cursor positioned at the opening bracket.
+    /// \return The elements in document order.
+    static JSONViewArray decodeViewArray(Cursor& cursor);
+
+    /// \brief Finds the end of a JSON string without copying it.
+    ///
+    /// \param cursor The cursor positioned at the opening quote.
+    /// \return A lazy string over the string body.
+    static JSONLazyString decodeViewString(Cursor& cursor);
 };
 
+template <typename Sink>
+void JSON::escapeTo(std::string_view text, Sink& out) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    size_t pos = 0;
+    while (true) {
+        size_t end = JSONScanner::findEscape(text.data(), pos, text.size());
+        out.write(text.data() + pos, end - pos);                            // Copy the clean span in bulk
+        if (end == text.size()) {
+            return;
+        }
+
+        unsigned char c = static_cast<unsigned char>(text[end]);
+        char escape[6] = {'\\', static_cast<char>(c), 0, 0, 0, 0};
+        size_t length = 2;
+        switch (c) {
+            case '"':
+            case '\\': break;
+            case '\b': escape[1] = 'b'; break;
+            case '\f': escape[1] = 'f'; break;
+            case '\n': escape[1] = 'n'; break;
+            case '\r': escape[1] = 'r'; break;
+            case '\t': escape[1] = 't'; break;
+            default:
+                std::memcpy(escape + 1, "u00", 3);
+                escape[4] = kHex[c >> 4];
+                escape[5] = kHex[c & 0xf];
+                length = 6;
+        }
+        out.write(escape, length);
+        pos = end + 1;
+    }
+}
+
 }
 
 #endif /* SFCxxJSON_h */
@@ -0,0 +1,398 @@
+//===-- include/SFCxxJSONBinding.h - Typed JSON Binding ---------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines compile-time field descriptors that bind structs to JSON.
+///
+/// A struct is bound by specializing `JSONBinding` with a `constexpr` tuple of
+/// descriptors that map JSON keys to data members. `JSONBind` then writes the
+/// struct straight to JSON text, into a string or any output sink such as a
+/// `JSONBuilderSink`, and reads JSON (or CBOR) straight into it, without
+/// building a `JSONVariant` in between. The descriptors are template
+/// arguments, so the member list is unrolled at compile time: encoding is a
+/// fixed sequence of appends, and decoding compares each key against the
+/// known keys of its object only.
+///
+/// Descriptors:
+/// - `jsonField(key, &T::member)` binds a member. Supported member types are
+///   `bool`, integers, floating-point numbers, `std::string`, `char[N]` (a
+///   null-terminated buffer, truncated on read) and structs that have a
+///   `JSONBinding` of their own.
+/// - `jsonFlag(key, &T::member)` binds an integer member to a JSON boolean.
+/// - `jsonGroup(key, descriptors...)` nests members of the same struct in a
+///   JSON object, for flat structs stored as nested documents.
+/// - `jsonLiteral(key, json)` writes fixed JSON text and skips the member when reading.
+///
+/// Keys missing from the input and `null` values leave members unchanged, and
+/// unknown keys are skipped.
+///
+/// Example usage:
+/// \code
+///   struct Flags { bool favorite; int locked; };
+///
+///   template <>
+///   struct sfcxx::JSONBinding<Flags> {
+///       static constexpr auto fields = std::make_tuple(
+///           sfcxx::jsonField("is_Favorite", &Flags::favorite),
+///           sfcxx::jsonFlag("is_Locked", &Flags::locked));
+///   };
+///
+///   std::string json = sfcxx::JSONBind::encode(Flags{true, 0});
+///   Flags flags = sfcxx::JSONBind::decode<Flags>(json);
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONBinding_h
+#define SFCxxJSONBinding_h
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "SFCxxCBOR.h"
+#include "SFCxxJSON.h"
+#include "SFCxxJSONNumber.h"
+#include "SFCxxJSONReader.h"
+
+namespace sfcxx {
+
+/// \brief Describes the JSON members of `T`. Specialize it with a `static constexpr auto fields` tuple.
+template <typename T>
+struct JSONBinding;
+
+#pragma mark - Descriptors
+
+/// \brief Binds a data member to a key.
+template <typename Owner, typename Member>
+struct JSONField {
+    std::string_view key;
+    Member Owner::*member;
+};
+
+/// \brief Binds an integer data member to a boolean key.
+template <typename Owner, typename Member>
+struct JSONFlag {
+    std::string_view key;
+    Member Owner::*member;
+};
+
+/// \brief Nests descriptors of the same struct in a JSON object.
+template <typename... Fields>
+struct JSONGroup {
+    std::string_view key;
+    std::tuple<Fields...> fields;
+};
+
+/// \brief Writes fixed JSON text under a key; the member is skipped when reading.
+struct JSONLiteral {
+    std::string_view key;
+    std::string_view json;
+};
+
+template <typename Owner, typename Member>
+constexpr JSONField<Owner, Member> jsonField(std::string_view key, Member Owner::*member) {
+    return {key, member};
+}
+
+template <typename Owner, typename Member>
+constexpr JSONFlag<Owner, Member> jsonFlag(std::string_view key, Member Owner::*member) {
+    static_assert(std::is_integral_v<Member>, "jsonFlag binds integer members");
+    return {key, member};
+}
+
+template <typename... Fields>
+constexpr JSONGroup<Fields...> jsonGroup(std::string_view key, Fields... fields) {
+    return {key, std::tuple<Fields...>(fields...)};
+}
+
+constexpr JSONLiteral jsonLiteral(std::string_view key, std::string_view json) {
+    return {key, json};
+}
+
+#pragma mark - Encoding and decoding
+
+/// \brief Converts structs with a `JSONBinding` to and from JSON.
+class JSONBind {
+public:
+    /// \brief Encodes `value` as a JSON object.
+    template <typename T>
+    static std::string encode(const T& value) {
+        std::string out;
+        encode(value, out);
+        return out;
+    }
+
+    /// \brief Appends `value` as a JSON object to `out`.
+    template <typename T>
+    static void encode(const T& value, std::string& out) {
+        StringSink sink{out};
+        encodeTo(value, sink);
+    }
+
+    /// \brief Writes `value` as a JSON object to an output sink.
+    ///
+    /// \tparam Sink A type with `write(const char*, size_t)` and `put(char)`, as
+    ///         taken by `JSON::escapeTo`.
+    template <typename T, typename Sink>
+    static void encodeTo(const T& value, Sink& out) {
+        writeObject(out, value, JSONBinding<T>::fields);
+    }
+
+    /// \brief Decodes a JSON object into a value-initialized `T`.
+    ///
+    /// \throws std::runtime_error If the input is malformed or a member has the wrong type.
+    template <typename T>
+    static T decode(std::string_view json) {
+        T value{};
+        decode(json, value);
+        return value;
+    }
+
+    /// \brief Decodes a JSON object into `value`, leaving members absent from the input unchanged.
+    ///
+    /// \throws std::runtime_error If the input is malformed or a member has the wrong type.
+    template <typename T>
+    static void decode(std::string_view json, T& value) {
+        JSONReader reader(json);
+        read(reader, value);
+    }
+
+    /// \brief Decodes a buffer that holds either JSON text or CBOR into `value`.
+    ///
+    /// \throws std::runtime_error If the input is malformed or a member has the wrong type.
+    template <typename T>
+    static void decodeAny(const char* data, size_t length, T& value) {
+        if (CBOR::isCBOR(data, length)) {
+            CBORReader reader(data, length);
+            read(reader, value);
+        } else {
+            decode(std::string_view(data, length), value);
+        }
+    }
+
+    /// \brief Reads a whole document from `reader` into `value`.
+    ///
+    /// \tparam Reader `JSONReader` or `CBORReader`.
+    template <typename Reader, typename T>
+    static void read(Reader& reader, T& value) {
+        if (reader.next() != JSONToken::BEGIN_OBJECT) {
+            mismatch("document", "an object");
+        }
+        readObject(reader, value, JSONBinding<T>::fields);
+        reader.next();                                                      // Rejects trailing input
+    }
+
+private:
+    /// Appends to a string; the sink behind `encode`.
+    struct StringSink {
+        std::string& out;
+        void write(const char* bytes, size_t length) { out.append(bytes, length); }
+        void put(char c) { out.push_back(c); }
+    };
+
+    template <typename Sink>
+    static void writeLiteral(Sink& out, std::string_view text) {
+        out.write(text.data(), text.size());
+    }
+
+    template <typename Sink>
+    static void writeString(Sink& out, std::string_view value) {
+        out.put('"');
+        JSON::escapeTo(value, out);
+        out.put('"');
+    }
+
+    template <typename Sink, typename Integer>
+    static void writeInteger(Sink& out, Integer value) {
+        char buffer[24];
+        char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+        out.write(buffer, static_cast<size_t>(end - buffer));
+    }
+
+    template <typename Sink>
+    static void writeNumber(Sink& out, double value) {
+        char buffer[JSONNumber::kMaxFormattedLength];
+        out.write(buffer, JSONNumber::format(value, buffer));
+    }
+
+    /// \brief Copies `value` into a null-terminated buffer, truncating at a UTF-8 character boundary.
+    static void copyString(std::string_view value, char* buffer, size_t capacity);
+
+    [[noreturn]] static void mismatch(std::string_view key, const char* expected);
+
+    template <typename Sink>
+    static void writeKey(Sink& out, std::string_view key) {
+        out.put('"');
+        writeLiteral(out, key);                                             // Keys are literals and need no escaping
+        writeLiteral(out, "\":");
+    }
+
+    template <typename Sink, typename T, typename... Fields>
+    static void writeObject(Sink& out, const T& value, const std::tuple<Fields...>& fields) {
+        out.put('{');
+        writeMembers(out, value, fields, std::index_sequence_for<Fields...>());
+        out.put('}');
+    }
+
+    template <typename Sink, typename T, typename Tuple, size_t... I>
+    static void writeMembers(Sink& out, const T& value, const Tuple& fields, std::index_sequence<I...>) {
+        ((I == 0 ? void() : out.put(','), writeMember(out, value, std::get<I>(fields))), ...);
+    }
+
+    template <typename Sink, typename T, typename Owner, typename Member>
+    static void writeMember(Sink& out, const T& value, const JSONField<Owner, Member>& field) {
+        writeKey(out, field.key);
+        writeValue(out, value.*field.member);
+    }
+
+    template <typename Sink, typename T, typename Owner, typename Member>
+    static void writeMember(Sink& out, const T& value, const JSONFlag<Owner, Member>& field) {
+        writeKey(out, field.key);
+        writeLiteral(out, value.*field.member ? "true" : "false");
+    }
+
+    template <typename Sink, typename T, typename... Fields>
+    static void writeMember(Sink& out, const T& value, const JSONGroup<Fields...>& group) {
+        writeKey(out, group.key);
+        writeObject(out, value, group.fields);
+    }
+
+    template <typename Sink, typename T>
+    static void writeMember(Sink& out, const T&, const JSONLiteral& literal) {
+        writeKey(out, literal.key);
+        writeLiteral(out, literal.json);
+    }
+
+    template <typename Sink, typename M>
+    static void writeValue(Sink& out, const M& value) {
+        if constexpr (std::is_same_v<M, bool>) {
+            writeLiteral(out, value ? "true" : "false");
+        } else if constexpr (std::is_integral_v<M> && std::is_signed_v<M>) {
+            writeInteger(out, static_cast<long long>(value));
+        } else if constexpr (std::is_integral_v<M>) {
+            writeInteger(out, static_cast<unsigned long long>(value));
+        } else if constexpr (std::is_floating_point_v<M>) {
+            writeNumber(out, value);
+        } else if constexpr (std::is_same_v<M, std::string>) {
+            writeString(out, value);
+        } else if constexpr (std::is_array_v<M>) {
+            static_assert(std::is_same_v<std::remove_extent_t<M>, char>, "only char arrays are bound as strings");
+            writeString(out, std::string_view(value, strnlen(value, std::extent_v<M>)));
+        } else {
+            writeObject(out, value, JSONBinding<M>::fields);
+        }
+    }
+
+    /// Reads the members of the object whose `BEGIN_OBJECT` is the current token.
+    template <typename Reader, typename T, typename... Fields>
+    static void readObject(Reader& reader, T& value, const std::tuple<Fields...>& fields) {
+        while (reader.next() != JSONToken::END_OBJECT) {
+            if (!dispatch(reader, value, fields, reader.stringValue(), std::index_sequence_for<Fields...>())) {
+                reader.skipValue();
+            }
+        }
+    }
+
+    /// Reads the member named `key` through the first descriptor that matches it.
+    template <typename Reader, typename T, typename Tuple, size_t... I>
+    static bool dispatch(Reader& reader, T& value, const Tuple& fields, std::string_view key, std::index_sequence<I...>) {
+        return (... || (std::get<I>(fields).key == key && (readMember(reader, value, std::get<I>(fields)), true)));
+    }
+
+    template <typename Reader, typename T, typename Owner, typename Member>
+    static void readMember(Reader& reader, T& value, const JSONField<Owner, Member>& field) {
+        if (reader.next() != JSONToken::NUL) {
+            readValue(reader, value.*field.member, field.key);
+        }
+    }
+
+    template <typename Reader, typename T, typename Owner, typename Member>
+    static void readMember(Reader& reader, T& value, const JSONFlag<Owner, Member>& field) {
+        switch (reader.next()) {
+            case JSONToken::NUL: break;
+            case JSONToken::BOOL: value.*field.member = reader.boolValue(); break;
+            case JSONToken::NUMBER: value.*field.member = reader.numberValue() != 0; break;
+            default: mismatch(field.key, "a boolean");
+        }
+    }
+
+    template <typename Reader, typename T, typename... Fields>
+    static void readMember(Reader& reader, T& value, const JSONGroup<Fields...>& group) {
+        JSONToken token = reader.next();
+        if (token == JSONToken::NUL) return;
+        if (token != JSONToken::BEGIN_OBJECT) mismatch(group.key, "an object");
+        readObject(reader, value, group.fields);
+    }
+
+    template <typename Reader, typename T>
+    static void readMember(Reader& reader, T&, const JSONLiteral&) {
+        reader.skipValue();
+    }
+
+    /// Reads the value whose first token is current into `target`.
+    template <typename Reader, typename M>
+    static void readValue(Reader& reader, M& target, std::string_view key) {
+        JSONToken token = reader.token();
+        if constexpr (std::is_same_v<M, bool>) {
+            if (token != JSONToken::BOOL) mismatch(key, "a boolean");
+            target = reader.boolValue();
+        } else if constexpr (std::is_integral_v<M>) {
+            double number = reader.numberValue();
+            double limit = std::ldexp(1.0, std::numeric_limits<M>::digits);  // Exact, unlike max()
+            if (token != JSONToken::NUMBER || std::trunc(number) != number ||
+                number < (std::is_signed_v<M> ? -limit : 0.0) || number >= limit) {
+                mismatch(key, "an integer in range");
+            }
+            target = static_cast<M>(number);
+        } else if constexpr (std::is_floating_point_v<M>) {
+            if (token != JSONToken::NUMBER) mismatch(key, "a number");
+            target = static_cast<M>(reader.numberValue());
+        } else if constexpr (std::is_same_v<M, std::string>) {
+            if (token != JSONToken::STRING) mismatch(key, "a string");
+            target.assign(reader.stringValue());
+        } else if constexpr (std::is_array_v<M>) {
+            if (token != JSONToken::STRING) mismatch(key, "a string");
+            copyString(reader.stringValue(), target, std::extent_v<M>);
+        } else {
+            if (token != JSONToken::BEGIN_OBJECT) mismatch(key, "an object");
+            readObject(reader, target, JSONBinding<M>::fields);
+        }
+    }
+};
+
+}
+
+#endif /* SFCxxJSONBinding_h */
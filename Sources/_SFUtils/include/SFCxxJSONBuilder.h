@@ -0,0 +1,92 @@
+//===-- include/SFCxxJSONBuilder.h - JSON Builder Sink ----------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Declares the output sink that lets C++ writers append to a `JSONBuilder`.
+///
+/// `JSONBuilderSink` has the `write`/`put` interface taken by `JSON::escapeTo`
+/// and `JSONBind::encodeTo`, so a C++ writer can produce one value of a
+/// document that C code is building, directly in the builder's buffer.
+///
+/// Example usage:
+/// \code
+///   JSONBuilder builder;
+///   json_builder_init(&builder, storage, sizeof(storage), 1);
+///   sfcxx::JSONBuilderSink sink = sfcxx::JSONBuilderSink::beginValue(&builder);
+///   sfcxx::JSONBind::encodeTo(config, sink);
+///   long length = json_builder_finish(&builder);
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONBuilder_h
+#define SFCxxJSONBuilder_h
+
+#include <cstddef>
+#include <cstring>
+
+#include "SFCJSON.h"
+
+namespace sfcxx {
+
+/// \brief Appends raw JSON text to the output of a `JSONBuilder`.
+///
+/// The text is not validated. As with the C functions, output that does not
+/// fit a fixed buffer sets `builder->error` and is only counted.
+class JSONBuilderSink {
+public:
+    /// \brief Appends at the current end of the builder's output, without separators.
+    explicit JSONBuilderSink(JSONBuilder* builder) : builder(builder) {}
+
+    /// \brief Starts the next value of `builder`, writing its separator as
+    ///        `json_builder_raw` does, and returns a sink for the value's text.
+    ///
+    /// Exactly one complete JSON value must then be written through the sink.
+    static JSONBuilderSink beginValue(JSONBuilder* builder);
+
+    void write(const char* bytes, size_t length) {
+        if (builder->length + length < builder->capacity) {
+            std::memcpy(builder->data + builder->length, bytes, length);
+            builder->length += length;
+        } else {
+            writeSlow(bytes, length);
+        }
+    }
+
+    void put(char c) { write(&c, 1); }
+
+private:
+    /// Grows a growable builder, or records the overflow of a fixed one.
+    void writeSlow(const char* bytes, size_t length);
+
+    JSONBuilder* builder;
+};
+
+} // namespace sfcxx
+
+#endif /* SFCxxJSONBuilder_h */
@@ -0,0 +1,189 @@
+//===-- include/SFCxxJSONDocument.h - On-Demand JSON ------------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines on-demand access to the values of a JSON document.
+///
+/// `JSONDocument` validates a buffer in one pass over its structural index and
+/// records where every array and object ends. `JSONElement` then navigates the
+/// document without building a tree: looking up a member or an array element
+/// jumps over the subtrees in between, and scalars are only converted when
+/// they are read.
+///
+/// Example usage:
+/// \code
+///   sfcxx::JSONDocument document(configText);
+///   std::string name = document.root()["project"]["name"].getString().str();
+///   bool favorite = document.root()["flags"]["is_Favorite"].getBool();
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONDocument_h
+#define SFCxxJSONDocument_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "SFCxxJSONScanner.h"
+#include "SFCxxJSONView.h"
+
+namespace sfcxx {
+
+class JSONDocument;
+
+/// \brief Enumerates the types of a `JSONElement`.
+enum class JSONType {
+    MISSING,            ///< The element does not exist, e.g. a member that was not found.
+    NUL,
+    BOOL,
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT
+};
+
+/// \brief A position in a `JSONDocument`.
+///
+/// Elements are cheap to copy and stay valid until their document is
+/// destroyed or loads another buffer. Lookups on a `MISSING` element return
+/// `MISSING` again, so paths can be chained and checked once at the end.
+class JSONElement {
+public:
+    JSONElement() = default;
+
+    /// \brief Returns the type of the value at this position.
+    JSONType type() const;
+
+    /// \brief Returns whether the element exists.
+    explicit operator bool() const { return document != nullptr; }
+
+    /// \brief Looks up an object member by its unescaped key.
+    ///
+    /// \param key The key to look for. If it occurs more than once, the last occurrence wins,
+    ///            as in `JSON::decode`.
+    /// \return The member's value, or a `MISSING` element.
+    JSONElement operator[](std::string_view key) const;
+
+    /// \brief Returns the array element at `index`, or a `MISSING` element.
+    JSONElement at(size_t index) const;
+
+    /// \brief Returns the number of elements of an array or members of an object.
+    size_t size() const;
+
+    /// \brief Returns the first element of an array or the first member value of an object.
+    JSONElement first() const;
+
+    /// \brief Returns the next element or member value in the enclosing container.
+    JSONElement nextSibling() const;
+
+    /// \brief Returns the key of an object member value.
+    ///
+    /// \throws std::runtime_error If the element is not the value of an object member.
+    JSONLazyString key() const;
+
+    /// \brief Returns the value of a string.
+    ///
+    /// \throws std::runtime_error If the element is not a string.
+    JSONLazyString getString() const;
+
+    /// \brief Returns the value of a number.
+    ///
+    /// \throws std::runtime_error If the element is not a number.
+    double getNumber() const;
+
+    /// \brief Returns the value of a boolean.
+    ///
+    /// \throws std::runtime_error If the element is not `true` or `false`.
+    bool getBool() const;
+
+    /// \brief Returns the value's source text, from its first character to its last.
+    ///
+    /// Containers include their brackets and strings their quotes. The view
+    /// points into the document's buffer; a `MISSING` element returns an empty view.
+    std::string_view raw() const;
+
+private:
+    friend class JSONDocument;
+
+    JSONElement(const JSONDocument* document, size_t index)
+        : document(document), index(static_cast<uint32_t>(index)) {}
+
+    char character() const;
+    size_t offset() const;
+
+    const JSONDocument* document = nullptr;
+    uint32_t index = 0;                 ///< Index of the value's first structural.
+};
+
+/// \brief A validated JSON buffer with an index for on-demand navigation.
+///
+/// The buffer is not copied and must outlive the document. A document can be
+/// reused for many buffers with `load`, which keeps its index capacity.
+class JSONDocument {
+public:
+    JSONDocument() = default;
+
+    /// \brief Creates a document over `json`.
+    ///
+    /// \throws std::runtime_error If the input is not well-formed JSON.
+    explicit JSONDocument(std::string_view json) { load(json); }
+
+    JSONDocument(const JSONDocument&) = delete;
+    JSONDocument& operator=(const JSONDocument&) = delete;
+
+    /// \brief Validates and indexes a new buffer, invalidating all elements of the previous one.
+    ///
+    /// Escape sequences are checked here, so unescaping the strings of a loaded
+    /// document does not fail.
+    ///
+    /// \param json The JSON text. It must outlive the document or the next call to `load`.
+    /// \throws std::runtime_error If the input is not well-formed JSON. The document is empty afterwards.
+    void load(std::string_view json);
+
+    /// \brief Returns the root value, or a `MISSING` element if nothing has been loaded.
+    JSONElement root() const { return index.positions.empty() ? JSONElement() : JSONElement(this, 0); }
+
+private:
+    friend class JSONElement;
+
+    /// \brief Returns the index of the structural following the value that starts at `i`.
+    size_t skip(size_t i) const;
+
+    void validate();
+
+    std::string_view text;
+    JSONStructuralIndex index;
+    std::vector<uint32_t> closing;      ///< For each `{` or `[`, the index of its matching close.
+};
+
+}
+
+#endif /* SFCxxJSONDocument_h */
@@ -0,0 +1,121 @@
+//===-- include/SFCxxJSONKey.h - Interned JSON Keys -------------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the interned key type used by `JSONObject`.
+///
+/// Configuration and canvas documents repeat the same few dozen member names
+/// thousands of times. `JSONKey` stores each distinct name once, in a
+/// process-wide table, together with its precomputed hash. A key is a pointer
+/// into that table, so copying it allocates nothing and comparing two interned
+/// keys is a pointer comparison. Decoding many documents of the same shape
+/// therefore only looks keys up and never allocates or rehashes them.
+///
+/// The table only grows. To keep it bounded, keys longer than
+/// `kMaxInternedLength` and any key after the first `kMaxInternedKeys` are
+/// stored in a private, reference-counted entry instead; they behave the same
+/// but compare by hash and text.
+///
+/// Example usage:
+/// \code
+///   sfcxx::JSONKey key("is_Favorite");
+///   key == sfcxx::JSONKey("is_Favorite");    // Same table entry
+///   std::string_view text = key;             // "is_Favorite"
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONKey_h
+#define SFCxxJSONKey_h
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace sfcxx {
+
+/// \brief An immutable JSON object key with a precomputed hash.
+///
+/// Keys are cheap to copy and safe to share between threads.
+class JSONKey {
+public:
+    /// \brief Keys longer than this many bytes are not interned.
+    static constexpr size_t kMaxInternedLength = 128;
+
+    /// \brief Number of distinct keys the process-wide table holds at most.
+    static constexpr size_t kMaxInternedKeys = 16384;
+
+    /// \brief Creates the empty key.
+    JSONKey();
+
+    /// \brief Interns `text`, or stores it privately if the table is full or the text is too long.
+    explicit JSONKey(std::string_view text);
+
+    const std::string& str() const { return entry->text; }
+    const char* data() const { return entry->text.data(); }
+    size_t size() const { return entry->text.size(); }
+    bool empty() const { return entry->text.empty(); }
+
+    /// \brief Returns `std::hash<std::string_view>` of the key text, computed once per distinct key.
+    size_t hash() const { return entry->hash; }
+
+    /// \brief Returns true if the key lives in the process-wide table.
+    bool isInterned() const { return owner == nullptr; }
+
+    operator const std::string&() const { return entry->text; }
+    operator std::string_view() const { return entry->text; }
+
+    friend bool operator==(const JSONKey& lhs, const JSONKey& rhs) {
+        return lhs.entry == rhs.entry
+            || (lhs.entry->hash == rhs.entry->hash && (lhs.owner || rhs.owner) && lhs.entry->text == rhs.entry->text);
+    }
+    friend bool operator==(const JSONKey& lhs, std::string_view rhs) { return lhs.entry->text == rhs; }
+    friend bool operator==(std::string_view lhs, const JSONKey& rhs) { return rhs == lhs; }
+    friend bool operator!=(const JSONKey& lhs, const JSONKey& rhs) { return !(lhs == rhs); }
+    friend bool operator!=(const JSONKey& lhs, std::string_view rhs) { return !(lhs == rhs); }
+    friend bool operator!=(std::string_view lhs, const JSONKey& rhs) { return !(rhs == lhs); }
+
+    /// \brief Returns the number of keys currently in the process-wide table.
+    static size_t internedCount();
+
+private:
+    friend class JSONKeyTable;
+
+    struct Entry {
+        std::string text;
+        size_t hash;
+    };
+
+    const Entry* entry;                 ///< Interned entry, or `owner.get()`.
+    std::shared_ptr<const Entry> owner; ///< Set only for keys that were not interned.
+};
+
+}
+
+#endif /* SFCxxJSONKey_h */
@@ -0,0 +1,86 @@
+//===-- include/SFCxxJSONLines.h - NDJSON Batches ---------------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines batch encoding and parallel decoding of newline-delimited JSON.
+///
+/// Archive metadata is exported as NDJSON: one JSON document per line. Records
+/// are independent, so `JSONLines::decode` splits the buffer into chunks on
+/// line boundaries and decodes the chunks on a shared pool of worker threads.
+/// The calling thread decodes chunks as well. Records are returned in the order
+/// they appear in the input, whatever order the chunks finish in.
+///
+/// Example usage:
+/// \code
+///   std::vector<sfcxx::JSONVariant> records = sfcxx::JSONLines::decode(catalog);
+///   std::string exported = sfcxx::JSONLines::encode(records);
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONLines_h
+#define SFCxxJSONLines_h
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SFCxxJSON.h"
+
+namespace sfcxx {
+
+/// \brief Encodes and decodes newline-delimited JSON.
+class JSONLines {
+public:
+    /// \brief Inputs are not split into chunks smaller than this many bytes.
+    static constexpr size_t kMinChunkSize = 64 * 1024;
+
+    /// \brief Decodes every record of an NDJSON buffer.
+    ///
+    /// Records are separated by `\n`; a `\r` before it is ignored, and blank
+    /// lines are skipped.
+    ///
+    /// \param data The NDJSON text.
+    /// \param threads Maximum number of threads to decode on, including the
+    ///        caller. 0 uses one per hardware thread; 1 decodes on the caller only.
+    /// \return The decoded records in input order.
+    /// \throws std::runtime_error If a record is not well-formed JSON. The
+    ///         message names the first malformed line.
+    static std::vector<JSONVariant> decode(std::string_view data, size_t threads = 0);
+
+    /// \brief Encodes records as NDJSON, each followed by `\n`.
+    ///
+    /// \param records The records to encode.
+    /// \return The encoded text.
+    static std::string encode(const std::vector<JSONVariant>& records);
+};
+
+}
+
+#endif /* SFCxxJSONLines_h */
@@ -0,0 +1,87 @@
+//===-- include/SFCxxJSONNumber.h - JSON Number Codec -----------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Declares the allocation-free number codec used by the JSON encoder and decoder.
+///
+/// Parsing validates the JSON number grammar and converts short mantissas
+/// (integers and decimals such as stroke coordinates) exactly without calling
+/// into the C library. Longer numbers fall back to `std::from_chars`.
+/// Formatting emits the shortest representation that round-trips, with a
+/// direct integer path for integral values.
+///
+/// Example usage:
+/// \code
+///   char buffer[sfcxx::JSONNumber::kMaxFormattedLength];
+///   size_t length = sfcxx::JSONNumber::format(12.5, buffer);   // "12.5"
+///
+///   double value;
+///   const char* end = sfcxx::JSONNumber::parse(buffer, buffer + length, value);
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONNumber_h
+#define SFCxxJSONNumber_h
+
+#include <cstddef>
+
+namespace sfcxx {
+
+/// \brief Converts between JSON number text and `double` without allocating.
+class JSONNumber {
+public:
+    /// \brief The size of a buffer that can hold any number written by `format`.
+    static constexpr size_t kMaxFormattedLength = 32;
+
+    /// \brief Parses a JSON number.
+    ///
+    /// Numbers whose magnitude exceeds the range of `double` are rejected, since
+    /// `format` could not write the resulting infinity back out. Numbers too small
+    /// to represent round to the nearest subnormal or signed zero.
+    ///
+    /// \param first Pointer to the first character of the number.
+    /// \param last Pointer one past the last readable character.
+    /// \param value Receives the parsed value.
+    /// \return Pointer one past the last character of the number, or `nullptr` if
+    ///         the text at `first` is not a valid JSON number or is out of range.
+    static const char* parse(const char* first, const char* last, double& value);
+
+    /// \brief Formats a number as the shortest JSON text that parses back to the same value.
+    ///
+    /// Non-finite values have no JSON representation and are written as `null`.
+    ///
+    /// \param value The value to format.
+    /// \param buffer Output buffer of at least `kMaxFormattedLength` bytes. No terminator is written.
+    /// \return Number of characters written.
+    static size_t format(double value, char* buffer);
+};
+
+}
+
+#endif /* SFCxxJSONNumber_h */
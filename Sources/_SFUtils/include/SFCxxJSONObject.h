@@ -0,0 +1,158 @@
+//===-- include/SFCxxJSONObject.h - Ordered JSON Objects --------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the insertion-ordered object type used by `JSONVariant`.
+///
+/// Configuration documents consist of many objects with a handful of members.
+/// `JSONObject` stores its members contiguously in insertion order and finds
+/// keys by a linear scan, which for small objects is faster than hashing and
+/// needs a single allocation. Once an object grows past `kIndexThreshold`
+/// members, an open-addressing hash index over the member positions is built
+/// next to the members. Either way, iteration and therefore `JSON::encode`
+/// follow insertion order, so the same document always encodes to the same bytes.
+/// Member names are interned `JSONKey`s, so the index reuses their precomputed
+/// hashes and lookups by `JSONKey` compare pointers before text.
+///
+/// Example usage:
+/// \code
+///   sfcxx::JSONObject flags;
+///   flags["is_Favorite"] = std::make_shared<sfcxx::JSONValue>(true);
+///   flags.insert_or_assign("is_Locked", std::make_shared<sfcxx::JSONValue>(false));
+///   for (const auto& [key, value] : flags) { /* is_Favorite, then is_Locked */ }
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONObject_h
+#define SFCxxJSONObject_h
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "SFCxxJSONKey.h"
+
+namespace sfcxx {
+
+struct JSONValue;
+
+/// \brief A JSON object that keeps its members in insertion order.
+///
+/// The interface follows the subset of `std::unordered_map` the JSON code
+/// uses. Iterators and references are invalidated by any insertion or erasure.
+/// Keys must not be modified through iterators.
+class JSONObject {
+public:
+    using value_type = std::pair<JSONKey, std::shared_ptr<JSONValue>>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    /// \brief Member count above which lookups go through a hash index.
+    static constexpr size_t kIndexThreshold = 16;
+
+    JSONObject() = default;
+
+    /// \brief Creates an object from a list of members. Later duplicates replace earlier values.
+    JSONObject(std::initializer_list<std::pair<std::string_view, std::shared_ptr<JSONValue>>> members);
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void reserve(size_t count) { entries.reserve(count); }
+    void clear();
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    /// \brief Finds a member by key.
+    ///
+    /// \return An iterator to the member, or `end()`.
+    iterator find(std::string_view key);
+    const_iterator find(std::string_view key) const;
+    iterator find(const JSONKey& key);
+    const_iterator find(const JSONKey& key) const;
+
+    /// \brief Returns 1 if the object has a member named `key`, otherwise 0.
+    size_t count(std::string_view key) const { return position(key) != kNotFound; }
+
+    /// \brief Returns the value of `key`, appending a member with an empty value if there is none.
+    std::shared_ptr<JSONValue>& operator[](std::string_view key);
+
+    /// \brief Returns the value of `key`.
+    ///
+    /// \throws std::out_of_range If the object has no member named `key`.
+    std::shared_ptr<JSONValue>& at(std::string_view key);
+    const std::shared_ptr<JSONValue>& at(std::string_view key) const;
+
+    /// \brief Appends a member, or replaces the value of an existing member in place.
+    ///
+    /// \return The member, and whether it was appended.
+    std::pair<iterator, bool> insert_or_assign(std::string_view key, std::shared_ptr<JSONValue> value);
+    std::pair<iterator, bool> insert_or_assign(JSONKey key, std::shared_ptr<JSONValue> value);
+
+    /// \brief Appends a member unless the key already exists.
+    ///
+    /// \return The member with that key, and whether it was appended.
+    std::pair<iterator, bool> emplace(std::string_view key, std::shared_ptr<JSONValue> value);
+    std::pair<iterator, bool> emplace(JSONKey key, std::shared_ptr<JSONValue> value);
+
+    /// \brief Removes the member named `key`, keeping the order of the others.
+    ///
+    /// \return The number of members removed.
+    size_t erase(std::string_view key);
+
+private:
+    static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+    /// \brief Returns the position of `key` in `entries`, or `kNotFound`.
+    size_t position(std::string_view key) const;
+    size_t position(const JSONKey& key) const;
+
+    /// \brief Appends a member that is known to be absent.
+    iterator append(JSONKey key, std::shared_ptr<JSONValue> value);
+
+    /// \brief Inserts the member at `pos` into `slots`.
+    void indexEntry(size_t pos);
+
+    /// \brief Rebuilds `slots` for the current members, or drops it for small objects.
+    void rebuildIndex();
+
+    std::vector<value_type> entries;    ///< Members in insertion order.
+    std::vector<uint32_t> slots;        ///< Hash index of member positions + 1; 0 marks a free slot.
+};
+
+}
+
+#endif /* SFCxxJSONObject_h */
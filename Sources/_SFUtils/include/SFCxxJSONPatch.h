@@ -0,0 +1,165 @@
+//===-- include/SFCxxJSONPatch.h - JSON Patch -------------------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines JSON Patch (RFC 6902) and JSON Merge Patch (RFC 7386).
+///
+/// A `JSONPatch` is a list of edits addressed by JSON Pointers. It can be
+/// applied to a decoded `JSONVariant` or directly to JSON text:
+///
+///  - On a `JSONVariant`, only the containers along each edited path are
+///    copied; unchanged subtrees are shared with the original document.
+///  - On JSON text, each edit replaces the bytes of the values it touches and
+///    leaves the rest of the text, including its formatting, as it was.
+///    Independent edits are collected and spliced in a single pass.
+///
+/// In both cases a patch is applied as a whole or not at all. Appending many
+/// edits to one patch applies them as one commit.
+///
+/// Example usage:
+/// \code
+///   sfcxx::JSONPatch patch;
+///   patch.replace("/flags/is_Favorite", true)
+///        .add("/project/last_changed_at", std::string("2024-07-14"));
+///   patch.apply(configText);
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONPatch_h
+#define SFCxxJSONPatch_h
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SFCxxJSON.h"
+#include "SFCxxJSONDocument.h"
+
+namespace sfcxx {
+
+/// \brief Enumerates the operations of a JSON Patch.
+enum class JSONPatchOperation {
+    ADD,
+    REMOVE,
+    REPLACE,
+    MOVE,
+    COPY,
+    TEST
+};
+
+/// \brief An ordered list of JSON Patch operations.
+///
+/// Paths are JSON Pointers and are validated when an operation is added;
+/// malformed pointers throw `std::invalid_argument`. Applying a patch throws
+/// `std::runtime_error` if an operation cannot be performed, for example
+/// because its path does not exist or a `test` fails. The target is left
+/// unchanged in that case.
+class JSONPatch {
+public:
+    JSONPatch() = default;
+
+    /// \brief Builds a patch from a decoded RFC 6902 patch document.
+    ///
+    /// \param patch An array of operation objects.
+    /// \throws std::invalid_argument If the document is not a valid JSON Patch.
+    explicit JSONPatch(const JSONVariant& patch);
+
+    /// \brief Builds a patch from the text of an RFC 6902 patch document.
+    ///
+    /// \throws std::runtime_error If the text is not well-formed JSON.
+    /// \throws std::invalid_argument If the document is not a valid JSON Patch.
+    static JSONPatch parse(std::string_view json);
+
+    JSONPatch& add(std::string_view path, JSONVariant value);
+    JSONPatch& remove(std::string_view path);
+    JSONPatch& replace(std::string_view path, JSONVariant value);
+    JSONPatch& move(std::string_view from, std::string_view path);
+    JSONPatch& copy(std::string_view from, std::string_view path);
+    JSONPatch& test(std::string_view path, JSONVariant value);
+
+    /// \brief Appends the operations of another patch, to be applied after the current ones.
+    JSONPatch& append(const JSONPatch& other);
+
+    size_t size() const { return operations.size(); }
+    bool empty() const { return operations.empty(); }
+
+    /// \brief Applies the patch to a decoded document.
+    ///
+    /// \throws std::runtime_error If an operation fails. `document` is not modified.
+    void apply(JSONVariant& document) const;
+
+    /// \brief Applies the patch to JSON text in place.
+    ///
+    /// Values written by the patch are encoded compactly; everything else keeps
+    /// its original bytes. If a key occurs more than once in an object, paths
+    /// address its last occurrence, as in `JSON::decode`, and removing the key
+    /// removes every occurrence, so the result decodes as `apply` on the decoded
+    /// document would leave it.
+    ///
+    /// \throws std::runtime_error If `json` is not well-formed JSON or an operation fails.
+    ///         `json` is not modified.
+    void apply(std::string& json) const;
+
+    /// \brief Applies a JSON Merge Patch to a decoded document.
+    ///
+    /// Members of `patch` that are `null` are removed from `target`, objects are
+    /// merged recursively and all other values replace the existing ones.
+    static void merge(JSONVariant& target, const JSONVariant& patch);
+
+    /// \brief Applies a JSON Merge Patch to JSON text in place.
+    ///
+    /// The merge is translated into JSON Patch operations on the members it
+    /// changes, so unchanged parts of the text keep their original bytes.
+    ///
+    /// \throws std::runtime_error If `json` is not well-formed JSON. `json` is not modified.
+    static void merge(std::string& json, const JSONVariant& patch);
+
+private:
+    /// \brief The unescaped reference tokens of a JSON Pointer.
+    using Pointer = std::vector<std::string>;
+
+    struct Operation {
+        JSONPatchOperation op;
+        Pointer path;
+        Pointer from;                   ///< Source of `MOVE` and `COPY`.
+        JSONVariant value;              ///< Value of `ADD`, `REPLACE` and `TEST`.
+        std::string encoded;            ///< `value` as JSON text, for patches applied to text.
+    };
+
+    static Pointer parsePointer(std::string_view pointer);
+    static void mergeOperations(JSONPatch& patch, JSONElement target, Pointer& path, const JSONVariant& merge);
+    JSONPatch& push(JSONPatchOperation op, Pointer path, Pointer from, JSONVariant value);
+
+    std::vector<Operation> operations;
+};
+
+}
+
+#endif /* SFCxxJSONPatch_h */
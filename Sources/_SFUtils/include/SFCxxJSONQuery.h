@@ -0,0 +1,157 @@
+//===-- include/SFCxxJSONQuery.h - JSON Path Queries ------------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines compiled path queries over JSON documents.
+///
+/// A `JSONQuery` is compiled once from either a JSON Pointer (RFC 6901) or a
+/// JSONPath expression and can then be evaluated any number of times against
+/// a decoded `JSONVariant`, a `JSONDocument`, or a `JSONReader` that streams
+/// the raw text. The supported JSONPath subset is:
+///
+///  - `$` selects the root value.
+///  - `.name` and `['name']` select the member `name` of an object.
+///  - `[2]` selects the element at index 2 of an array.
+///  - `.*` and `[*]` select every member or element.
+///  - `..name`, `..[2]` and `..*` select the same at any depth below the current value.
+///
+/// Example usage:
+/// \code
+///   sfcxx::JSONQuery name("$.project.name");
+///   sfcxx::JSONQuery images("/references/images");
+///
+///   sfcxx::JSONDocument document(configText);
+///   if (sfcxx::JSONElement element = name.selectFirst(document)) {
+///       std::cout << element.getString().value() << std::endl;
+///   }
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONQuery_h
+#define SFCxxJSONQuery_h
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SFCxxJSON.h"
+#include "SFCxxJSONDocument.h"
+#include "SFCxxJSONReader.h"
+
+namespace sfcxx {
+
+/// \brief A compiled JSON Pointer or JSONPath expression.
+///
+/// Evaluation runs the path as a small state machine: every value is visited
+/// at most once, and subtrees that no step of the path can match are skipped
+/// without being looked at. Results are reported in document order.
+class JSONQuery {
+public:
+    /// \brief The maximum number of steps in a path.
+    static constexpr size_t kMaxSteps = 63;
+
+    /// \brief Compiles a path expression.
+    ///
+    /// \param expression A JSON Pointer (empty or starting with `/`) or a JSONPath
+    ///                   expression (starting with `$`).
+    /// \throws std::invalid_argument If the expression is malformed or has more than `kMaxSteps` steps.
+    explicit JSONQuery(std::string_view expression);
+
+    /// \brief Returns all values selected in a decoded document.
+    ///
+    /// \param root The root of the document.
+    /// \return Pointers into `root`, valid as long as the document is not modified.
+    std::vector<const JSONVariant*> select(const JSONVariant& root) const;
+
+    /// \brief Returns the first value selected in a decoded document, or `nullptr`.
+    const JSONVariant* selectFirst(const JSONVariant& root) const;
+
+    /// \brief Returns all values selected in an on-demand document.
+    std::vector<JSONElement> select(const JSONDocument& document) const;
+
+    /// \brief Returns the first value selected in an on-demand document, or a `MISSING` element.
+    JSONElement selectFirst(const JSONDocument& document) const;
+
+    /// \brief Evaluates the query while streaming a document from a reader.
+    ///
+    /// Only the selected values are materialized; everything else is skipped
+    /// token by token. The reader must be positioned before the root value and
+    /// must read from a buffer or a file descriptor. It is left at the end of the document.
+    ///
+    /// \param reader The reader to consume.
+    /// \param onMatch Called with each selected value.
+    /// \throws std::runtime_error If the input is not well-formed JSON.
+    /// \throws std::logic_error If the reader runs out of input before the end of the document.
+    void select(JSONReader& reader, const std::function<void(JSONVariant&&)>& onMatch) const;
+
+    /// \brief Returns the number of steps of the compiled path.
+    size_t size() const { return steps.size(); }
+
+private:
+    using StateSet = uint64_t;          ///< Bit `i` set: step `i` is the next one to match.
+
+    /// \brief One step of a compiled path.
+    struct Step {
+        /// \brief What a step matches.
+        enum class Kind {
+            KEY,                        ///< An object member named `name`.
+            INDEX,                      ///< The array element at `index`.
+            KEY_OR_INDEX,               ///< A JSON Pointer token: a member named `name`, or element `index`.
+            WILDCARD                    ///< Every member or element.
+        };
+
+        Kind kind;
+        bool descendant;                ///< Whether the step may match at any depth (`..`).
+        std::string name;
+        size_t index;                   ///< Element index, or `SIZE_MAX` if `name` is not an index.
+    };
+
+    void compilePointer(std::string_view expression);
+    void compilePath(std::string_view expression);
+
+    StateSet finalState() const { return StateSet(1) << steps.size(); }
+
+    template <typename Key>
+    StateSet statesForMember(StateSet states, const Key& key) const;
+    StateSet statesForElement(StateSet states, size_t index) const;
+
+    template <typename Nodes, typename Emit>
+    bool walk(typename Nodes::Node node, StateSet states, Emit& emit) const;
+
+    void stream(JSONReader& reader, StateSet states, const std::function<void(JSONVariant&&)>& onMatch) const;
+
+    std::vector<Step> steps;
+};
+
+}
+
+#endif /* SFCxxJSONQuery_h */
@@ -0,0 +1,189 @@
+//===-- include/SFCxxJSONReader.h - JSON Pull Parser ------------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines an event-based pull parser for JSON documents.
+///
+/// `JSONReader` reports a document as a sequence of tokens instead of building
+/// a `JSONVariant` tree. It reads from a caller-owned buffer, from a file
+/// descriptor, or from chunks handed to `feed` as they arrive, and only keeps
+/// the unconsumed tail of the input plus one entry per open container, so
+/// memory use does not grow with the document size.
+///
+/// Example usage:
+/// \code
+///   sfcxx::JSONReader reader(configText);
+///   while (reader.next() != sfcxx::JSONToken::END_OF_DOCUMENT) {
+///       if (reader.token() == sfcxx::JSONToken::KEY && reader.depth() == 2 &&
+///           reader.stringValue() == "name") {
+///           reader.next();
+///           std::cout << reader.stringValue() << std::endl;
+///       }
+///   }
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONReader_h
+#define SFCxxJSONReader_h
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sfcxx {
+
+/// \brief Enumerates the tokens reported by `JSONReader`.
+enum class JSONToken {
+    BEGIN_OBJECT,       ///< `{`
+    END_OBJECT,         ///< `}`
+    BEGIN_ARRAY,        ///< `[`
+    END_ARRAY,          ///< `]`
+    KEY,                ///< An object key; see `JSONReader::stringValue`.
+    STRING,             ///< A string value; see `JSONReader::stringValue`.
+    NUMBER,             ///< A number value; see `JSONReader::numberValue`.
+    BOOL,               ///< `true` or `false`; see `JSONReader::boolValue`.
+    NUL,                ///< `null`
+    END_OF_DOCUMENT,    ///< The root value has been read completely.
+    NEED_MORE_INPUT     ///< Chunked input only: call `feed` or `finish` and then `next` again.
+};
+
+/// \brief Reads a JSON document token by token.
+///
+/// The reader validates the document as it goes and throws `std::runtime_error`
+/// on malformed input. Values returned by `stringValue` stay valid until the
+/// next call to `next`, `skipValue` or `feed`.
+class JSONReader {
+public:
+    /// \brief Creates a reader for chunked input delivered through `feed`.
+    JSONReader();
+
+    /// \brief Creates a reader over a complete, caller-owned buffer.
+    ///
+    /// The buffer is not copied and must outlive the reader.
+    ///
+    /// \param buffer The JSON document.
+    explicit JSONReader(std::string_view buffer);
+
+    /// \brief Creates a reader that pulls the document from a file descriptor.
+    ///
+    /// \param fd An open, readable file descriptor. The reader does not close it.
+    /// \param chunkSize Number of bytes requested per `read` call.
+    explicit JSONReader(int fd, size_t chunkSize = 64 * 1024);
+
+    /// \brief Appends a chunk of input. Chunked readers only.
+    ///
+    /// \param data Pointer to the chunk. It is copied and may be reused afterwards.
+    /// \param length Length of the chunk in bytes.
+    void feed(const char* data, size_t length);
+
+    /// \brief Signals that no more chunks follow. Chunked readers only.
+    void finish();
+
+    /// \brief Advances to the next token.
+    ///
+    /// \return The new current token.
+    /// \throws std::runtime_error If the input is not well-formed JSON, or on a read error.
+    JSONToken next();
+
+    /// \brief Skips the value that starts at the current token.
+    ///
+    /// After `BEGIN_OBJECT` or `BEGIN_ARRAY` the whole container is consumed and
+    /// the current token becomes the matching end token; after a `KEY` the
+    /// member's value is consumed. Scalars are already complete and are left as
+    /// they are. If a chunked reader runs out of input while skipping,
+    /// `NEED_MORE_INPUT` is returned and the next call to `next` resumes the skip.
+    ///
+    /// \return The new current token.
+    JSONToken skipValue();
+
+    /// \brief Returns the current token.
+    JSONToken token() const { return current; }
+
+    /// \brief Returns the number of containers enclosing the current token.
+    ///
+    /// A `BEGIN_*` token already counts its own container, the matching `END_*`
+    /// token does not.
+    size_t depth() const { return stack.size(); }
+
+    /// \brief Returns the unescaped text of the current `KEY` or `STRING` token.
+    std::string_view stringValue() const { return text; }
+
+    /// \brief Returns the value of the current `NUMBER` token.
+    double numberValue() const { return number; }
+
+    /// \brief Returns the value of the current `BOOL` token.
+    bool boolValue() const { return boolean; }
+
+private:
+    /// \brief What the grammar allows at the current position.
+    enum class State {
+        VALUE,
+        FIRST_KEY_OR_END,
+        KEY,
+        COLON,
+        FIRST_VALUE_OR_END,
+        COMMA_OR_END,
+        DONE
+    };
+
+    const char* data = nullptr;         ///< Readable input (view or `storage`).
+    size_t size = 0;                    ///< Number of readable bytes.
+    size_t pos = 0;                     ///< Offset of the first unconsumed byte.
+    size_t consumed = 0;                ///< Bytes discarded from the front of `storage`.
+    std::string storage;                ///< Owned input for chunked and fd readers.
+    bool owning = false;                ///< Whether `data` points into `storage`.
+    bool finished = false;              ///< Whether the end of the input has been reached.
+    int fd = -1;                        ///< Source descriptor, or -1.
+    size_t chunkSize = 0;               ///< Bytes per `read` call for fd readers.
+
+    State state = State::VALUE;
+    std::vector<char> stack;            ///< Open containers, `{` or `[`.
+    size_t skipDepth = 0;               ///< Pending `skipValue` target depth + 1, or 0.
+    size_t resumeScan = 0;              ///< String scan progress across `NEED_MORE_INPUT`.
+
+    JSONToken current = JSONToken::NEED_MORE_INPUT;
+    std::string_view text;
+    std::string scratch;                ///< Unescaped text of strings that contained escapes.
+    double number = 0;
+    bool boolean = false;
+
+    JSONToken readToken();
+    bool readString();
+    bool readNumber();
+    bool readLiteral(const char* literal, size_t length);
+    bool fill();
+    void compact();
+    void afterValue();
+    [[noreturn]] void fail(const char* what) const;
+};
+
+}
+
+#endif /* SFCxxJSONReader_h */
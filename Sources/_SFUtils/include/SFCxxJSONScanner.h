@@ -0,0 +1,103 @@
+//===-- include/SFCxxJSONScanner.h - JSON Structural Scanner ----*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Declares the vectorized first stage of the JSON decoder.
+///
+/// The scanner classifies the input 64 bytes at a time into quote, backslash,
+/// structural and whitespace bitmasks using SSE2/AVX2 (x86_64) or NEON (arm64)
+/// kernels, selected once at runtime. From these masks it derives which bytes
+/// are inside string literals and records the offsets of all structural
+/// characters into a `JSONStructuralIndex`. `JSON::decode` then walks that
+/// index instead of inspecting the input one character at a time.
+///
+/// Example usage:
+/// \code
+///   sfcxx::JSONStructuralIndex index;
+///   sfcxx::JSONScanner::buildIndex(json.data(), json.size(), index);
+///   for (uint32_t offset : index.positions) { /* json[offset] is structural */ }
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONScanner_h
+#define SFCxxJSONScanner_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sfcxx {
+
+/// \brief Offsets of the structural characters of a JSON document.
+///
+/// An offset is recorded for every `{`, `}`, `[`, `]`, `:` and `,` outside of
+/// a string literal, for every opening quote, and for the first byte of every
+/// other scalar (numbers, `true`, `false`, `null`). Whitespace, string contents
+/// and closing quotes are never recorded.
+struct JSONStructuralIndex {
+    std::vector<uint32_t> positions;    ///< Ascending byte offsets into the scanned buffer.
+    bool unterminatedString = false;    ///< Set if the buffer ends inside a string literal.
+};
+
+/// \brief Provides the SIMD scanning primitives used by the JSON decoder.
+class JSONScanner {
+public:
+    /// \brief Builds the structural index of a JSON buffer.
+    ///
+    /// \param data Pointer to the JSON text.
+    /// \param length Length of the JSON text in bytes. Must not exceed `UINT32_MAX`.
+    /// \param index The index to fill. Any previous contents are discarded.
+    static void buildIndex(const char* data, size_t length, JSONStructuralIndex& index);
+
+    /// \brief Finds the next byte that ends a clean run of string content.
+    ///
+    /// \param data Pointer to the JSON text.
+    /// \param pos Offset to start searching from.
+    /// \param length Length of the JSON text in bytes.
+    /// \return Offset of the next `"` or `\\` at or after `pos`, or `length` if there is none.
+    static size_t findQuoteOrBackslash(const char* data, size_t pos, size_t length);
+
+    /// \brief Finds the next byte that a JSON string must escape when encoded.
+    ///
+    /// \param data Pointer to the text to encode.
+    /// \param pos Offset to start searching from.
+    /// \param length Length of the text in bytes.
+    /// \return Offset of the next `"`, `\\` or control character below 0x20 at
+    ///         or after `pos`, or `length` if there is none.
+    static size_t findEscape(const char* data, size_t pos, size_t length);
+
+    /// \brief Returns the name of the kernel selected for this CPU.
+    ///
+    /// \return One of `"avx2"`, `"sse2"`, `"neon"` or `"scalar"`.
+    static const char* activeKernel();
+};
+
+}
+
+#endif /* SFCxxJSONScanner_h */
@@ -0,0 +1,135 @@
+//===-- include/SFCxxJSONView.h - Zero-Copy JSON Values ---------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//     __ _____ _____ _____                                                   //
+//  __|  |   __|     |   | |  SFCxxJSON methods for Scribble Foundation       //
+// |  |  |__   |  |  | | | |  Version 1.0                                     //
+// |_____|_____|_____|_|___|  https://github.com/ScribbleLabApp/              //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the value types produced by `JSON::decodeView`.
+///
+/// A view tree has the same shape as a `JSONVariant` tree, but strings and
+/// object keys are not copied: they point into the decoded buffer, and escape
+/// sequences are only decoded when a string that contains them is read. Arrays
+/// and objects hold their elements by value, in document order.
+///
+/// The buffer passed to `JSON::decodeView` must outlive the returned tree.
+///
+/// Example usage:
+/// \code
+///   std::string config = readConfig();
+///   sfcxx::JSONViewValue root = sfcxx::JSON::decodeView(config);
+///   if (const sfcxx::JSONViewValue* name = root.find("name")) {
+///       std::string_view text = std::get<sfcxx::JSONLazyString>(name->value).value();
+///   }
+/// \endcode
+///
+/// \author ScribbleLabApp
+/// \date July 2024
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SFCxxJSONView_h
+#define SFCxxJSONView_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace sfcxx {
+
+/// \brief A JSON string that refers to its source text and is unescaped on access.
+///
+/// Strings without escape sequences are returned as views into the source.
+/// A string that contains escapes is decoded on the first call to `value` and
+/// the result is cached; the cache is not synchronized, so a tree must not be
+/// read from several threads until its escaped strings have been accessed once.
+class JSONLazyString {
+public:
+    JSONLazyString() = default;
+
+    /// \brief Creates a string over the text between the quotes.
+    ///
+    /// \param raw The string body as it appears in the source, escapes intact.
+    /// \param hasEscapes Whether `raw` contains a backslash.
+    JSONLazyString(std::string_view raw, bool hasEscapes)
+        : data(raw.data()), length(raw.size()), escapes(hasEscapes) {}
+
+    /// \brief Returns the string body as it appears in the source.
+    std::string_view raw() const { return std::string_view(data, length); }
+
+    /// \brief Returns whether the string contains escape sequences.
+    bool hasEscapes() const { return escapes; }
+
+    /// \brief Returns the unescaped string.
+    ///
+    /// The view stays valid as long as this object and the source buffer do.
+    /// Escape sequences are only validated here, not while the tree is built.
+    ///
+    /// \throws std::runtime_error If the string contains an invalid escape sequence.
+    std::string_view value() const;
+
+    /// \brief Returns an owned copy of the unescaped string.
+    std::string str() const { return std::string(value()); }
+
+    /// \brief Compares the unescaped string with `other`.
+    bool operator==(std::string_view other) const;
+    bool operator!=(std::string_view other) const { return !(*this == other); }
+
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    bool escapes = false;
+    mutable std::shared_ptr<const std::string> decoded;     ///< Unescaped text, set on first access.
+};
+
+struct JSONViewValue;
+
+/// \brief The elements of a JSON array in a view tree.
+using JSONViewArray = std::vector<JSONViewValue>;
+
+/// \brief The members of a JSON object in a view tree, in document order.
+using JSONViewObject = std::vector<std::pair<JSONLazyString, JSONViewValue>>;
+
+/// \brief Represents a variant of JSON values that borrow their strings from the source.
+using JSONViewVariant = std::variant<std::nullptr_t, bool, double, JSONLazyString, JSONViewArray, JSONViewObject>;
+
+/// \brief Represents a JSON value in a view tree.
+struct JSONViewValue {
+    JSONViewVariant value;
+
+    /// \brief Looks up an object member by its unescaped key.
+    ///
+    /// If the key occurs more than once, the last occurrence wins, as in `JSON::decode`.
+    ///
+    /// \param key The key to look for.
+    /// \return The member's value, or `nullptr` if this is not an object or has no such member.
+    const JSONViewValue* find(std::string_view key) const;
+};
+
+}
+
+#endif /* SFCxxJSONView_h */
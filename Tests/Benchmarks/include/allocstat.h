@@ -0,0 +1,43 @@
+//===-- Benchmarks/include/allocstat.h - Allocation counting ------*- C -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Reports the heap allocations made through `operator new` by the benchmark
+/// binary; see allocstat.cpp.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef ALLOCSTAT_H
+#define ALLOCSTAT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Returns the number of `operator new` calls made so far by this process.
+size_t bench_allocations(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //ALLOCSTAT_H
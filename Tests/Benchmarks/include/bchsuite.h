@@ -30,6 +30,15 @@
 // Import benchmark macros & functions
 #include "bench.h"
 
+// Import the C interface of the JSON codec
+#include "SFCJSON.h"
+
+// Import the canvas layout reader and writer
+#include "SFCXML.h"
+
+// Import allocation counting
+#include "allocstat.h"
+
 // Replace this function with your actual benchmark test implementation
 void test(void) {
     //printf("Running benchmark test for 'test'\n");
@@ -39,4 +48,313 @@ void test(void) {
     for (volatile int i = 0; i < 1000000; ++i);
 }
 
+/// Builds a stroke document with `points` [x, y, pressure] samples, the
+/// number-heavy shape of a canvas drawing.
+static char* bench_make_stroke_json(size_t points) {
+    size_t cap = points * 48 + 32;
+    char* json = (char*)malloc(cap);
+    size_t len = (size_t)snprintf(json, cap, "{\"strokes\":[");
+
+    for (size_t i = 0; i < points; ++i) {
+        uint64_t h = bench_hash64(i);
+        len += (size_t)snprintf(json + len, cap - len, "%s[%.2f,%.2f,%.3f]", i ? "," : "",
+                                (double)(h & 0xffff) / 16.0,
+                                (double)((h >> 16) & 0xffff) / 16.0,
+                                (double)((h >> 32) & 0x3ff) / 1024.0);
+    }
+    snprintf(json + len, cap - len, "]}");
+    return json;
+}
+
+void bench_json_numbers(void) {
+    char* json = bench_make_stroke_json(100000);
+    JSONVariant strokes = json_decode(json);
+
+    BENCH("JSON decode stroke coordinates (100k points)", 2, 20) {
+        JSONVariant decoded = json_decode(json);
+        free_json(decoded);
+    }
+
+    BENCH("JSON encode stroke coordinates (100k points)", 2, 20) {
+        char* encoded = json_encode(strokes);
+        BENCH_VOLATILE(encoded);
+        free(encoded);
+    }
+
+    BENCH("JSON builder stroke coordinates (100k points)", 2, 20) {
+        char storage[4096];
+        JSONBuilder builder;
+        json_builder_init(&builder, storage, sizeof(storage), 1);
+        json_builder_begin_object(&builder);
+        json_builder_key(&builder, "strokes");
+        json_builder_begin_array(&builder);
+        for (size_t i = 0; i < 100000; ++i) {
+            uint64_t h = bench_hash64(i);
+            json_builder_begin_array(&builder);
+            json_builder_number(&builder, (double)(h & 0xffff) / 16.0);
+            json_builder_number(&builder, (double)((h >> 16) & 0xffff) / 16.0);
+            json_builder_number(&builder, (double)((h >> 32) & 0x3ff) / 1024.0);
+            json_builder_end_array(&builder);
+        }
+        json_builder_end_array(&builder);
+        json_builder_end_object(&builder);
+        long length = json_builder_finish(&builder);
+        BENCH_VOLATILE(length);
+        json_builder_free(&builder);
+    }
+
+    size_t cborLength = 0;
+    char* cbor = json_encode_cbor(strokes, &cborLength);
+
+    BENCH("CBOR decode stroke coordinates (100k points)", 2, 20) {
+        JSONVariant decoded = json_decode_buffer(cbor, cborLength);
+        free_json(decoded);
+    }
+
+    BENCH("CBOR encode stroke coordinates (100k points)", 2, 20) {
+        size_t length;
+        char* encoded = json_encode_cbor(strokes, &length);
+        BENCH_VOLATILE(encoded);
+        free(encoded);
+    }
+
+    free(cbor);
+    free_json(strokes);
+    free(json);
+}
+
+/// Toggles one flag in a stroke document: patching the text in place against a
+/// full decode, edit and re-encode.
+void bench_json_patch(void) {
+    char* json = bench_make_stroke_json(100000);
+    size_t length = strlen(json);
+    JSONVariant value = json_decode("99");
+    JSONPatch patch = json_patch_create();
+    json_patch_replace(patch, "/strokes/0/2", value);
+
+    BENCH("JSON Patch one value in place (100k points)", 2, 20) {
+        size_t patchedLength;
+        char* patched = json_patch_apply_buffer(patch, json, length, &patchedLength);
+        BENCH_VOLATILE(patched);
+        free(patched);
+    }
+
+    BENCH("JSON decode, patch, encode one value (100k points)", 2, 20) {
+        JSONVariant decoded = json_decode(json);
+        json_patch_apply(patch, decoded);
+        char* encoded = json_encode(decoded);
+        BENCH_VOLATILE(encoded);
+        free(encoded);
+        free_json(decoded);
+    }
+
+    json_patch_free(patch);
+    free_json(value);
+    free(json);
+}
+
+/// Decodes a run of small, same-shaped documents, the pattern of reading one
+/// config file per canvas; every key after the first document is interned.
+void bench_json_keys(void) {
+    enum { DOCUMENTS = 20000 };
+    char* documents[DOCUMENTS];
+    for (size_t i = 0; i < DOCUMENTS; ++i) {
+        documents[i] = (char*)malloc(256);
+        snprintf(documents[i], 256,
+                 "{\"name\":\"canvas-%zu\",\"created\":%zu,\"modified\":%zu,"
+                 "\"flags\":{\"is_Favorite\":%s,\"is_Locked\":false,\"is_Shared\":false},"
+                 "\"width\":1024,\"height\":768}",
+                 i, i * 7, i * 11, (i & 1) ? "true" : "false");
+    }
+
+    BENCH("JSON decode same-shaped documents (20k configs)", 2, 20) {
+        for (size_t i = 0; i < DOCUMENTS; ++i) {
+            JSONVariant decoded = json_decode(documents[i]);
+            free_json(decoded);
+        }
+    }
+
+    for (size_t i = 0; i < DOCUMENTS; ++i) {
+        free(documents[i]);
+    }
+}
+
+/// Re-imports a metadata export of 200k NDJSON records: one `json_decode` per
+/// line on the calling thread against the parallel batch decoder.
+void bench_json_lines(void) {
+    enum { RECORDS = 200000 };
+    size_t cap = (size_t)RECORDS * 96;
+    char* ndjson = (char*)malloc(cap);
+    size_t length = 0;
+    for (size_t i = 0; i < RECORDS; ++i) {
+        length += (size_t)snprintf(ndjson + length, cap - length,
+                                   "{\"id\":%zu,\"name\":\"canvas-%zu\",\"size\":%zu,\"is_Favorite\":%s}\n",
+                                   i, i, (size_t)(bench_hash64(i) & 0xfffff), (i & 1) ? "true" : "false");
+    }
+
+    BENCH("NDJSON decode line by line (200k records)", 2, 10) {
+        char* line = ndjson;
+        while (*line) {
+            char* newline = strchr(line, '\n');
+            *newline = '\0';
+            JSONVariant decoded = json_decode(line);
+            free_json(decoded);
+            *newline = '\n';
+            line = newline + 1;
+        }
+    }
+
+    BENCH("NDJSON decode in parallel (200k records)", 2, 10) {
+        JSONVariant decoded = json_decode_lines(ndjson, length);
+        free_json(decoded);
+    }
+
+    free(ndjson);
+}
+
+/// Round-trips 20k text-heavy metadata records (descriptions with quotes,
+/// tabs and newlines), the strings the encoder has to escape.
+void bench_json_strings(void) {
+    enum { RECORDS = 20000 };
+    size_t cap = (size_t)RECORDS * 320 + 16;
+    char* json = (char*)malloc(cap);
+    size_t length = (size_t)snprintf(json, cap, "[");
+    for (size_t i = 0; i < RECORDS; ++i) {
+        length += (size_t)snprintf(json + length, cap - length,
+                                   "%s{\"title\":\"Lecture notes %zu\",\"description\":\"Week %zu:\\t"
+                                   "\\\"Linear algebra\\\" \\u2013 eigenvalues, eigenvectors and the spectral theorem.\\n"
+                                   "See C:\\\\Notes\\\\Math for the worked examples and exercises.\"}",
+                                   i ? "," : "", i, i % 52);
+    }
+    snprintf(json + length, cap - length, "]");
+    JSONVariant records = json_decode(json);
+
+    BENCH("JSON decode escaped strings (20k records)", 2, 20) {
+        JSONVariant decoded = json_decode(json);
+        free_json(decoded);
+    }
+
+    BENCH("JSON encode escaped strings (20k records)", 2, 20) {
+        char* encoded = json_encode(records);
+        BENCH_VOLATILE(encoded);
+        free(encoded);
+    }
+
+    free_json(records);
+    free(json);
+}
+
+/// Appends a reference tree `depth` levels deep with `width` children per
+/// node, the shape of a canvas's nested image and text file references.
+static size_t bench_append_reference_tree(char* json, size_t cap, size_t length, int depth, int width) {
+    if (depth == 0) {
+        return length + (size_t)snprintf(json + length, cap - length,
+                                         "{\"path\":\"assets/image-%zu.png\",\"size\":[640,480]}", length);
+    }
+    length += (size_t)snprintf(json + length, cap - length, "{\"name\":\"group\",\"children\":[");
+    for (int i = 0; i < width; ++i) {
+        if (i) json[length++] = ',';
+        length = bench_append_reference_tree(json, cap, length, depth - 1, width);
+    }
+    return length + (size_t)snprintf(json + length, cap - length, "]}");
+}
+
+/// Decodes nested reference trees and reports the heap allocations per
+/// decode, which shows whether nested containers are copied as the recursion
+/// unwinds.
+void bench_json_nested(void) {
+    size_t cap = 8 * 1024 * 1024;
+    char* wide = (char*)malloc(cap);
+    bench_append_reference_tree(wide, cap, 0, 8, 3);
+    char* deep = (char*)malloc(cap);
+    bench_append_reference_tree(deep, cap, 0, 200, 1);
+
+    JSONVariant tree = json_decode(wide);
+    size_t cborLength = 0;
+    char* cbor = json_encode_cbor(tree, &cborLength);
+
+    size_t before = bench_allocations();
+    free_json(json_decode(wide));
+    printf("JSON decode reference tree (depth 8, 3 children): %zu allocations\n", bench_allocations() - before);
+
+    before = bench_allocations();
+    free_json(json_decode(deep));
+    printf("JSON decode reference chain (depth 200): %zu allocations\n", bench_allocations() - before);
+
+    before = bench_allocations();
+    free_json(json_decode_buffer(cbor, cborLength));
+    printf("CBOR decode reference tree (depth 8, 3 children): %zu allocations\n", bench_allocations() - before);
+
+    BENCH("JSON decode reference tree (depth 8, 3 children)", 2, 20) {
+        JSONVariant decoded = json_decode(wide);
+        free_json(decoded);
+    }
+
+    BENCH("CBOR decode reference tree (depth 8, 3 children)", 2, 20) {
+        JSONVariant decoded = json_decode_buffer(cbor, cborLength);
+        free_json(decoded);
+    }
+
+    free(cbor);
+    free_json(tree);
+    free(deep);
+    free(wide);
+}
+
+static int bench_count_item(const SFCXMLItem* item, void* context) {
+    *(size_t*)context += (size_t)item->width;
+    return 0;
+}
+
+/// Saves and reads a 100k-item canvas layout: one `writeItem` per item against
+/// the batched writer, and the streaming item reader against building and
+/// walking the full document tree.
+void bench_xml_items(void) {
+    enum { ITEMS = 100000 };
+    const char* path = "bench_canvas.xml";
+    static char ids[ITEMS][16];
+    SFCXMLItem* items = (SFCXMLItem*)malloc(ITEMS * sizeof(SFCXMLItem));
+    for (size_t i = 0; i < ITEMS; ++i) {
+        uint64_t h = bench_hash64(i);
+        snprintf(ids[i], sizeof(ids[i]), "item-%zu", i);
+        SFCXMLItem item = { ids[i], (i & 1) ? "image" : "text", (int)(h & 0xffff), (int)((h >> 16) & 0xffff),
+                            (int)((h >> 32) & 0x3ff), (int)((h >> 42) & 0x3ff), "notes/item.txt" };
+        items[i] = item;
+    }
+
+    BENCH("XML writeItem canvas items (100k items)", 2, 10) {
+        xmlTextWriterPtr writer = startXMLDocument(path);
+        xmlTextWriterStartElement(writer, (const xmlChar*)"canvas");
+        for (size_t i = 0; i < ITEMS; ++i) {
+            const SFCXMLItem* item = &items[i];
+            writeItem(writer, item->id, item->type, item->x, item->y, item->width, item->height, item->text);
+        }
+        endXMLDocument(writer);
+    }
+
+    BENCH("XML writeItemsToFile canvas items (100k items)", 2, 10) {
+        int result = writeItemsToFile(path, "canvas", items, ITEMS);
+        BENCH_VOLATILE(result);
+    }
+
+    BENCH("XML stream canvas items (100k items)", 2, 10) {
+        size_t total = 0;
+        parseXMLItems(path, bench_count_item, &total);
+        BENCH_VOLATILE(total);
+    }
+
+    BENCH("XML tree walk canvas items (100k items)", 2, 10) {
+        size_t total = 0;
+        xmlDoc* doc = xmlReadFile(path, NULL, 0);
+        for (xmlNode* node = xmlDocGetRootElement(doc)->children; node; node = node->next) {
+            total += node->type == XML_ELEMENT_NODE;
+        }
+        BENCH_VOLATILE(total);
+        xmlFreeDoc(doc);
+    }
+
+    remove(path);
+    free(items);
+}
+
 #endif //BCHSUITE_H
@@ -0,0 +1,573 @@
+//===-- Benchmarks/jsontests.cpp - JSON decode checks -----------*- C++ -*-===//
+//                                                                            //
+// This source file is part of the Scribble Foundation open source project    //
+//                                                                            //
+// Copyright (c) 2024 ScribbleLabApp. and the ScribbleLab project authors     //
+// Licensed under Apache License v2.0 with Runtime Library Exception          //
+//                                                                            //
+// You may not use this file except in compliance with the License.           //
+// You may obtain a copy of the License at                                    //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+// Unless required by applicable law or agreed to in writing, software        //
+// distributed under the License is distributed on an "AS IS" BASIS,          //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   //
+// See the License for the specific language governing permissions and        //
+// limitations under the License.                                             //
+//                                                                            //
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Decode checks for edge cases of the JSON codecs that the benchmark suites
+/// do not exercise, for each Base64 kernel the CPU can run, and for the XML,
+/// binary layout and R-tree formats of the canvas. Run through `ctest`; exits
+/// non-zero if any check fails.
+///
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+#include "SFCJSON.h"
+#include "SFCXML.h"
+#include "SFCxxBase64.h"
+#include "SFCxxCanvasIndex.h"
+#include "SFCxxCanvasLayout.h"
+#include "SFCxxJSON.h"
+#include "SFCxxJSONPatch.h"
+
+static int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition);\
+            ++failures;                                                         \
+        }                                                                       \
+    } while (0)
+
+static bool decodeFails(std::string_view json) {
+    try {
+        sfcxx::JSON::decode(json);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+static bool decodesTo(std::string_view json, double expected) {
+    sfcxx::JSONVariant value = sfcxx::JSON::decode(json);
+    const double* number = std::get_if<double>(&value);
+    return number && *number == expected && std::signbit(*number) == std::signbit(expected);
+}
+
+static bool documentLoads(std::string_view json) {
+    JSONDocument document = json_document_create();
+    int result = json_document_load(document, json.data(), json.size());
+    json_document_free(document);
+    return result == 0;
+}
+
+/// Applies `patch` to `json` as text and to its decoded value, and compares what the two decode to.
+static bool patchesAgree(std::string json, std::string_view patch) {
+    sfcxx::JSONPatch operations = sfcxx::JSONPatch::parse(patch);
+    sfcxx::JSONVariant document = sfcxx::JSON::decode(json);
+    operations.apply(document);
+    operations.apply(json);
+    return sfcxx::JSON::encode(sfcxx::JSON::decode(json)) == sfcxx::JSON::encode(document);
+}
+
+static bool mergesAgree(std::string json, std::string_view patch) {
+    sfcxx::JSONVariant merge = sfcxx::JSON::decode(patch);
+    sfcxx::JSONVariant document = sfcxx::JSON::decode(json);
+    sfcxx::JSONPatch::merge(document, merge);
+    sfcxx::JSONPatch::merge(json, merge);
+    return sfcxx::JSON::encode(sfcxx::JSON::decode(json)) == sfcxx::JSON::encode(document);
+}
+
+static void checkNumberRange(void) {
+    // Overflow would decode as an infinity the encoder cannot write back out.
+    CHECK(decodeFails("1e400"));
+    CHECK(decodeFails("-1e400"));
+    CHECK(decodeFails("[1.8e308]"));
+    CHECK(decodeFails("{\"x\":123456789012345678901234567890e300}"));
+    CHECK(!documentLoads("{\"x\":1e400}"));
+
+    // Underflow rounds to the nearest representable value.
+    CHECK(decodesTo("1e-400", 0.0));
+    CHECK(decodesTo("-1e-400", -0.0));
+    CHECK(decodesTo("4.9e-324", 4.9e-324));
+    CHECK(documentLoads("{\"x\":1e-400}"));
+
+    CHECK(decodesTo("1.7976931348623157e308", DBL_MAX));
+    CHECK(decodesTo("-1.7976931348623157e308", -DBL_MAX));
+}
+
+static void checkDocumentEscapes(void) {
+    // Escapes are unescaped lazily, so load must reject any the getters would.
+    CHECK(!documentLoads("{\"project\":{\"name\":\"a\\qb\"}}"));
+    CHECK(!documentLoads("{\"name\":\"\\u12\"}"));
+    CHECK(!documentLoads("{\"\\x\":1}"));
+
+    const char json[] = "{\"project\":{\"name\":\"a\\\"b\\u00e9\",\"scale\":2,\"locked\":true}}";
+    JSONDocument document = json_document_create();
+    CHECK(json_document_load(document, json, sizeof(json) - 1) == 0);
+
+    char name[16];
+    double scale = 0;
+    int locked = 0;
+    CHECK(json_document_get_string(document, "project.name", name, sizeof(name)) == 5);
+    CHECK(std::string_view(name) == "a\"b\xc3\xa9");
+    CHECK(json_document_get_number(document, "project.scale", &scale) == 0 && scale == 2);
+    CHECK(json_document_get_bool(document, "project.locked", &locked) == 0 && locked == 1);
+    CHECK(json_document_get_number(document, "project.name", &scale) == -1);
+
+    // A failed load leaves an empty document whose getters report a missing field.
+    CHECK(json_document_load(document, "{\"a\":\"\\q\"}", 10) == -1);
+    CHECK(json_document_get_string(document, "a", name, sizeof(name)) == -1);
+    json_document_free(document);
+}
+
+static void checkBuilderEscaping(void) {
+    // The builder and the encoder share one escaping routine.
+    const char text[] = "quote\" slash\\ tab\t nl\n bell\x07 del\x7f \xc3\xa9";
+    char storage[128];
+    JSONBuilder builder;
+    json_builder_init(&builder, storage, sizeof(storage), 0);
+    json_builder_string(&builder, text);
+    CHECK(json_builder_finish(&builder) >= 0);
+    CHECK(std::string_view(builder.data) == sfcxx::JSON::encode(sfcxx::JSONVariant(std::string(text))));
+    CHECK(std::string_view(builder.data) == "\"quote\\\" slash\\\\ tab\\t nl\\n bell\\u0007 del\x7f \xc3\xa9\"");
+}
+
+static void checkPatchModes(void) {
+    // Patching text must leave what patching the decoded document leaves.
+    const char json[] = "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":true}}";
+    CHECK(patchesAgree(json, "[{\"op\":\"add\",\"path\":\"/e\",\"value\":{\"f\":null}}]"));
+    CHECK(patchesAgree(json, "[{\"op\":\"add\",\"path\":\"/b/1\",\"value\":9},{\"op\":\"add\",\"path\":\"/b/-\",\"value\":8}]"));
+    CHECK(patchesAgree(json, "[{\"op\":\"remove\",\"path\":\"/a\"},{\"op\":\"remove\",\"path\":\"/b/2\"}]"));
+    CHECK(patchesAgree(json, "[{\"op\":\"replace\",\"path\":\"/c/d\",\"value\":\"x\"}]"));
+    CHECK(patchesAgree(json, "[{\"op\":\"move\",\"from\":\"/b/0\",\"path\":\"/c/g\"}]"));
+    CHECK(patchesAgree(json, "[{\"op\":\"copy\",\"from\":\"/c\",\"path\":\"/b/0\"}]"));
+    CHECK(mergesAgree(json, "{\"a\":null,\"c\":{\"d\":false,\"h\":[1]},\"i\":2}"));
+
+    // With duplicate keys, both modes address the last occurrence, which is the one decoding keeps.
+    CHECK(patchesAgree("{\"is_Favorite\":false,\"is_Favorite\":false}",
+                       "[{\"op\":\"replace\",\"path\":\"/is_Favorite\",\"value\":true}]"));
+    CHECK(patchesAgree("{\"a\":1,\"a\":2}", "[{\"op\":\"remove\",\"path\":\"/a\"}]"));
+    CHECK(patchesAgree("{\"a\":1,\"b\":2,\"a\":3,\"c\":4,\"a\":5}", "[{\"op\":\"remove\",\"path\":\"/a\"}]"));
+    CHECK(patchesAgree("{\"b\":0,\"a\":1,\"a\":2}", "[{\"op\":\"remove\",\"path\":\"/a\"}]"));
+    CHECK(patchesAgree("{\"a\":1,\"b\":0,\"a\":2}", "[{\"op\":\"add\",\"path\":\"/a\",\"value\":3}]"));
+    CHECK(patchesAgree("{\"a\":1,\"a\":2}", "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/b\"}]"));
+    CHECK(patchesAgree("{\"a\":1,\"a\":2}", "[{\"op\":\"copy\",\"from\":\"/a\",\"path\":\"/b\"}]"));
+    CHECK(mergesAgree("{\"a\":{\"x\":1},\"a\":{\"y\":2}}", "{\"a\":{\"z\":3}}"));
+    CHECK(mergesAgree("{\"a\":1,\"b\":2,\"a\":3}", "{\"a\":null}"));
+
+    std::string removed = "{\"a\":1,\"b\":2,\"a\":3}";
+    sfcxx::JSONPatch::parse("[{\"op\":\"remove\",\"path\":\"/a\"}]").apply(removed);
+    CHECK(removed == "{\"b\":2}");
+}
+
+static const sfcxx::Base64Variant kBase64Variants[] = {
+    sfcxx::Base64Variant::STANDARD,
+    sfcxx::Base64Variant::STANDARD_NO_PADDING,
+    sfcxx::Base64Variant::URL_SAFE,
+    sfcxx::Base64Variant::URL_SAFE_NO_PADDING,
+};
+
+/// Encodes one group at a time, as RFC 4648 describes it, to check the vector kernels against.
+static std::string base64Reference(const std::vector<unsigned char>& data, sfcxx::Base64Variant variant) {
+    bool urlSafe = variant == sfcxx::Base64Variant::URL_SAFE || variant == sfcxx::Base64Variant::URL_SAFE_NO_PADDING;
+    bool padded = variant == sfcxx::Base64Variant::STANDARD || variant == sfcxx::Base64Variant::URL_SAFE;
+    const char* alphabet = urlSafe ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+                                   : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+    for (size_t i = 0; i < data.size(); i += 3) {
+        size_t count = std::min<size_t>(3, data.size() - i);
+        unsigned group = data[i] << 16 | (count > 1 ? data[i + 1] << 8 : 0) | (count > 2 ? data[i + 2] : 0);
+        for (size_t j = 0; j < 4; ++j) {
+            if (j <= count) {
+                text += alphabet[group >> (18 - 6 * j) & 0x3f];
+            } else if (padded) {
+                text += '=';
+            }
+        }
+    }
+    return text;
+}
+
+static std::vector<unsigned char> base64TestData(size_t length) {
+    std::vector<unsigned char> data(length);
+    unsigned state = 12345;
+    for (unsigned char& byte : data) {
+        state = state * 1103515245 + 12345;
+        byte = static_cast<unsigned char>(state >> 16);
+    }
+    return data;
+}
+
+static std::string base64Encode(std::string_view bytes, sfcxx::Base64Variant variant) {
+    return sfcxx::base64_encode(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), variant);
+}
+
+static void checkBase64Vectors(void) {
+    using sfcxx::Base64Variant;
+
+    // RFC 4648, section 10, and the two characters where the alphabets differ.
+    const char* const vectors[][2] = {
+        {"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"},
+        {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"},
+    };
+    for (const auto& vector : vectors) {
+        std::string padded = vector[1];
+        std::string unpadded = padded.substr(0, padded.find('='));
+        CHECK(base64Encode(vector[0], Base64Variant::STANDARD) == padded);
+        CHECK(base64Encode(vector[0], Base64Variant::STANDARD_NO_PADDING) == unpadded);
+        CHECK(base64Encode(vector[0], Base64Variant::URL_SAFE) == padded);
+        CHECK(base64Encode(vector[0], Base64Variant::URL_SAFE_NO_PADDING) == unpadded);
+    }
+    CHECK(base64Encode("\xfb\xff\xbf\xfb\xf0", Base64Variant::STANDARD) == "+/+/+/A=");
+    CHECK(base64Encode("\xfb\xff\xbf\xfb\xf0", Base64Variant::STANDARD_NO_PADDING) == "+/+/+/A");
+    CHECK(base64Encode("\xfb\xff\xbf\xfb\xf0", Base64Variant::URL_SAFE) == "-_-_-_A=");
+    CHECK(base64Encode("\xfb\xff\xbf\xfb\xf0", Base64Variant::URL_SAFE_NO_PADDING) == "-_-_-_A");
+}
+
+static void checkBase64RoundTrip(sfcxx::Base64Variant variant) {
+    // Lengths around every block size the kernels use, and one long enough for their main loops.
+    std::vector<unsigned char> data = base64TestData(1000);
+    for (size_t length = 0; length <= 1000; length += length < 200 ? 1 : 400) {
+        std::vector<unsigned char> input(data.begin(), data.begin() + length);
+        std::string text = sfcxx::base64_encode(input.data(), input.size(), variant);
+        CHECK(text == base64Reference(input, variant));
+        CHECK(text.size() == sfcxx::base64_encoded_size(length, variant));
+        CHECK(sfcxx::base64_decode(text, variant) == input);
+
+        std::vector<unsigned char> decoded(sfcxx::base64_decoded_size(text.data(), text.size()));
+        CHECK(decoded.size() >= length);
+        decoded.resize(sfcxx::base64_decode_into(text.data(), text.size(), decoded.data(), decoded.size(), variant));
+        CHECK(decoded == input);
+    }
+}
+
+static void checkBase64Chunks(sfcxx::Base64Variant variant) {
+    // Pieces of every size up to 17, so partial groups are carried across calls at each offset.
+    std::vector<unsigned char> data = base64TestData(700);
+    std::string expected = base64Reference(data, variant);
+
+    sfcxx::Base64Encoder encoder(variant);
+    std::string text;
+    char out[sfcxx::Base64Encoder::maxOutput(17)];
+    for (size_t pos = 0, piece = 1; pos < data.size(); pos += piece, piece = piece % 17 + 1) {
+        size_t length = std::min(piece, data.size() - pos);
+        text.append(out, encoder.update(data.data() + pos, length, out));
+    }
+    text.append(out, encoder.finish(out));
+    CHECK(text == expected);
+
+    for (bool sized : {false, true}) {
+        sfcxx::Base64Decoder decoder(variant);
+        std::vector<unsigned char> decoded;
+        unsigned char bytes[sfcxx::Base64Decoder::maxOutput(17)];
+        for (size_t pos = 0, piece = 1; pos < text.size(); pos += piece, piece = piece % 17 + 1) {
+            size_t length = std::min(piece, text.size() - pos);
+            size_t n = sized ? decoder.update(text.data() + pos, length, bytes, sizeof(bytes))
+                             : decoder.update(text.data() + pos, length, bytes);
+            decoded.insert(decoded.end(), bytes, bytes + n);
+        }
+        size_t n = decoder.finish(bytes);
+        decoded.insert(decoded.end(), bytes, bytes + n);
+        CHECK(decoded == data);
+    }
+}
+
+static void checkBase64Stop(sfcxx::Base64Variant variant) {
+    // A character of the other alphabet ends the input just as the end of the text would.
+    bool urlSafe = variant == sfcxx::Base64Variant::URL_SAFE || variant == sfcxx::Base64Variant::URL_SAFE_NO_PADDING;
+    std::string text = base64Reference(base64TestData(300), variant);
+    for (size_t stop = 0; stop < text.size(); ++stop) {
+        std::string corrupted = text;
+        corrupted[stop] = urlSafe ? '+' : '_';
+        std::vector<unsigned char> expected = sfcxx::base64_decode(text.substr(0, stop), variant);
+        CHECK(sfcxx::base64_decode(corrupted, variant) == expected);
+
+        sfcxx::Base64Decoder decoder(variant);
+        std::vector<unsigned char> decoded(sfcxx::Base64Decoder::maxOutput(corrupted.size()) + 2);
+        size_t n = decoder.update(corrupted.data(), corrupted.size(), decoded.data());
+        CHECK(decoder.stopped());
+        n += decoder.finish(decoded.data() + n);
+        decoded.resize(n);
+        CHECK(decoded == expected);
+    }
+}
+
+static void checkBase64(void) {
+    checkBase64Vectors();
+    for (const char* kernel : {"avx2", "ssse3", "neon", "scalar"}) {
+        if (!sfcxx::base64_select_kernel(kernel)) continue;
+        for (sfcxx::Base64Variant variant : kBase64Variants) {
+            checkBase64RoundTrip(variant);
+            checkBase64Chunks(variant);
+            checkBase64Stop(variant);
+        }
+    }
+}
+
+/// Items with text that needs escaping, non-ASCII text, empty and NULL strings, and extreme coordinates.
+static std::vector<SFCXMLItem> canvasTestItems(size_t count, bool withNull) {
+    static const char* const types[] = {"sticky", "a&b <c> \"d\" 'e'", "caf\xc3\xa9", ""};
+    static std::vector<std::string> ids;
+    ids.resize(std::max(ids.size(), count));
+    std::vector<SFCXMLItem> items(count);
+    unsigned state = 1;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 1103515245 + 12345;
+        ids[i] = "item-" + std::to_string(i);
+        int coordinate = static_cast<int>(state >> 8) % 20000 - 10000;
+        items[i] = SFCXMLItem{ids[i].c_str(), types[i % 4], coordinate, -coordinate,
+                              static_cast<int>(i % 300) - 100, static_cast<int>(state % 500),
+                              withNull && i % 5 == 0 ? nullptr : "notes/text.md"};
+    }
+    if (count > 2) {
+        items[1].x = INT_MIN;
+        items[1].width = INT_MAX;
+        items[2].id = withNull ? nullptr : "";
+    }
+    return items;
+}
+
+static std::string temporaryDirectory(void) {
+    char path[] = "/tmp/scribble_tests_XXXXXX";
+    return mkdtemp(path) != nullptr ? path : "/tmp";
+}
+
+static bool sameItem(const SFCXMLItem& a, const SFCXMLItem& b) {
+    auto sameString = [](const char* x, const char* y) { return x == y || (x && y && std::strcmp(x, y) == 0); };
+    return sameString(a.id, b.id) && sameString(a.type, b.type) && sameString(a.text, b.text) &&
+           a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+static std::string writtenDocument(bool batched, const std::vector<SFCXMLItem>& items) {
+    xmlBufferPtr buffer = xmlBufferCreate();
+    xmlTextWriterPtr writer = xmlNewTextWriterMemory(buffer, 0);
+    xmlTextWriterStartDocument(writer, nullptr, "UTF-8", nullptr);
+    xmlTextWriterStartElement(writer, reinterpret_cast<const xmlChar*>("canvas"));
+    if (batched) {
+        CHECK(writeItems(writer, items.data(), items.size()) == 0);
+    } else {
+        // The element-by-element writer that `writeItems` replaced.
+        char number[16];
+        for (const SFCXMLItem& item : items) {
+            xmlTextWriterStartElement(writer, reinterpret_cast<const xmlChar*>("item"));
+            writeElement(writer, "id", item.id);
+            writeElement(writer, "type", item.type);
+            xmlTextWriterStartElement(writer, reinterpret_cast<const xmlChar*>("position"));
+            std::snprintf(number, sizeof(number), "%d", item.x);
+            writeElement(writer, "x", number);
+            std::snprintf(number, sizeof(number), "%d", item.y);
+            writeElement(writer, "y", number);
+            xmlTextWriterEndElement(writer);
+            xmlTextWriterStartElement(writer, reinterpret_cast<const xmlChar*>("size"));
+            std::snprintf(number, sizeof(number), "%d", item.width);
+            writeElement(writer, "width", number);
+            std::snprintf(number, sizeof(number), "%d", item.height);
+            writeElement(writer, "height", number);
+            xmlTextWriterEndElement(writer);
+            writeElement(writer, "text", item.text);
+            xmlTextWriterEndElement(writer);
+        }
+    }
+    xmlTextWriterEndDocument(writer);
+    xmlFreeTextWriter(writer);
+    std::string document(reinterpret_cast<const char*>(xmlBufferContent(buffer)), xmlBufferLength(buffer));
+    xmlBufferFree(buffer);
+    return document;
+}
+
+static void checkItemWriters(void) {
+    // Enough items to span several of the 64 KiB chunks `writeItems` formats into.
+    std::vector<SFCXMLItem> items = canvasTestItems(2000, true);
+    std::string expected = writtenDocument(false, items);
+    CHECK(writtenDocument(true, items) == expected);
+
+    std::string buffer(writeItemsToBuffer("canvas", items.data(), items.size(), nullptr, 0), '\0');
+    CHECK(writeItemsToBuffer("canvas", items.data(), items.size(), &buffer[0], buffer.size()) == buffer.size());
+    CHECK(buffer == expected);
+    CHECK(writtenDocument(true, {}) == writtenDocument(false, {}));
+}
+
+/// Copies an encoded layout to `offset` bytes into 8-byte aligned storage and views it there.
+static bool layoutViews(const std::vector<unsigned char>& bytes, size_t length, size_t offset = 0) {
+    std::vector<uint64_t> storage((length + offset) / 8 + 1);
+    unsigned char* data = reinterpret_cast<unsigned char*>(storage.data()) + offset;
+    std::memcpy(data, bytes.data(), length);
+    try {
+        sfcxx::CanvasLayout::view(data, length);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    return true;
+}
+
+static void checkCanvasLayout(const std::string& directory) {
+    std::vector<SFCXMLItem> items = canvasTestItems(300, true);
+    std::vector<unsigned char> bytes = sfcxx::CanvasLayout::encode(items.data(), items.size());
+    sfcxx::CanvasLayout layout = sfcxx::CanvasLayout::view(bytes.data(), bytes.size());
+    CHECK(layout.size() == items.size());
+    bool same = true;
+    for (size_t i = 0; i < items.size(); ++i) {
+        same = same && sameItem(layout.item(i), items[i]);
+    }
+    CHECK(same);
+    std::vector<unsigned char> empty = sfcxx::CanvasLayout::encode(nullptr, 0);
+    CHECK(sfcxx::CanvasLayout::view(empty.data(), empty.size()).empty());
+
+    // Every truncation, a trailing byte, a misaligned buffer and corrupted header fields are rejected.
+    CHECK(layoutViews(bytes, bytes.size()));
+    bool rejected = true;
+    for (size_t length = 0; length < bytes.size(); ++length) {
+        rejected = rejected && !layoutViews(bytes, length);
+    }
+    CHECK(rejected);
+    std::vector<unsigned char> longer = bytes;
+    longer.push_back(0);
+    CHECK(!layoutViews(longer, longer.size()));
+    CHECK(!layoutViews(bytes, bytes.size(), 1));
+    for (size_t field : {0, 4, 8, 16, 24}) {                                // Magic, version, count, string table size, first section
+        std::vector<unsigned char> corrupted = bytes;
+        corrupted[field] ^= 0x40;
+        CHECK(!layoutViews(corrupted, corrupted.size()));
+    }
+
+    // A string offset past the table, and a table without its final NUL.
+    uint64_t idsOffset;
+    std::memcpy(&idsOffset, bytes.data() + 24, sizeof(idsOffset));
+    std::vector<unsigned char> corrupted = bytes;
+    std::memset(corrupted.data() + idsOffset, 0x7f, 4);
+    CHECK(!layoutViews(corrupted, corrupted.size()));
+    corrupted = bytes;
+    corrupted.back() = 'x';
+    CHECK(!layoutViews(corrupted, corrupted.size()));
+
+    // XML to layout and back is lossless for items without NULL strings, which XML cannot tell from empty ones.
+    items = canvasTestItems(3000, false);
+    std::string xmlFile = directory + "/canvas.xml";
+    std::string layoutFile = directory + "/canvas.sfcl";
+    std::string copyFile = directory + "/copy.xml";
+    CHECK(writeItemsToFile(xmlFile.c_str(), "canvas", items.data(), items.size()) == 0);
+    CHECK(sfcxx::CanvasLayout::convertFromXML(xmlFile, layoutFile) == items.size());
+    sfcxx::CanvasLayout opened = sfcxx::CanvasLayout::open(layoutFile);
+    same = opened.size() == items.size();
+    for (size_t i = 0; same && i < items.size(); ++i) {
+        same = sameItem(opened.item(i), items[i]);
+    }
+    CHECK(same);
+    opened.writeXML(copyFile);
+    CHECK(sfcxx::read_image_file(copyFile) == sfcxx::read_image_file(xmlFile));
+
+    for (const std::string& file : {xmlFile, layoutFile, copyFile}) {
+        unlink(file.c_str());
+    }
+}
+
+static std::vector<uint32_t> sortedQuery(const sfcxx::CanvasIndex& index, const sfcxx::CanvasRect& viewport) {
+    std::vector<uint32_t> found = index.query(viewport);
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+static void checkCanvasIndex(const std::string& directory) {
+    // Sizes around the node capacity, so partly filled nodes and levels are covered.
+    for (size_t count : {0, 1, 16, 17, 256, 257, 5000}) {
+        std::vector<sfcxx::CanvasRect> rects(count);
+        unsigned state = static_cast<unsigned>(count);
+        auto next = [&](int range) {
+            state = state * 1103515245 + 12345;
+            return static_cast<int>((state >> 8) % (2 * range + 1)) - range;
+        };
+        for (sfcxx::CanvasRect& rect : rects) {
+            rect = {next(5000), next(5000), next(300), next(300)};
+        }
+        sfcxx::CanvasIndex index = sfcxx::CanvasIndex::build(rects.data(), rects.size());
+        std::vector<unsigned char> bytes = index.serialize();
+        sfcxx::CanvasIndex restored = sfcxx::CanvasIndex::deserialize(bytes.data(), bytes.size());
+        CHECK(restored.size() == count);
+
+        bool matches = true;
+        for (int i = 0; i < 200; ++i) {
+            sfcxx::CanvasRect viewport = {next(6000), next(6000), next(i % 2 ? 2000 : 0), next(2000)};
+            std::vector<uint32_t> expected;
+            auto lo = [](int origin, int extent) { return std::min<long long>(origin, static_cast<long long>(origin) + extent); };
+            auto hi = [](int origin, int extent) { return std::max<long long>(origin, static_cast<long long>(origin) + extent); };
+            for (uint32_t j = 0; j < count; ++j) {
+                const sfcxx::CanvasRect& r = rects[j];
+                if (lo(r.x, r.width) <= hi(viewport.x, viewport.width) && lo(viewport.x, viewport.width) <= hi(r.x, r.width) &&
+                    lo(r.y, r.height) <= hi(viewport.y, viewport.height) && lo(viewport.y, viewport.height) <= hi(r.y, r.height)) {
+                    expected.push_back(j);
+                }
+            }
+            matches = matches && sortedQuery(index, viewport) == expected && sortedQuery(restored, viewport) == expected;
+        }
+        CHECK(matches);
+
+        if (count == 257) {
+            bool rejected = true;
+            for (size_t length = 0; length < bytes.size(); ++length) {
+                try {
+                    sfcxx::CanvasIndex::deserialize(bytes.data(), length);
+                    rejected = false;
+                } catch (const std::runtime_error&) {
+                }
+            }
+            CHECK(rejected);
+            std::vector<unsigned char> corrupted = bytes;
+            corrupted.back() ^= 1;                                          // The root's pointer to its children
+            bool threw = false;
+            try {
+                sfcxx::CanvasIndex::deserialize(corrupted.data(), corrupted.size());
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+            CHECK(threw);
+
+            std::string file = directory + "/canvas.index";
+            index.save(file);
+            CHECK(sortedQuery(sfcxx::CanvasIndex::load(file), {-6000, -6000, 12000, 12000}).size() == count);
+            unlink(file.c_str());
+        }
+    }
+}
+
+static void checkCanvas(void) {
+    std::string directory = temporaryDirectory();
+    checkItemWriters();
+    checkCanvasLayout(directory);
+    checkCanvasIndex(directory);
+    rmdir(directory.c_str());
+}
+
+int main(void) {
+    checkNumberRange();
+    checkDocumentEscapes();
+    checkBuilderEscaping();
+    checkPatchModes();
+    checkBase64();
+    checkCanvas();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("All JSON checks passed\n");
+    return 0;
+}
@@ -38,6 +38,13 @@ int main(void) {
 
     // Add benchmark test functions here
     test();
+    bench_json_numbers();
+    bench_json_patch();
+    bench_json_keys();
+    bench_json_lines();
+    bench_json_strings();
+    bench_json_nested();
+    bench_xml_items();
 
     bench_done();
     bench_free();